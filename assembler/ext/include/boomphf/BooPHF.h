@@ -430,12 +430,12 @@ class bitVector {
 
   public:
 
-    bitVector() : _size(0)
+    bitVector() : _size(0), _mapped_ranks(nullptr), _nmapped_ranks(0)
     {
         _bitArray = nullptr;
     }
 
-    bitVector(uint64_t n) : _size(n)
+    bitVector(uint64_t n) : _size(n), _mapped_ranks(nullptr), _nmapped_ranks(0)
     {
         _nchar  = (1ULL+n/64ULL);
         _bitArray =  (uint64_t *) calloc (_nchar,sizeof(uint64_t));
@@ -443,16 +443,15 @@ class bitVector {
 
     ~bitVector()
     {
-        if(_bitArray != nullptr)
-            free(_bitArray);
+        release();
     }
 
-    //copy constructor
-    bitVector(bitVector const &r)
+    //copy constructor, mapped vectors are copied into owned memory
+    bitVector(bitVector const &r) : _mapped_ranks(nullptr), _nmapped_ranks(0)
     {
         _size =  r._size;
         _nchar = r._nchar;
-        _ranks = r._ranks;
+        _ranks = r.ranks_copy();
         _bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
         memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
     }
@@ -462,11 +461,11 @@ class bitVector {
     {
         if (&r != this)
         {
+            std::vector<uint64_t> ranks = r.ranks_copy();
+            release();
             _size =  r._size;
             _nchar = r._nchar;
-            _ranks = r._ranks;
-            if(_bitArray != nullptr)
-                free(_bitArray);
+            _ranks = std::move(ranks);
             _bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
             memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
         }
@@ -479,19 +478,22 @@ class bitVector {
         //printf("bitVector move assignment \n");
         if (&r != this)
         {
-            if(_bitArray != nullptr)
-                free(_bitArray);
+            release();
 
             _size =  std::move (r._size);
             _nchar = std::move (r._nchar);
             _ranks = std::move (r._ranks);
             _bitArray = r._bitArray;
+            _mapped_ranks = r._mapped_ranks;
+            _nmapped_ranks = r._nmapped_ranks;
             r._bitArray = nullptr;
+            r._mapped_ranks = nullptr;
+            r._nmapped_ranks = 0;
         }
         return *this;
     }
     // Move constructor
-    bitVector(bitVector &&r) : _bitArray ( nullptr),_size(0)
+    bitVector(bitVector &&r) : _bitArray ( nullptr),_size(0), _mapped_ranks(nullptr), _nmapped_ranks(0)
     {
         *this = std::move(r);
     }
@@ -510,7 +512,9 @@ class bitVector {
         return _size;
     }
 
-    uint64_t bitSize() const {return (_nchar*64ULL + _ranks.capacity()*64ULL );}
+    uint64_t bitSize() const {return (_nchar*64ULL + (_mapped_ranks ? _nmapped_ranks : _ranks.capacity())*64ULL );}
+
+    bool mapped() const { return _mapped_ranks != nullptr; }
 
     //clear whole array
     void clear()
@@ -584,6 +588,14 @@ class bitVector {
         return _bitArray[cell64];
     }
 
+    // prefetches the data touched by get(pos) and rank(pos)
+    void prefetch(uint64_t pos) const {
+        uint64_t block = pos / _nb_bits_per_rank_sample;
+        __builtin_prefetch(_bitArray + block * _nb_bits_per_rank_sample / 64);
+        __builtin_prefetch(_bitArray + pos / 64ULL);
+        __builtin_prefetch((_mapped_ranks ? _mapped_ranks : _ranks.data()) + block);
+    }
+
     //set bit pos to 1
     void set(uint64_t pos) {
         assert(pos<_size);
@@ -617,7 +629,7 @@ class bitVector {
         uint64_t word_idx = pos / 64ULL;
         uint64_t word_offset = pos % 64;
         uint64_t block = pos / _nb_bits_per_rank_sample;
-        uint64_t r = _ranks[block];
+        uint64_t r = _mapped_ranks ? _mapped_ranks[block] : _ranks[block];
         for (uint64_t w = block * _nb_bits_per_rank_sample / 64; w < word_idx; ++w)
             r += popcount_64(_bitArray[w]);
         uint64_t mask = (uint64_t(1) << word_offset ) - 1;
@@ -649,6 +661,31 @@ class bitVector {
         is.read(reinterpret_cast<char*>(_ranks.data()), (std::streamsize)(sizeof(_ranks[0]) * _ranks.size()));
     }
 
+    // Same layout as save(), all fields are 64-bit so the data stays aligned
+    void save_mapped(std::ostream& os) const {
+        std::vector<uint64_t> ranks = ranks_copy();
+        uint64_t sizer = ranks.size();
+        os.write(reinterpret_cast<char const*>(&_size), sizeof(_size));
+        os.write(reinterpret_cast<char const*>(&_nchar), sizeof(_nchar));
+        os.write(reinterpret_cast<char const*>(_bitArray), (std::streamsize)(sizeof(uint64_t) * _nchar));
+        os.write(reinterpret_cast<char const*>(&sizer), sizeof(sizer));
+        os.write(reinterpret_cast<char const*>(ranks.data()), (std::streamsize)(sizeof(uint64_t) * sizer));
+    }
+
+    // Attaches to the data written by save_mapped() without copying it. The memory is
+    // never written and should outlive the vector. Returns the end of the vector data.
+    const uint64_t *map(const uint64_t *data) {
+        release();
+        _size = *data++;
+        _nchar = *data++;
+        _bitArray = const_cast<uint64_t*>(data);
+        data += _nchar;
+        _nmapped_ranks = *data++;
+        _mapped_ranks = data;
+        _ranks.clear();
+        return data + _nmapped_ranks;
+    }
+
 
   protected:
     uint64_t*  _bitArray;
@@ -660,6 +697,24 @@ class bitVector {
     // additional size for rank is epsilon * _size
     static const uint64_t _nb_bits_per_rank_sample = 512; //512 seems ok
     std::vector<uint64_t> _ranks;
+
+    // set when the vector is attached to external memory via map()
+    const uint64_t *_mapped_ranks;
+    uint64_t _nmapped_ranks;
+
+    std::vector<uint64_t> ranks_copy() const {
+        if (_mapped_ranks)
+            return std::vector<uint64_t>(_mapped_ranks, _mapped_ranks + _nmapped_ranks);
+        return _ranks;
+    }
+
+    void release() {
+        if (_bitArray != nullptr && !_mapped_ranks)
+            free(_bitArray);
+        _bitArray = nullptr;
+        _mapped_ranks = nullptr;
+        _nmapped_ranks = 0;
+    }
 };
 
 ////////////////////////////////////////////////////////////////
@@ -686,6 +741,10 @@ class level{
         return bitset.get(hashi);
     }
 
+    void prefetch(uint64_t hash_raw) const {
+        bitset.prefetch(fastrange64(hash_raw,hash_domain));
+    }
+
     uint64_t idx_begin;
     uint64_t hash_domain;
     bitVector bitset;
@@ -806,14 +865,27 @@ class mphf {
 
     template<class elem_t>
     uint64_t lookup(elem_t elem) {
+        return lookup_hash(_hasher.hashpair128(elem));
+    }
+
+    // First half of lookup() for batched queries: hashes the element and
+    // prefetches its first level bits. The hash is resolved by lookup_hash().
+    template<class elem_t>
+    hash_pair_t prefetch(const elem_t &elem) const {
+        hash_pair_t bbhash = _hasher.hashpair128(elem);
+        if (_built && _nb_levels > 1)
+            _levels[0].prefetch(bbhash[0]);
+        return bbhash;
+    }
+
+    uint64_t lookup_hash(const hash_pair_t &bbhash) const {
         if (!_built) return ULLONG_MAX;
 
-        //auto hashes = _hasher(elem);
         uint64_t non_minimal_hp,minimal_hp;
         int level;
 
-        hash_pair_t bbhash = _hasher.hashpair128(elem);
-        uint64_t level_hash = getLevel(bbhash, elem, &level);
+        hash_pair_t level_state = bbhash;
+        uint64_t level_hash = getLevel(level_state, &level);
 
         if (level == (_nb_levels-1)) {
             //auto in_final_map  = _final_hash.find (elem);
@@ -1071,19 +1143,7 @@ class mphf {
 
 
 
-        //mini setup, recompute size of each level
-        _proba_collision = 1.0 -  pow(((_gamma*(double)_nelem -1 ) / (_gamma*(double)_nelem)),_nelem-1);
-        uint64_t previous_idx =0;
-        _hash_domain = (size_t)  (ceil(double(_nelem) * _gamma)) ;
-        for(int ii=0; ii<_nb_levels; ii++)
-        {
-            //_levels[ii] = new level();
-            _levels[ii].idx_begin = previous_idx;
-            _levels[ii].hash_domain =  (( (uint64_t) (_hash_domain * pow(_proba_collision,ii)) + 63) / 64 ) * 64;
-            if(_levels[ii].hash_domain == 0 )
-                _levels[ii].hash_domain  = 64 ;
-            previous_idx += _levels[ii].hash_domain;
-        }
+        restore_levels();
 
         //restore final hash
 
@@ -1105,9 +1165,72 @@ class mphf {
         _built = true;
     }
 
+    // Same content as save(), but every field is 64-bit wide so that the level
+    // bitsets can be used in-place by map()
+    void save_mapped(std::ostream& os) const {
+        uint64_t nb_levels = _nb_levels;
+        os.write(reinterpret_cast<char const*>(&_gamma), sizeof(_gamma));
+        os.write(reinterpret_cast<char const*>(&nb_levels), sizeof(nb_levels));
+        os.write(reinterpret_cast<char const*>(&_lastbitsetrank), sizeof(_lastbitsetrank));
+        os.write(reinterpret_cast<char const*>(&_nelem), sizeof(_nelem));
+        for(int ii=0; ii<_nb_levels; ii++)
+            _levels[ii].bitset.save_mapped(os);
+
+        uint64_t final_hash_size = _final_hash.size();
+        os.write(reinterpret_cast<char const*>(&final_hash_size), sizeof(final_hash_size));
+        for (auto it = _final_hash.begin(); it != _final_hash.end(); ++it ) {
+            os.write(reinterpret_cast<char const*>(&(it->first)), sizeof(internal_hash_t));
+            os.write(reinterpret_cast<char const*>(&(it->second)), sizeof(uint64_t));
+        }
+    }
+
+    // Attaches the level bitsets to the data written by save_mapped(). The final
+    // hash is small and is copied. Returns the end of the mphf data.
+    const uint64_t *map(const uint64_t *data) {
+        static_assert(sizeof(internal_hash_t) % sizeof(uint64_t) == 0, "misaligned final hash keys");
+
+        memcpy(&_gamma, data++, sizeof(_gamma));
+        _nb_levels = (int) *data++;
+        _lastbitsetrank = *data++;
+        _nelem = *data++;
+
+        _levels.resize(_nb_levels);
+        for(int ii=0; ii<_nb_levels; ii++)
+            data = _levels[ii].bitset.map(data);
+
+        restore_levels();
+
+        _final_hash.clear();
+        uint64_t final_hash_size = *data++;
+        for (uint64_t ii = 0; ii < final_hash_size; ++ii) {
+            internal_hash_t key;
+            memcpy(&key, data, sizeof(internal_hash_t));
+            data += sizeof(internal_hash_t) / sizeof(uint64_t);
+            _final_hash[key] = *data++;
+        }
+        _built = true;
+
+        return data;
+    }
+
 
   private :
 
+    //mini setup, recompute size of each level
+    void restore_levels() {
+        _proba_collision = 1.0 -  pow(((_gamma*(double)_nelem -1 ) / (_gamma*(double)_nelem)),_nelem-1);
+        uint64_t previous_idx =0;
+        _hash_domain = (size_t)  (ceil(double(_nelem) * _gamma)) ;
+        for(int ii=0; ii<_nb_levels; ii++)
+        {
+            _levels[ii].idx_begin = previous_idx;
+            _levels[ii].hash_domain =  (( (uint64_t) (_hash_domain * pow(_proba_collision,ii)) + 63) / 64 ) * 64;
+            if(_levels[ii].hash_domain == 0 )
+                _levels[ii].hash_domain  = 64 ;
+            previous_idx += _levels[ii].hash_domain;
+        }
+    }
+
     void setup()
     {
         pthread_mutex_init(&_mutex, NULL);
@@ -111,6 +111,13 @@ public:
     virtual void HandleSplit(EdgeId /*old_edge*/, EdgeId /*new_edge_1*/,
                              EdgeId /*new_edge_2*/) { }
 
+    /**
+     * Event which is triggered at the boundaries of graph processing algorithms. Handlers may
+     * buffer the events and process them in batches, in this case all the buffered events should
+     * be processed here. Handlers should not be queried between the buffered event and the flush.
+     */
+    virtual void HandleFlush() { }
+
     /**
      * Every thread safe descendant should override this method for correct concurrent graph processing.
      */
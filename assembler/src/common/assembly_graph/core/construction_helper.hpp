@@ -58,11 +58,7 @@ public:
     }
 
     void DeleteUnlinkedEdge(EdgeId e) {
-        EdgeId rc = graph_.conjugate(e);
-        if (e != rc) {
-            delete rc.get();
-        }
-        delete e.get();
+        graph_.DestroyEdge(e);
     }
 
     VertexId CreateVertex(const VertexData &data) {
@@ -75,6 +71,11 @@ public:
 
     template<class Iter>
     void AddVerticesToGraph(Iter begin, Iter end) {
+        // The distributor max may be far beyond the actual ids (e.g. for old saves)
+        size_t max_id = 0;
+        for (Iter it = begin; it != end; ++it)
+            max_id = std::max(max_id, std::max(it->int_id(), graph_.conjugate(*it).int_id()));
+        graph_.vertices_.reserve(max_id + 1);
         for(; begin != end; ++begin) {
             graph_.AddVertexToGraph(*begin);
         }
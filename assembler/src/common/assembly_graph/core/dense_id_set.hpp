@@ -0,0 +1,152 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace omnigraph {
+
+/*
+ * Set of graph elements (pure_pointers) stored in a vector indexed by their
+ * int ids. Removed elements leave tombstones (null ids) behind, so insertion
+ * and removal are O(1) and the iteration order is the order of ids.
+ *
+ * Iterators keep a position, not an element, and are never invalidated by
+ * insertions or removals: an iterator pointing to a removed element moves on
+ * to the next element with greater id (same as lower_bound does in
+ * btree::safe_btree_set, which was used before), end() stays the end.
+ */
+template<class T>
+class DenseIdSet {
+    std::vector<T> slots_;
+    size_t size_;
+
+    static const size_t npos = std::numeric_limits<size_t>::max();
+
+    // First occupied position not less than pos
+    size_t Skip(size_t pos) const {
+        while (pos < slots_.size() && slots_[pos].int_id() == 0)
+            ++pos;
+        return pos < slots_.size() ? pos : npos;
+    }
+
+public:
+    typedef T value_type;
+    typedef T key_type;
+
+    class const_iterator : public std::iterator<std::forward_iterator_tag, T,
+                                                ptrdiff_t, const T*, const T&> {
+        const DenseIdSet *set_;
+        size_t pos_;
+
+        friend class DenseIdSet;
+
+        const_iterator(const DenseIdSet *set, size_t pos)
+                : set_(set), pos_(pos) {}
+
+        // Iterators may be shared between threads, so the position is not
+        // updated in const methods
+        size_t pos() const {
+            return pos_ == npos ? npos : set_->Skip(pos_);
+        }
+
+    public:
+        const_iterator()
+                : set_(nullptr), pos_(npos) {}
+
+        const T &operator*() const {
+            size_t p = pos();
+            VERIFY(p != npos);
+            return set_->slots_[p];
+        }
+
+        const T *operator->() const {
+            return &operator*();
+        }
+
+        const_iterator &operator++() {
+            size_t p = pos();
+            if (p != npos)
+                pos_ = set_->Skip(p + 1);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator &that) const {
+            return pos() == that.pos();
+        }
+
+        bool operator!=(const const_iterator &that) const {
+            return !(*this == that);
+        }
+    };
+    typedef const_iterator iterator;
+
+    DenseIdSet()
+            : size_(0) {}
+
+    const_iterator begin() const {
+        return const_iterator(this, Skip(0));
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, npos);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // Makes room for the elements with ids less than max_id
+    void reserve(size_t max_id) {
+        if (max_id > slots_.size())
+            slots_.reserve(max_id);
+    }
+
+    bool count(const T &x) const {
+        size_t id = x.int_id();
+        return id < slots_.size() && slots_[id].int_id() != 0;
+    }
+
+    void insert(const T &x) {
+        size_t id = x.int_id();
+        VERIFY(id != 0);
+        if (id >= slots_.size()) {
+            // Grow geometrically even if ids come in strictly increasing order
+            if (id >= slots_.capacity())
+                slots_.reserve(std::max(id + 1, 2 * slots_.capacity()));
+            slots_.resize(id + 1);
+        }
+        if (slots_[id].int_id() == 0)
+            size_ += 1;
+        slots_[id] = x;
+    }
+
+    void erase(const T &x) {
+        size_t id = x.int_id();
+        if (id >= slots_.size() || slots_[id].int_id() == 0)
+            return;
+        slots_[id] = T();
+        size_ -= 1;
+    }
+};
+
+}
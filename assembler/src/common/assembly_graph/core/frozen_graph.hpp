@@ -0,0 +1,290 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "adt/iterator_range.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace omnigraph {
+
+/*
+ * Read-only snapshot of the graph for the stages which only traverse it.
+ * Adjacency is kept in compressed sparse row form: outgoing and incoming
+ * edges of every vertex are stored contiguously, edge starts, ends, lengths,
+ * coverages and conjugates are kept in flat arrays. Elements are identified
+ * by the same VertexId / EdgeId as in the original graph, so the results of
+ * the algorithms run on the snapshot could be used directly.
+ *
+ * The snapshot does not follow graph modifications: it should be rebuilt if
+ * the graph was changed. Sequences and data are taken from the original graph.
+ */
+template<class Graph>
+class FrozenGraph {
+public:
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::EdgeData EdgeData;
+    typedef typename Graph::VertexData VertexData;
+    typedef typename std::vector<VertexId>::const_iterator VertexIt;
+    typedef VertexIt const_iterator;
+    typedef const EdgeId *edge_const_iterator;
+    typedef adt::iterator_range<edge_const_iterator> IteratorContainer;
+
+private:
+    typedef uint32_t Index;
+    static const Index NoIndex = std::numeric_limits<Index>::max();
+
+    const Graph &g_;
+
+    // Dense index of the vertex or edge by its int id
+    std::vector<Index> idx_;
+
+    std::vector<VertexId> vertices_;
+    std::vector<Index> vertex_conjugate_;
+    std::vector<Index> out_offsets_, in_offsets_;
+
+    // Edges are numbered by their position in the outgoing lists
+    std::vector<EdgeId> out_edges_, in_edges_;
+    std::vector<Index> edge_start_, edge_end_, edge_conjugate_;
+    std::vector<size_t> length_;
+    std::vector<double> coverage_;
+
+    static void PrefixSum(std::vector<Index> &offsets) {
+        Index sum = 0;
+        for (Index &x : offsets) {
+            Index cnt = x;
+            x = sum;
+            sum += cnt;
+        }
+    }
+
+    Index idx(VertexId v) const {
+        return idx_[v.int_id()];
+    }
+
+    Index idx(EdgeId e) const {
+        return idx_[e.int_id()];
+    }
+
+public:
+    FrozenGraph(const Graph &g)
+            : g_(g) {
+        vertices_.assign(g.begin(), g.end());
+        size_t n = vertices_.size();
+        VERIFY(n < NoIndex);
+
+        // The distributor max may be far beyond the actual ids (e.g. for old saves)
+        size_t max_id = 0;
+        for (VertexId v : vertices_) {
+            max_id = std::max(max_id, v.int_id());
+            for (EdgeId e : g.OutgoingEdges(v))
+                max_id = std::max(max_id, e.int_id());
+        }
+        idx_.assign(max_id + 1, Index(NoIndex));
+        out_offsets_.resize(n + 1);
+        in_offsets_.resize(n + 1);
+        # pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) {
+            VertexId v = vertices_[i];
+            idx_[v.int_id()] = Index(i);
+            out_offsets_[i] = Index(g.OutgoingEdgeCount(v));
+            in_offsets_[i] = Index(g.IncomingEdgeCount(v));
+        }
+        out_offsets_[n] = in_offsets_[n] = 0;
+        PrefixSum(out_offsets_);
+        PrefixSum(in_offsets_);
+
+        size_t m = out_offsets_[n];
+        VERIFY(m < NoIndex);
+        out_edges_.resize(m);
+        in_edges_.resize(m);
+        edge_start_.resize(m);
+        length_.resize(m);
+        coverage_.resize(m);
+        vertex_conjugate_.resize(n);
+        # pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) {
+            VertexId v = vertices_[i];
+            Index pos = out_offsets_[i];
+            for (EdgeId e : g.OutgoingEdges(v)) {
+                out_edges_[pos] = e;
+                idx_[e.int_id()] = pos;
+                edge_start_[pos] = Index(i);
+                length_[pos] = g.length(e);
+                coverage_[pos] = g.coverage(e);
+                pos += 1;
+            }
+            std::copy(g.in_begin(v), g.in_end(v), in_edges_.begin() + in_offsets_[i]);
+            vertex_conjugate_[i] = idx(g.conjugate(v));
+        }
+
+        edge_end_.resize(m);
+        edge_conjugate_.resize(m);
+        # pragma omp parallel for schedule(static)
+        for (size_t pos = 0; pos < m; ++pos) {
+            EdgeId e = out_edges_[pos];
+            edge_end_[pos] = idx(g.EdgeEnd(e));
+            edge_conjugate_[pos] = idx(g.conjugate(e));
+        }
+    }
+
+    const Graph &graph() const {
+        return g_;
+    }
+
+    VertexIt begin() const {
+        return vertices_.begin();
+    }
+
+    VertexIt end() const {
+        return vertices_.end();
+    }
+
+    size_t size() const {
+        return vertices_.size();
+    }
+
+    size_t e_size() const {
+        return out_edges_.size();
+    }
+
+    size_t k() const {
+        return g_.k();
+    }
+
+    edge_const_iterator out_begin(VertexId v) const {
+        return out_edges_.data() + out_offsets_[idx(v)];
+    }
+
+    edge_const_iterator out_end(VertexId v) const {
+        return out_edges_.data() + out_offsets_[idx(v) + 1];
+    }
+
+    edge_const_iterator in_begin(VertexId v) const {
+        return in_edges_.data() + in_offsets_[idx(v)];
+    }
+
+    edge_const_iterator in_end(VertexId v) const {
+        return in_edges_.data() + in_offsets_[idx(v) + 1];
+    }
+
+    IteratorContainer OutgoingEdges(VertexId v) const {
+        return IteratorContainer(out_begin(v), out_end(v));
+    }
+
+    IteratorContainer IncomingEdges(VertexId v) const {
+        return IteratorContainer(in_begin(v), in_end(v));
+    }
+
+    size_t OutgoingEdgeCount(VertexId v) const {
+        Index i = idx(v);
+        return out_offsets_[i + 1] - out_offsets_[i];
+    }
+
+    size_t IncomingEdgeCount(VertexId v) const {
+        Index i = idx(v);
+        return in_offsets_[i + 1] - in_offsets_[i];
+    }
+
+    bool CheckUniqueOutgoingEdge(VertexId v) const {
+        return OutgoingEdgeCount(v) == 1;
+    }
+
+    EdgeId GetUniqueOutgoingEdge(VertexId v) const {
+        VERIFY(CheckUniqueOutgoingEdge(v));
+        return *out_begin(v);
+    }
+
+    bool CheckUniqueIncomingEdge(VertexId v) const {
+        return IncomingEdgeCount(v) == 1;
+    }
+
+    EdgeId GetUniqueIncomingEdge(VertexId v) const {
+        VERIFY(CheckUniqueIncomingEdge(v));
+        return *in_begin(v);
+    }
+
+    bool IsDeadEnd(VertexId v) const {
+        return OutgoingEdgeCount(v) == 0;
+    }
+
+    bool IsDeadStart(VertexId v) const {
+        return IncomingEdgeCount(v) == 0;
+    }
+
+    VertexId EdgeStart(EdgeId e) const {
+        return vertices_[edge_start_[idx(e)]];
+    }
+
+    VertexId EdgeEnd(EdgeId e) const {
+        return vertices_[edge_end_[idx(e)]];
+    }
+
+    VertexId conjugate(VertexId v) const {
+        return vertices_[vertex_conjugate_[idx(v)]];
+    }
+
+    EdgeId conjugate(EdgeId e) const {
+        return out_edges_[edge_conjugate_[idx(e)]];
+    }
+
+    bool RelatedVertices(VertexId v1, VertexId v2) const {
+        return v1 == v2 || v1 == conjugate(v2);
+    }
+
+    size_t length(EdgeId e) const {
+        return length_[idx(e)];
+    }
+
+    size_t length(VertexId v) const {
+        return g_.length(v);
+    }
+
+    double coverage(EdgeId e) const {
+        return coverage_[idx(e)];
+    }
+
+    const EdgeData &data(EdgeId e) const {
+        return g_.data(e);
+    }
+
+    const VertexData &data(VertexId v) const {
+        return g_.data(v);
+    }
+
+    auto EdgeNucls(EdgeId e) const -> decltype(g_.EdgeNucls(e)) {
+        return g_.EdgeNucls(e);
+    }
+
+    size_t int_id(EdgeId e) const {
+        return e.int_id();
+    }
+
+    size_t int_id(VertexId v) const {
+        return v.int_id();
+    }
+
+    std::string str(EdgeId e) const {
+        std::stringstream ss;
+        ss << int_id(e) << " (" << length(e) << ")";
+        return ss.str();
+    }
+
+    std::string str(VertexId v) const {
+        return std::to_string(int_id(v));
+    }
+};
+
+}
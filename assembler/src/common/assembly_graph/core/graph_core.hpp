@@ -12,11 +12,12 @@
 #include "utils/logger/logger.hpp"
 #include "order_and_law.hpp"
 #include "utils/stl_utils.hpp"
+#include "paired_element_pool.hpp"
+#include "dense_id_set.hpp"
 
 #include "adt/small_pod_vector.hpp"
 
 #include <boost/iterator/iterator_facade.hpp>
-#include <btree/safe_btree_set.h>
 
 namespace omnigraph {
 
@@ -235,14 +236,20 @@ public:
     typedef typename DataMasterT::EdgeData EdgeData;
     typedef restricted::pure_pointer<PairedEdge<DataMaster>> EdgeId;
     typedef restricted::pure_pointer<PairedVertex<DataMaster>> VertexId;
-    typedef btree::safe_btree_set<VertexId> VertexContainer;
+    typedef DenseIdSet<VertexId> VertexContainer;
     typedef typename VertexContainer::const_iterator VertexIt;
     typedef typename PairedVertex<DataMaster>::edge_const_iterator edge_const_iterator;
 
 private:
+   typedef PairedEdge<DataMaster> EdgeT;
+   typedef PairedVertex<DataMaster> VertexT;
+
    restricted::LocalIdDistributor id_distributor_;
    DataMaster master_;
    VertexContainer vertices_;
+   // Edges and vertices are allocated together with their conjugates
+   PairedElementPool<EdgeT> edge_pool_;
+   PairedElementPool<VertexT> vertex_pool_;
 
    friend class ConstructionHelper<DataMaster>;
 public:
@@ -254,7 +261,7 @@ public:
        return vertices_.end();
    }
 
-   const std::set<VertexId>& vertices() const {
+   const VertexContainer& vertices() const {
        return vertices_;
    }
 
@@ -286,8 +293,19 @@ private:
 
    void DestroyVertex(VertexId vertex) {
        VertexId conjugate = vertex->conjugate();
-       delete vertex.get();
-       delete conjugate.get();
+       VertexT *storage = std::min(vertex.get(), conjugate.get());
+       vertex->~VertexT();
+       conjugate->~VertexT();
+       vertex_pool_.deallocate(storage);
+   }
+
+   void DestroyEdge(EdgeId edge) {
+       EdgeId rc = conjugate(edge);
+       EdgeT *storage = std::min(edge.get(), rc.get());
+       if (edge != rc)
+           rc->~EdgeT();
+       edge->~EdgeT();
+       edge_pool_.deallocate(storage);
    }
 
    bool AdditionalCompressCondition(VertexId v) const {
@@ -297,8 +315,9 @@ private:
 protected:
 
    VertexId CreateVertex(const VertexData& data1, const VertexData& data2, restricted::IdDistributor& id_distributor) {
-       VertexId vertex1(new PairedVertex<DataMaster>(data1), id_distributor);
-       VertexId vertex2(new PairedVertex<DataMaster>(data2), id_distributor);
+       VertexT *storage = vertex_pool_.allocate();
+       VertexId vertex1(new (storage) VertexT(data1), id_distributor);
+       VertexId vertex2(new (storage + 1) VertexT(data2), id_distributor);
        vertex1->set_conjugate(vertex2);
        vertex2->set_conjugate(vertex1);
        return vertex1;
@@ -335,21 +354,22 @@ protected:
     /////////////////////////low-level ops (move to helper?!)
 
     ////what with this method?
-    EdgeId AddSingleEdge(VertexId v1, VertexId v2, const EdgeData &data,
+    EdgeId AddSingleEdge(EdgeT *storage, VertexId v1, VertexId v2, const EdgeData &data,
                          restricted::IdDistributor &idDistributor) {
-        EdgeId newEdge(new PairedEdge<DataMaster>(v2, data), idDistributor);
+        EdgeId newEdge(new (storage) EdgeT(v2, data), idDistributor);
         if (v1 != VertexId(0))
             v1->AddOutgoingEdge(newEdge);
         return newEdge;
     }
 
     EdgeId HiddenAddEdge(const EdgeData& data, restricted::IdDistributor& id_distributor) {
-        EdgeId result = AddSingleEdge(VertexId(0), VertexId(0), data, id_distributor);
+        EdgeT *storage = edge_pool_.allocate();
+        EdgeId result = AddSingleEdge(storage, VertexId(0), VertexId(0), data, id_distributor);
         if (this->master().isSelfConjugate(data)) {
             result->set_conjugate(result);
             return result;
         }
-        EdgeId rcEdge = AddSingleEdge(VertexId(0), VertexId(0), this->master().conjugate(data), id_distributor);
+        EdgeId rcEdge = AddSingleEdge(storage + 1, VertexId(0), VertexId(0), this->master().conjugate(data), id_distributor);
         result->set_conjugate(rcEdge);
         rcEdge->set_conjugate(result);
         return result;
@@ -362,7 +382,8 @@ protected:
     EdgeId HiddenAddEdge(VertexId v1, VertexId v2, const EdgeData& data, restricted::IdDistributor& id_distributor) {
         //      todo was suppressed for concurrent execution reasons (see concurrent_graph_component.hpp)
         //      VERIFY(this->vertices_.find(v1) != this->vertices_.end() && this->vertices_.find(v2) != this->vertices_.end());
-        EdgeId result = AddSingleEdge(v1, v2, data, id_distributor);
+        EdgeT *storage = edge_pool_.allocate();
+        EdgeId result = AddSingleEdge(storage, v1, v2, data, id_distributor);
         if (this->master().isSelfConjugate(data) && (v1 == conjugate(v2))) {
             //              todo why was it removed???
             //          Because of some split issues: when self-conjugate edge is split armageddon happends
@@ -371,7 +392,7 @@ protected:
             result->set_conjugate(result);
             return result;
         }
-        EdgeId rcEdge = AddSingleEdge(v2->conjugate(), v1->conjugate(), this->master().conjugate(data), id_distributor);
+        EdgeId rcEdge = AddSingleEdge(storage + 1, v2->conjugate(), v1->conjugate(), this->master().conjugate(data), id_distributor);
         result->set_conjugate(rcEdge);
         rcEdge->set_conjugate(result);
         return result;
@@ -388,10 +409,7 @@ protected:
         VertexId start = conjugate(rcEdge->end());
         start->RemoveOutgoingEdge(edge);
         rcStart->RemoveOutgoingEdge(rcEdge);
-        if (edge != rcEdge) {
-            delete rcEdge.get();
-        }
-        delete edge.get();
+        DestroyEdge(edge);
     }
 
     void HiddenDeletePath(const std::vector<EdgeId>& edgesToDelete, const std::vector<VertexId>& verticesToDelete) {
@@ -79,6 +79,8 @@ public:
 
     void FireSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const;
 
+    void FireFlush() const;
+
     bool VerifyAllDetached();
 
     //smart iterators
@@ -381,6 +383,15 @@ void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeI
     }
 }
 
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireFlush() const {
+    for (Handler* handler_ptr : action_handler_list_) {
+        if (handler_ptr->IsAttached()) {
+            handler_ptr->HandleFlush();
+        }
+    }
+}
+
 template<class DataMaster>
 bool ObservableGraph<DataMaster>::VerifyAllDetached() {
     for (Handler* handler_ptr : action_handler_list_) {
@@ -0,0 +1,100 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace omnigraph {
+
+/*
+ * Storage for graph elements. Edges and vertices are always created and
+ * destroyed together with their conjugates, so the pool hands out slots for
+ * two adjacent elements. Slots are cut from large slabs by every thread on its
+ * own, freed slots are kept in the free list of the releasing thread and
+ * reused. Slabs are returned to the system only when the pool is destroyed.
+ */
+template<class T>
+class PairedElementPool {
+    union Slot {
+        Slot *next;
+        typename std::aligned_storage<2 * sizeof(T), alignof(T)>::type storage;
+    };
+
+    static const size_t SlabSlots = 1024;
+
+    struct Cache {
+        std::mutex lock;
+        Slot *free;
+        Slot *slab_pos, *slab_end;
+        // Keep caches of different threads on different cache lines
+        char pad[64];
+
+        Cache() : free(nullptr), slab_pos(nullptr), slab_end(nullptr) {}
+    };
+
+    size_t cache_num_;
+    std::unique_ptr<Cache[]> caches_;
+
+    std::mutex slabs_lock_;
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+
+    PairedElementPool(const PairedElementPool &) = delete;
+    void operator=(const PairedElementPool &) = delete;
+
+    Cache &cache() {
+        return caches_[size_t(omp_get_thread_num()) % cache_num_];
+    }
+
+    Slot *NewSlab() {
+        Slot *slab = new Slot[SlabSlots];
+        std::lock_guard<std::mutex> guard(slabs_lock_);
+        slabs_.emplace_back(slab);
+        return slab;
+    }
+
+public:
+    PairedElementPool()
+            : cache_num_(std::max(omp_get_max_threads(), 1)), caches_(new Cache[cache_num_]) {}
+
+    // Returns uninitialized storage for two elements
+    T *allocate() {
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.lock);
+
+        Slot *slot = c.free;
+        if (slot) {
+            c.free = slot->next;
+        } else {
+            if (c.slab_pos == c.slab_end) {
+                c.slab_pos = NewSlab();
+                c.slab_end = c.slab_pos + SlabSlots;
+            }
+            slot = c.slab_pos++;
+        }
+
+        return reinterpret_cast<T*>(&slot->storage);
+    }
+
+    // Takes back the storage returned by allocate(), elements should be already
+    // destroyed. The pointer to the second element of the pair is not accepted.
+    void deallocate(T *p) {
+        Slot *slot = reinterpret_cast<Slot*>(p);
+        Cache &c = cache();
+        std::lock_guard<std::mutex> guard(c.lock);
+
+        slot->next = c.free;
+        c.free = slot;
+    }
+};
+
+}
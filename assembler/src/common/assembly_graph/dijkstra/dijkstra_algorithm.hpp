@@ -8,56 +8,29 @@
 
 #include "utils/stl_utils.hpp"
 #include "dijkstra_settings.hpp"
+#include "dijkstra_state.hpp"
 
-#include <queue>
+#include <algorithm>
 #include <vector>
-#include <set>
-#include <map>
 
 namespace omnigraph {
 
-template<typename Graph, typename distance_t = size_t>
-struct element_t{
-    typedef typename Graph::VertexId VertexId;
-    typedef typename Graph::EdgeId EdgeId;
-
-    distance_t distance;
-    VertexId curr_vertex;
-    VertexId prev_vertex;
-    EdgeId edge_between;
-
-    element_t(distance_t new_distance, VertexId new_cur_vertex, VertexId new_prev_vertex,
-            EdgeId new_edge_between) : distance(new_distance), curr_vertex(new_cur_vertex),
-                    prev_vertex(new_prev_vertex), edge_between(new_edge_between) { }
-};
-
-template<typename T>
-class ReverseDistanceComparator {
-public:
-  ReverseDistanceComparator() {
-  }
-
-  bool operator()(T obj1, T obj2){
-      if(obj1.distance != obj2.distance)
-          return obj2.distance < obj1.distance;
-      if(obj2.curr_vertex != obj1.curr_vertex)
-          return obj2.curr_vertex < obj1.curr_vertex;
-      if(obj2.prev_vertex != obj1.prev_vertex)
-          return obj2.prev_vertex < obj1.prev_vertex;
-      return obj2.edge_between < obj1.edge_between;
-  }
-};
-
+/*
+ * Per-vertex state of a run is kept in a DijkstraState taken from the pool of
+ * the thread for the lifetime of the object, so short bounded runs, which are
+ * launched in huge numbers, do not allocate.
+ */
 template<class Graph, class DijkstraSettings, typename distance_t = size_t>
 class Dijkstra {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
     typedef distance_t DistanceType;
 
-    typedef std::map<VertexId, distance_t> distances_map;
-    typedef typename distances_map::const_iterator distances_map_ci;
-    typedef typename std::priority_queue<element_t<Graph, distance_t>, std::vector<element_t<Graph, distance_t>>,
-            ReverseDistanceComparator<element_t<Graph, distance_t>>> queue_t;
+    typedef DijkstraState<Graph, distance_t> State;
+    typedef typename State::Entry Entry;
+    typedef typename State::Element Element;
+    typedef typename State::Queue queue_t;
+    typedef DijkstraStatePool<State> Pool;
 
     // constructor parameters
     const Graph& graph_;
@@ -70,19 +43,14 @@ class Dijkstra {
     bool vertex_limit_exceeded_;
 
     // accumulative structures
-    distances_map distances_;
-    std::set<VertexId> processed_vertices_;
-    std::map<VertexId, pair<VertexId, EdgeId>> prev_vert_map_;
+    typename Pool::StatePtr state_;
 
     void Init(VertexId start, queue_t &queue) {
         vertex_number_ = 0;
-        distances_.clear();
-        processed_vertices_.clear();
-        prev_vert_map_.clear();
+        state_->Clear();
         set_finished(false);
         settings_.Init(start);
-        queue.push(element_t<Graph, distance_t>(0, start, VertexId(0), EdgeId(0)));
-        prev_vert_map_[start] = std::pair<VertexId, EdgeId>(VertexId(0), EdgeId(0));
+        queue.push(Element(0, start, VertexId(0), EdgeId(0)));
     }
 
     void set_finished(bool state) {
@@ -117,8 +85,7 @@ class Dijkstra {
                 TRACE("Entry: vertex " << graph_.str(cur_vertex) << " distance " << new_dist);
                 if (CheckPutVertex(cur_pair.vertex, cur_pair.edge, new_dist)) {
                     TRACE("CheckPutVertex returned true and new entry is added");
-                    queue.push(element_t<Graph, distance_t>(new_dist, cur_pair.vertex,
-                                    cur_vertex, cur_pair.edge));
+                    queue.push(Element(new_dist, cur_pair.vertex, cur_vertex, cur_pair.edge));
                 }
             }
             TRACE("Checking new neighbour of vertex " << graph_.str(cur_vertex) << " finished");
@@ -133,7 +100,8 @@ public:
         max_vertex_number_(max_vertex_number),
         finished_(false),
         vertex_number_(0),
-        vertex_limit_exceeded_(false) {}
+        vertex_limit_exceeded_(false),
+        state_(Pool::Acquire()) {}
 
     Dijkstra(Dijkstra&& /*other*/) = default; 
 
@@ -148,41 +116,39 @@ public:
     }
 
     bool DistanceCounted(VertexId vertex) const {
-        return distances_.find(vertex) != distances_.end();
+        return state_->Find(vertex) != nullptr;
     }
 
     distance_t GetDistance(VertexId vertex) const {
-        VERIFY(DistanceCounted(vertex));
-        return distances_.find(vertex)->second;
-    }
-
-    std::pair<distances_map_ci, distances_map_ci> GetDistances() const {
-        distances_map_ci begin = distances_.begin();
-        distances_map_ci end = distances_.end();
-        return make_pair(begin, end);
+        const Entry *entry = state_->Find(vertex);
+        VERIFY(entry);
+        return entry->distance;
     }
 
     void Run(VertexId start) {
         TRACE("Starting dijkstra run from vertex " << graph_.str(start));
-        queue_t queue;
+        queue_t &queue = state_->queue();
         Init(start, queue);
         TRACE("Priority queue initialized. Starting search");
 
         while (!queue.empty() && !finished()) {
             TRACE("Dijkstra iteration started");
-            const element_t<Graph, distance_t>& next = queue.top();
+            Element next = queue.pop();
             distance_t distance = next.distance;
             VertexId vertex = next.curr_vertex;
-
-            prev_vert_map_[vertex] = std::pair<VertexId, EdgeId>(next.prev_vertex, next.edge_between);
-            queue.pop();
             TRACE("Vertex " << graph_.str(vertex) << " with distance " << distance << " fetched from queue");
 
-            if (DistanceCounted(vertex)) {
+            Entry *entry = state_->Find(vertex);
+            if (entry) {
+                // The last fetched entry defines the path
+                entry->prev_vertex = next.prev_vertex;
+                entry->edge = next.edge_between;
                 TRACE("Distance to vertex " << graph_.str(vertex) << " already counted. Proceeding to next queue entry.");
                 continue;
             }
-            distances_.insert(make_pair(vertex, distance));
+            entry = &state_->Insert(vertex, distance);
+            entry->prev_vertex = next.prev_vertex;
+            entry->edge = next.edge_between;
 
             TRACE("Vertex " << graph_.str(vertex) << " is found to be at distance "
                     << distance << " from vertex " << graph_.str(start));
@@ -190,7 +156,7 @@ public:
                 TRACE("Check for processing vertex failed. Proceeding to the next queue entry.");
                 continue;
             }
-            processed_vertices_.insert(vertex);
+            state_->MarkProcessed(*entry);
             AddNeighboursToQueue(vertex, distance, queue);
         }
         set_finished(true);
@@ -199,36 +165,44 @@ public:
 
     std::vector<EdgeId> GetShortestPathTo(VertexId vertex) {
         std::vector<EdgeId> path;
-        if (prev_vert_map_.find(vertex) == prev_vert_map_.end())
+        const Entry *entry = state_->Find(vertex);
+        if (!entry)
             return path;
 
-        VertexId curr_vertex = vertex;
-        VertexId prev_vertex = utils::get(prev_vert_map_, vertex).first;
-        EdgeId edge = utils::get(prev_vert_map_, curr_vertex).second;
+        VertexId prev_vertex = entry->prev_vertex;
+        EdgeId edge = entry->edge;
 
         while (prev_vertex != VertexId(0)) {
             if (graph_.EdgeStart(edge) == prev_vertex)
-                path.insert(path.begin(), edge);
-            else
                 path.push_back(edge);
-            curr_vertex = prev_vertex;
-            const auto& prev_v_e = utils::get(prev_vert_map_, curr_vertex);
-            prev_vertex = prev_v_e.first;
-            edge = prev_v_e.second;
+            else
+                path.insert(path.begin(), edge);
+            entry = state_->Find(prev_vertex);
+            VERIFY(entry);
+            prev_vertex = entry->prev_vertex;
+            edge = entry->edge;
         }
+        // Edges were collected in reverse: forward ones go before the backward ones, which keep their order
+        std::reverse(path.begin(), path.end());
         return path;
     }
 
+    /**
+     * Vertices with counted distances, ordered by id
+     */
     vector<VertexId> ReachedVertices() const {
-        vector<VertexId> result;
-        for (auto it = distances_.begin(); it != distances_.end(); ++it) {
-            result.push_back(it->first);
-        }
+        vector<VertexId> result(state_->reached());
+        std::sort(result.begin(), result.end());
         return result;
     }
 
-    const set<VertexId>& ProcessedVertices() const {
-        return processed_vertices_;
+    /**
+     * Vertices whose neighbours were examined, ordered by id
+     */
+    vector<VertexId> ProcessedVertices() const {
+        vector<VertexId> result(state_->processed());
+        std::sort(result.begin(), result.end());
+        return result;
     }
 
     bool VertexLimitExceeded() const {
@@ -0,0 +1,332 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace omnigraph {
+
+template<typename Graph, typename distance_t = size_t>
+struct element_t{
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    distance_t distance;
+    VertexId curr_vertex;
+    VertexId prev_vertex;
+    EdgeId edge_between;
+
+    element_t(distance_t new_distance, VertexId new_cur_vertex, VertexId new_prev_vertex,
+            EdgeId new_edge_between) : distance(new_distance), curr_vertex(new_cur_vertex),
+                    prev_vertex(new_prev_vertex), edge_between(new_edge_between) { }
+};
+
+template<typename T>
+class ReverseDistanceComparator {
+public:
+  ReverseDistanceComparator() {
+  }
+
+  bool operator()(const T &obj1, const T &obj2) const {
+      if(obj1.distance != obj2.distance)
+          return obj2.distance < obj1.distance;
+      if(obj2.curr_vertex != obj1.curr_vertex)
+          return obj2.curr_vertex < obj1.curr_vertex;
+      if(obj2.prev_vertex != obj1.prev_vertex)
+          return obj2.prev_vertex < obj1.prev_vertex;
+      return obj2.edge_between < obj1.edge_between;
+  }
+};
+
+/*
+ * Binary heap over a vector, the storage is kept between runs.
+ */
+template<class Element>
+class HeapDijkstraQueue {
+    std::vector<Element> heap_;
+
+public:
+    bool empty() const {
+        return heap_.empty();
+    }
+
+    void clear() {
+        heap_.clear();
+    }
+
+    void push(const Element &e) {
+        heap_.push_back(e);
+        std::push_heap(heap_.begin(), heap_.end(), ReverseDistanceComparator<Element>());
+    }
+
+    Element pop() {
+        std::pop_heap(heap_.begin(), heap_.end(), ReverseDistanceComparator<Element>());
+        Element e = heap_.back();
+        heap_.pop_back();
+        return e;
+    }
+
+    size_t capacity() const {
+        return heap_.capacity();
+    }
+};
+
+/*
+ * Radix heap for unsigned integer distances. Dijkstra extracts distances in
+ * non-decreasing order, so an element is kept in the bucket numbered by the
+ * highest bit in which its distance differs from the last extracted one and
+ * is moved to the lower buckets only when the bucket becomes the first non-empty.
+ *
+ * Bucket 0 holds the elements at the last extracted distance, it is kept as a
+ * heap ordered by ReverseDistanceComparator, so the elements with equal
+ * distances come out in the same order as from the binary heap.
+ */
+template<class Element, typename distance_t>
+class RadixDijkstraQueue {
+    static const size_t BucketNum = 8 * sizeof(unsigned long long) + 1;
+
+    std::array<std::vector<Element>, BucketNum> buckets_;
+    distance_t last_;
+    size_t size_;
+
+    size_t BucketOf(distance_t distance) const {
+        if (distance == last_)
+            return 0;
+        return 8 * sizeof(unsigned long long) - __builtin_clzll((unsigned long long) (distance ^ last_));
+    }
+
+    void Refill() {
+        size_t i = 1;
+        while (buckets_[i].empty())
+            ++i;
+        std::vector<Element> &bucket = buckets_[i];
+        last_ = bucket.front().distance;
+        for (const Element &e : bucket)
+            last_ = std::min(last_, e.distance);
+        // All the elements go to the lower buckets
+        for (const Element &e : bucket)
+            buckets_[BucketOf(e.distance)].push_back(e);
+        bucket.clear();
+        std::make_heap(buckets_[0].begin(), buckets_[0].end(), ReverseDistanceComparator<Element>());
+    }
+
+public:
+    RadixDijkstraQueue()
+            : last_(0), size_(0) {}
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    void clear() {
+        for (auto &bucket : buckets_)
+            bucket.clear();
+        last_ = 0;
+        size_ = 0;
+    }
+
+    void push(const Element &e) {
+        size_t i = BucketOf(e.distance);
+        buckets_[i].push_back(e);
+        if (i == 0)
+            std::push_heap(buckets_[0].begin(), buckets_[0].end(), ReverseDistanceComparator<Element>());
+        size_ += 1;
+    }
+
+    Element pop() {
+        if (buckets_[0].empty())
+            Refill();
+        std::vector<Element> &bucket = buckets_[0];
+        std::pop_heap(bucket.begin(), bucket.end(), ReverseDistanceComparator<Element>());
+        Element e = bucket.back();
+        bucket.pop_back();
+        size_ -= 1;
+        return e;
+    }
+
+    size_t capacity() const {
+        size_t res = 0;
+        for (const auto &bucket : buckets_)
+            res += bucket.capacity();
+        return res;
+    }
+};
+
+/*
+ * Everything Dijkstra accumulates during a run: distances, predecessors and
+ * processed flags of the reached vertices in an open addressing table keyed by
+ * the vertex id, reached and processed vertices in the order of reaching and
+ * the queue. Entries are invalidated by bumping the stamp, so the storage is
+ * reused by the next run without clearing or allocations.
+ */
+template<class Graph, typename distance_t = size_t>
+class DijkstraState {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+public:
+    typedef element_t<Graph, distance_t> Element;
+    typedef typename std::conditional<std::is_integral<distance_t>::value && std::is_unsigned<distance_t>::value,
+            RadixDijkstraQueue<Element, distance_t>,
+            HeapDijkstraQueue<Element>>::type Queue;
+
+    struct Entry {
+        VertexId vertex;
+        VertexId prev_vertex;
+        EdgeId edge;
+        distance_t distance;
+        uint32_t stamp;
+        bool processed;
+    };
+
+private:
+    static const size_t INITIAL_SLOTS = 1 << 8;
+
+    std::vector<Entry> slots_;
+    uint32_t stamp_;
+
+    std::vector<VertexId> reached_;
+    std::vector<VertexId> processed_;
+    Queue queue_;
+
+    size_t SlotPos(size_t id) const {
+        return size_t((uint64_t(id) * 0x9E3779B97F4A7C15ull) >> 20) & (slots_.size() - 1);
+    }
+
+    void Grow() {
+        std::vector<Entry> old(2 * slots_.size(), Entry());
+        old.swap(slots_);
+        for (const Entry &entry : old) {
+            if (entry.stamp != stamp_)
+                continue;
+            size_t pos = SlotPos(entry.vertex.int_id());
+            while (slots_[pos].stamp == stamp_)
+                pos = (pos + 1) & (slots_.size() - 1);
+            slots_[pos] = entry;
+        }
+    }
+
+public:
+    DijkstraState()
+            : slots_(INITIAL_SLOTS, Entry()), stamp_(1) {}
+
+    void Clear() {
+        reached_.clear();
+        processed_.clear();
+        queue_.clear();
+        if (++stamp_ != 0)
+            return;
+        for (Entry &entry : slots_)
+            entry.stamp = 0;
+        stamp_ = 1;
+    }
+
+    Entry *Find(VertexId v) {
+        size_t id = v.int_id();
+        for (size_t pos = SlotPos(id); ; pos = (pos + 1) & (slots_.size() - 1)) {
+            Entry &entry = slots_[pos];
+            if (entry.stamp != stamp_)
+                return nullptr;
+            if (entry.vertex.int_id() == id)
+                return &entry;
+        }
+    }
+
+    const Entry *Find(VertexId v) const {
+        return const_cast<DijkstraState*>(this)->Find(v);
+    }
+
+    // The vertex should not be present
+    Entry &Insert(VertexId v, distance_t distance) {
+        if (2 * (reached_.size() + 1) > slots_.size())
+            Grow();
+        size_t pos = SlotPos(v.int_id());
+        while (slots_[pos].stamp == stamp_)
+            pos = (pos + 1) & (slots_.size() - 1);
+        Entry &entry = slots_[pos];
+        entry.vertex = v;
+        entry.distance = distance;
+        entry.stamp = stamp_;
+        entry.processed = false;
+        reached_.push_back(v);
+        return entry;
+    }
+
+    void MarkProcessed(Entry &entry) {
+        entry.processed = true;
+        processed_.push_back(entry.vertex);
+    }
+
+    const std::vector<VertexId> &reached() const {
+        return reached_;
+    }
+
+    const std::vector<VertexId> &processed() const {
+        return processed_;
+    }
+
+    Queue &queue() {
+        return queue_;
+    }
+
+    size_t memory() const {
+        return slots_.capacity() * sizeof(Entry) +
+               (reached_.capacity() + processed_.capacity()) * sizeof(VertexId) +
+               queue_.capacity() * sizeof(Element);
+    }
+};
+
+/*
+ * Per-thread free lists of Dijkstra states. Searches are launched in huge
+ * numbers from many places (bulge removal, path processing, gap closing),
+ * each one takes a state from the list of its thread and puts it back when
+ * it is destroyed, so the storage of the states is reused.
+ * States grown too large by long searches are released instead.
+ */
+template<class State>
+class DijkstraStatePool {
+    static const size_t MAX_FREE_STATES = 8;
+    static const size_t MAX_KEPT_MEMORY = 1 << 22;
+
+    static std::vector<std::unique_ptr<State>> &free_states() {
+        static thread_local std::vector<std::unique_ptr<State>> states;
+        return states;
+    }
+
+public:
+    struct Releaser {
+        void operator()(State *state) const {
+            DijkstraStatePool::Release(state);
+        }
+    };
+    typedef std::unique_ptr<State, Releaser> StatePtr;
+
+    static StatePtr Acquire() {
+        auto &states = free_states();
+        if (states.empty())
+            return StatePtr(new State());
+        StatePtr res(states.back().release());
+        states.pop_back();
+        return res;
+    }
+
+    static void Release(State *state) {
+        std::unique_ptr<State> holder(state);
+        auto &states = free_states();
+        if (states.size() < MAX_FREE_STATES && state->memory() <= MAX_KEPT_MEMORY)
+            states.push_back(std::move(holder));
+    }
+};
+
+}
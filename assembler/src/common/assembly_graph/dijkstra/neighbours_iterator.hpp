@@ -44,7 +44,7 @@ template<class Graph>
 class ForwardNeighbourIterator : public NeighbourIterator<Graph>{
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
-    typedef typename VertexId::type::edge_const_iterator edge_const_iterator;
+    typedef typename Graph::edge_const_iterator edge_const_iterator;
 
     pair<edge_const_iterator, edge_const_iterator> out_edges_;
 public:
@@ -68,7 +68,7 @@ template<class Graph>
 class BackwardNeighbourIterator : public NeighbourIterator<Graph>{
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
-    typedef typename VertexId::type::edge_const_iterator edge_const_iterator;
+    typedef typename Graph::edge_const_iterator edge_const_iterator;
 
     pair<edge_const_iterator, edge_const_iterator>  in_edges_;
 public:
@@ -92,7 +92,7 @@ template<class Graph>
 class UnorientedNeighbourIterator : public NeighbourIterator<Graph>{
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
-    typedef typename VertexId::type::edge_const_iterator edge_const_iterator;
+    typedef typename Graph::edge_const_iterator edge_const_iterator;
 
     pair<edge_const_iterator, edge_const_iterator>  in_edges_;
     pair<edge_const_iterator, edge_const_iterator>  out_edges_;
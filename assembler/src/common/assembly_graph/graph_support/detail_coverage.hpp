@@ -30,14 +30,6 @@ class FlankingCoverage : public omnigraph::GraphActionHandler<Graph> {
     Graph& g_;
     const size_t averaging_range_;
 
-    void SetRawCoverage(EdgeId e, unsigned cov) {
-        g_.data(e).set_flanking_coverage(cov);
-    }
-
-    unsigned RawCoverage(EdgeId e) const {
-        return g_.data(e).flanking_coverage();
-    }
-
     size_t EdgeAveragingRange(EdgeId e) const {
         return std::min(this->g().length(e), averaging_range_);
     }
@@ -72,6 +64,14 @@ public:
         return averaging_range_;
     }
 
+    void SetRawCoverage(EdgeId e, unsigned cov) {
+        g_.data(e).set_flanking_coverage(cov);
+    }
+
+    unsigned RawCoverage(EdgeId e) const {
+        return g_.data(e).flanking_coverage();
+    }
+
     //left for saves compatibility and tests remove later!
     template<class CoverageIndex>
     void Fill(const CoverageIndex& count_index) {
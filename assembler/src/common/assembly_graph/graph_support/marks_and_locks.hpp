@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "assembly_graph/core/order_and_law.hpp"
+
 namespace omnigraph {
 
 template<class T>
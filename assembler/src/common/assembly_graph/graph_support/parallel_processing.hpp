@@ -10,8 +10,11 @@
 #include "utils/logger/logger.hpp"
 #include "assembly_graph/core/graph_iterators.hpp"
 #include "assembly_graph/graph_support/graph_processing_algorithm.hpp"
+#include "assembly_graph/graph_support/marks_and_locks.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <boost/optional.hpp>
+
 namespace omnigraph {
 
 template<class Graph, class ElementId>
@@ -234,6 +237,154 @@ private:
     DECL_LOGGER("PersistentProcessingAlgorithm"); 
 };
 
+/**
+ * Base of the algorithms which look for local components around vertices and rewrite them.
+ * Processing goes in rounds. At first components are searched for all the candidate vertices in
+ * parallel (the search should not modify the graph). Then the found components are taken in the
+ * order of their vertices and accepted if none of their vertices and vertices adjacent to them
+ * (conjugate ones included) were claimed by the components accepted before, claims are kept in
+ * vertex marks. Accepted components do not touch each other, so they are committed one by one
+ * from the results of the search. Rejected candidates, new vertices and the vertices returned for
+ * consideration by the commits are searched again in the next round.
+ */
+template<class Graph, class Component>
+class ComponentBatchAlgorithm : public PersistentAlgorithmBase<Graph> {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::vector<std::pair<VertexId, Component>> FoundComponents;
+
+    const size_t chunk_cnt_;
+    SmartSetIterator<Graph, VertexId> candidates_;
+    GraphElementMarker<VertexId> marker_;
+
+    template<class ItVec>
+    FoundComponents FindFromChunkIterators(const ItVec& chunk_iterators) const {
+        VERIFY(chunk_iterators.size() > 1);
+        std::vector<FoundComponents> found(chunk_iterators.size() - 1);
+
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < chunk_iterators.size() - 1; ++i) {
+            for (auto it = chunk_iterators[i], end = chunk_iterators[i + 1]; it != end; ++it) {
+                VertexId v = *it;
+                boost::optional<Component> component = Find(v);
+                if (component)
+                    found[i].emplace_back(v, std::move(*component));
+            }
+        }
+
+        //chunks follow the order of vertices
+        FoundComponents answer;
+        for (auto& chunk : found) {
+            for (auto& entry : chunk)
+                answer.push_back(std::move(entry));
+            chunk.clear();
+        }
+        return answer;
+    }
+
+    FoundComponents FindFromCandidates() {
+        std::vector<VertexId> candidates;
+        for (; !candidates_.IsEnd(); ++candidates_)
+            candidates.push_back(*candidates_);
+        if (candidates.empty())
+            return FoundComponents();
+
+        size_t chunk_cnt = std::min(chunk_cnt_, candidates.size());
+        std::vector<typename std::vector<VertexId>::const_iterator> chunk_iterators;
+        for (size_t i = 0; i <= chunk_cnt; ++i)
+            chunk_iterators.push_back(candidates.cbegin() + candidates.size() * i / chunk_cnt);
+        return FindFromChunkIterators(chunk_iterators);
+    }
+
+    void CollectClaimed(const Component& component, std::vector<VertexId>& claimed) const {
+        claimed.clear();
+        for (VertexId v : ComponentVertices(component)) {
+            claimed.push_back(v);
+            for (EdgeId e : this->g().IncidentEdges(v)) {
+                claimed.push_back(this->g().EdgeStart(e));
+                claimed.push_back(this->g().EdgeEnd(e));
+            }
+        }
+    }
+
+    //returns indices of accepted components, rejected candidates are returned for consideration
+    std::vector<size_t> Select(const FoundComponents& found) {
+        std::vector<size_t> accepted;
+        std::vector<VertexId> claimed, marked;
+        for (size_t i = 0; i < found.size(); ++i) {
+            CollectClaimed(found[i].second, claimed);
+            if (std::any_of(claimed.begin(), claimed.end(),
+                            [&](VertexId v) {return marker_.is_marked(v);})) {
+                TRACE("Component of " << this->g().str(found[i].first) << " overlaps with accepted ones");
+                candidates_.push(found[i].first);
+                continue;
+            }
+            for (VertexId v : claimed) {
+                if (!marker_.is_marked(v)) {
+                    marker_.mark(v);
+                    marked.push_back(v);
+                }
+            }
+            accepted.push_back(i);
+        }
+
+        //marks should be gone before the graph is modified
+        for (VertexId v : marked)
+            marker_.unmark(v);
+        return accepted;
+    }
+
+protected:
+    //Should be thread safe and should not modify the graph
+    virtual boost::optional<Component> Find(VertexId v) const = 0;
+
+    //Vertices of the component, the ones adjacent to them are claimed automatically
+    virtual std::vector<VertexId> ComponentVertices(const Component& component) const = 0;
+
+    //Applies the changes to the graph, returns true if the graph was changed
+    virtual bool Commit(VertexId v, Component& component) = 0;
+
+    void ReturnForConsideration(VertexId v) {
+        candidates_.push(v);
+    }
+
+public:
+    ComponentBatchAlgorithm(Graph& g, size_t chunk_cnt)
+            : PersistentAlgorithmBase<Graph>(g),
+              chunk_cnt_(std::max(chunk_cnt, size_t(1))),
+              candidates_(g, /*add new*/true) {
+        candidates_.Detach();
+    }
+
+    //every run starts from scratch
+    size_t Run(bool /*force_primary_launch*/ = false) override {
+        candidates_.Attach();
+        candidates_.clear();
+
+        size_t triggered = 0;
+        size_t round = 0;
+        FoundComponents found = FindFromChunkIterators(
+                IterationHelper<Graph, VertexId>(this->g()).Chunks(chunk_cnt_));
+        while (!found.empty()) {
+            std::vector<size_t> accepted = Select(found);
+            DEBUG("Round " << round << ": " << found.size() << " components found, "
+                           << accepted.size() << " accepted");
+            for (size_t i : accepted) {
+                if (Commit(found[i].first, found[i].second))
+                    triggered++;
+            }
+            found = FindFromCandidates();
+            round++;
+        }
+
+        candidates_.Detach();
+        return triggered;
+    }
+
+private:
+    DECL_LOGGER("ComponentBatchAlgorithm");
+};
+
 template<class Graph,
         class Comparator = std::less<typename Graph::EdgeId>>
 class ParallelEdgeRemovingAlgorithm : public PersistentProcessingAlgorithm<Graph,
@@ -108,9 +108,23 @@ public:
                                       const pe_config::LongReads &lr_config);
 };
 
+/* Unique edges already used by the paths.
+ * A speculative storage is layered over the base one: it keeps its own insertions and the answers
+ * the base gave to its checks, the base is only read. The changes are then taken away,
+ * checked against the current state of the base and applied to it (see CompositeExtender).
+ */
 class UsedUniqueStorage {
+public:
+    struct Changes {
+        set<EdgeId> used;
+        vector<pair<EdgeId, bool>> checks;
+    };
+
+private:
     set<EdgeId> used_;
     const ScaffoldingUniqueEdgeStorage& unique_;
+    const UsedUniqueStorage *base_;
+    mutable vector<pair<EdgeId, bool>> base_checks_;
 
 public:
     UsedUniqueStorage(const UsedUniqueStorage&) = delete;
@@ -120,7 +134,13 @@ public:
     UsedUniqueStorage& operator=(UsedUniqueStorage&&) = default;
 
     explicit UsedUniqueStorage(const ScaffoldingUniqueEdgeStorage& unique):
-            unique_(unique) {}
+            unique_(unique), base_(nullptr) {}
+
+    //Speculative storage over the base one
+    explicit UsedUniqueStorage(const UsedUniqueStorage *base):
+            unique_(base->unique_), base_(base) {
+        VERIFY(!base->base_);
+    }
 
     void insert(EdgeId e) {
         if (unique_.IsUnique(e)) {
@@ -134,7 +154,15 @@ public:
 //    }
 
     bool IsUsedAndUnique(EdgeId e) const {
-        return (unique_.IsUnique(e) && used_.find(e) != used_.end());
+        if (!unique_.IsUnique(e))
+            return false;
+        if (used_.find(e) != used_.end())
+            return true;
+        if (!base_)
+            return false;
+        bool used = base_->IsUsedAndUnique(e);
+        base_checks_.push_back(make_pair(e, used));
+        return used;
     }
 
     bool UniqueCheckEnabled() const {
@@ -153,6 +181,29 @@ public:
         return true;
     }
 
+    //Takes the changes made by the speculative storage away, the storage becomes clean
+    Changes TakeChanges() {
+        VERIFY(base_);
+        Changes changes;
+        changes.used.swap(used_);
+        changes.checks.swap(base_checks_);
+        return changes;
+    }
+
+    //Checks that the storage gives the same answers the speculative one got
+    bool Consistent(const Changes &changes) const {
+        VERIFY(!base_);
+        for (const auto &check : changes.checks)
+            if (IsUsedAndUnique(check.first) != check.second)
+                return false;
+        return true;
+    }
+
+    void Apply(const Changes &changes) {
+        VERIFY(!base_);
+        used_.insert(changes.used.begin(), changes.used.end());
+    }
+
 };
 
 //FIXME rename
@@ -79,6 +79,7 @@ fs::files_t DeBruijnGraphKMerSplitter<Graph, KmerFilter>::Split(size_t num_files
 
     INFO("Used " << counter << " sequences.");
 
+    this->ExpandSuperKMers(out);
     this->ClearBuffers();
 
     return out;
@@ -98,7 +99,7 @@ public:
         DeBruijnGraphKMerSplitter<Graph,
                                   utils::StoringTypeFilter<typename Index::storing_type>>
                 splitter(index.workdir(), index.k(), g, read_buffer_size);
-        utils::KMerDiskCounter<RtSeq> counter(index.workdir(), splitter);
+        utils::KMerMemoryCounter<RtSeq> counter(index.workdir(), splitter);
         BuildIndex(index, counter, 16, nthreads);
 
         // Now use the index to fill the coverage and EdgeId's
@@ -87,6 +87,11 @@ class EdgeInfoUpdater {
         DeleteKMers(nucls, e);
     }
 
+    // For the edges which are already gone from the graph
+    void DeleteKmers(EdgeId e, const Sequence &nucls) {
+        DeleteKMers(nucls, e);
+    }
+
     void UpdateAll() {
         unsigned nthreads = omp_get_max_threads();
 
@@ -121,10 +121,8 @@ public:
         }
     }
 
-    //Only coverage is loaded
     template<class Writer>
-    void BinWrite(Writer &writer) const {
-        this->index_ptr_->serialize(writer);
+    void BinWriteCounts(Writer &writer) const {
         size_t sz = this->data_.size();
         writer.write((char*)&sz, sizeof(sz));
         for (size_t i = 0; i < sz; ++i)
@@ -132,15 +130,28 @@ public:
     }
 
     template<class Reader>
-    void BinRead(Reader &reader, const std::string/* &FileName*/) {
-        this->clear();
-        this->index_ptr_->deserialize(reader);
+    void BinReadCounts(Reader &reader) {
         size_t sz = 0;
         reader.read((char*)&sz, sizeof(sz));
+        VERIFY_MSG(sz == this->index_ptr_->size(), "Edge index and k-mer counts size mismatch");
         this->data_.resize(sz);
         for (size_t i = 0; i < sz; ++i)
             reader.read((char*)&(this->data_[i].count), sizeof(this->data_[0].count));
     }
+
+    //Only coverage is loaded
+    template<class Writer>
+    void BinWrite(Writer &writer) const {
+        this->index_ptr_->serialize(writer);
+        BinWriteCounts(writer);
+    }
+
+    template<class Reader>
+    void BinRead(Reader &reader, const std::string/* &FileName*/) {
+        this->clear();
+        this->index_ptr_->deserialize(reader);
+        BinReadCounts(reader);
+    }
 };
 
 template<class Graph, class StoringType = utils::DefaultStoring>
@@ -87,24 +87,29 @@ class BidirectionalPath : public PathListener {
     const Graph& g_;
     std::deque<EdgeId> data_;
     BidirectionalPath* conj_path_;
-    // Length from beginning of i-th edge to path end: L(e_i + gap_(i+1) + e_(i+1) + ... + gap_N + e_N)
-    std::deque<size_t> cumulative_len_;
+    // Positions of edge starts and of the path end on a common axis, so that
+    // L(e_i + gap_(i+1) + e_(i+1) + ... + gap_N + e_N) = end_pos_ - start_pos_[i].
+    // Edges are added and removed at both ends without touching the other positions.
+    std::deque<int64_t> start_pos_;
+    int64_t end_pos_;
     std::deque<Gap> gap_len_;  // e0 -> gap1 -> e1 -> ... -> gapN -> eN; gap0 = 0
     std::vector<PathListener *> listeners_;
     const uint64_t id_;  //Unique ID
+    size_t version_;  //Changed on every modification
     float weight_;
 
 public:
     BidirectionalPath(const Graph& g)
             : g_(g),
               conj_path_(nullptr),
+              end_pos_(0),
               id_(path_id_++),
+              version_(0),
               weight_(1.0) {
     }
 
     BidirectionalPath(const Graph& g, const std::vector<EdgeId>& path)
             : BidirectionalPath(g) {
-        //TODO cumulative_len takes O(N^2) to fill
         for (size_t i = 0; i < path.size(); ++i) {
             PushBack(path[i]);
         }
@@ -119,10 +124,12 @@ public:
             : g_(path.g_),
               data_(path.data_),
               conj_path_(nullptr),
-              cumulative_len_(path.cumulative_len_),
+              start_pos_(path.start_pos_),
+              end_pos_(path.end_pos_),
               gap_len_(path.gap_len_),
               listeners_(),
               id_(path_id_++),
+              version_(0),
               weight_(path.weight_) {
     }
 
@@ -180,7 +187,7 @@ public:
             return 0;
         }
         VERIFY(gap_len_[0].gap == 0);
-        return cumulative_len_[0];
+        return LengthAt(0);
     }
 
     //TODO iterators forward/reverse
@@ -198,7 +205,7 @@ public:
 
     // Length from beginning of i-th edge to path end for forward directed path: L(e1 + e2 + ... + eN)
     size_t LengthAt(size_t index) const {
-        return cumulative_len_[index];
+        return size_t(end_pos_ - start_pos_[index]);
     }
 
     Gap GapAt(size_t index) const {
@@ -207,12 +214,19 @@ public:
 
     void SetGapAt(size_t index, const Gap &gap) {
         gap_len_[index] = gap;
+        ++version_;
     }
 
     size_t GetId() const {
         return id_;
     }
 
+    // Pair (GetId(), Version()) identifies the current state of the path,
+    // so anything computed from the path can be reused until it changes
+    size_t Version() const {
+        return version_;
+    }
+
     EdgeId Back() const {
         return data_.back();
     }
@@ -226,6 +240,7 @@ public:
         data_.push_back(e);
         gap_len_.push_back(gap);
         IncreaseLengths(g_.length(e), gap.gap);
+        ++version_;
         NotifyBackEdgeAdded(e, gap);
     }
 
@@ -247,6 +262,7 @@ public:
         DecreaseLengths();
         gap_len_.pop_back();
         data_.pop_back();
+        ++version_;
         NotifyBackEdgeRemoved(e);
     }
 
@@ -480,19 +496,15 @@ private:
     }
 
     void IncreaseLengths(size_t length, int gap) {
-        for (auto iter = cumulative_len_.begin(); iter != cumulative_len_.end(); ++iter) {
-            *iter += length + gap;
-        }
-        cumulative_len_.push_back(length);
+        start_pos_.push_back(end_pos_ + gap);
+        end_pos_ = start_pos_.back() + (int64_t) length;
     }
 
     void DecreaseLengths() {
-        size_t length = g_.length(data_.back()) + gap_len_.back().gap;
-
-        for (auto iter = cumulative_len_.begin(); iter != cumulative_len_.end(); ++iter) {
-            *iter -= length;
-        }
-        cumulative_len_.pop_back();
+        end_pos_ -= (int64_t) g_.length(data_.back()) + gap_len_.back().gap;
+        start_pos_.pop_back();
+        if (start_pos_.empty())
+            end_pos_ = 0;
     }
 
     void NotifyFrontEdgeAdded(EdgeId e, Gap gap) {
@@ -527,12 +539,14 @@ private:
         }
         gap_len_.push_front(Gap(0, 0, 0));
 
-        int length = (int) g_.length(e);
-        if (cumulative_len_.empty()) {
-            cumulative_len_.push_front(length);
+        int64_t length = (int64_t) g_.length(e);
+        if (start_pos_.empty()) {
+            end_pos_ = length;
+            start_pos_.push_front(0);
         } else {
-            cumulative_len_.push_front(cumulative_len_.front() + length + gap.gap);
+            start_pos_.push_front(start_pos_.front() - length - gap.gap);
         }
+        ++version_;
         NotifyFrontEdgeAdded(e, gap);
     }
 
@@ -540,10 +554,13 @@ private:
         EdgeId e = data_.front();
         data_.pop_front();
         gap_len_.pop_front();
-        cumulative_len_.pop_front();
+        start_pos_.pop_front();
+        if (start_pos_.empty())
+            end_pos_ = 0;
         if (!gap_len_.empty()) {
             gap_len_.front() = Gap();
         }
+        ++version_;
 
         NotifyFrontEdgeRemoved(e);
     }
@@ -0,0 +1,262 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+#include "assembly_graph/dijkstra/dijkstra_algorithm.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace omnigraph {
+
+/*
+ * Lengths of the paths from a fixed start vertex, the same as PathProcessor
+ * with DistancesLengthsCallback gives (bounded Dijkstra from the start, then
+ * backward dfs from every end vertex with the same limits), but the object is
+ * meant to be reused: Dijkstra is rerun only when the start or the bound
+ * changes, so all queries for the same start share it.
+ *
+ * Per-vertex state lives in a small open addressing table instead of maps.
+ * The number of vertices reached by Dijkstra is limited, so the table stays
+ * small whatever the size of the graph. Entries are invalidated by bumping
+ * the stamp, so nothing is cleared between runs.
+ *
+ * Not thread safe, every thread should have its own finder.
+ */
+template<class Graph>
+class PathLengthsFinder {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef element_t<Graph> QueueElement;
+
+    struct Slot {
+        size_t id;
+        size_t distance;
+        uint32_t stamp;
+        uint32_t usage;
+    };
+
+    static const size_t MAX_CALL_CNT = 3000;
+    static const size_t MAX_DIJKSTRA_VERTICES = 3000;
+    static const size_t MAX_VERTEX_USAGE = 5;
+    static const size_t INITIAL_SLOTS = 1 << 14;
+
+    const Graph &g_;
+
+    VertexId start_;
+    size_t length_bound_;
+    bool vertex_limit_exceeded_;
+
+    std::vector<Slot> slots_;
+    size_t used_;
+    uint32_t stamp_;
+
+    std::vector<QueueElement> queue_;
+
+    // dfs state
+    size_t min_len_, max_len_;
+    size_t curr_len_;
+    size_t call_cnt_;
+    std::vector<EdgeId> incoming_;
+    std::vector<size_t> *lengths_;
+
+    size_t SlotPos(size_t id) const {
+        return size_t((uint64_t(id) * 0x9E3779B97F4A7C15ull) >> 20) & (slots_.size() - 1);
+    }
+
+    Slot *Find(size_t id) {
+        for (size_t pos = SlotPos(id); ; pos = (pos + 1) & (slots_.size() - 1)) {
+            Slot &slot = slots_[pos];
+            if (slot.stamp != stamp_)
+                return nullptr;
+            if (slot.id == id)
+                return &slot;
+        }
+    }
+
+    const Slot *Find(size_t id) const {
+        return const_cast<PathLengthsFinder*>(this)->Find(id);
+    }
+
+    void Grow() {
+        std::vector<Slot> old(2 * slots_.size(), Slot{0, 0, 0, 0});
+        old.swap(slots_);
+        for (const Slot &slot : old) {
+            if (slot.stamp != stamp_)
+                continue;
+            size_t pos = SlotPos(slot.id);
+            while (slots_[pos].stamp == stamp_)
+                pos = (pos + 1) & (slots_.size() - 1);
+            slots_[pos] = slot;
+        }
+    }
+
+    void Insert(size_t id, size_t distance) {
+        if (2 * (used_ + 1) > slots_.size())
+            Grow();
+        size_t pos = SlotPos(id);
+        while (slots_[pos].stamp == stamp_)
+            pos = (pos + 1) & (slots_.size() - 1);
+        slots_[pos] = Slot{id, distance, stamp_, 0};
+        used_ += 1;
+    }
+
+    void NextStamp() {
+        used_ = 0;
+        if (++stamp_ != 0)
+            return;
+        for (Slot &slot : slots_)
+            slot.stamp = 0;
+        stamp_ = 1;
+    }
+
+    bool DistanceCounted(VertexId v) const {
+        return Find(g_.int_id(v)) != nullptr;
+    }
+
+    size_t GetDistance(VertexId v) const {
+        const Slot *slot = Find(g_.int_id(v));
+        VERIFY(slot);
+        return slot->distance;
+    }
+
+    uint32_t &Usage(VertexId v) {
+        Slot *slot = Find(g_.int_id(v));
+        VERIFY(slot);
+        return slot->usage;
+    }
+
+    // Same order of processing as in Dijkstra, so the vertex limit is hit at the same point
+    void RunDijkstra() {
+        NextStamp();
+        vertex_limit_exceeded_ = false;
+        size_t vertex_number = 0;
+        ReverseDistanceComparator<QueueElement> cmp;
+
+        queue_.clear();
+        queue_.push_back(QueueElement(0, start_, VertexId(0), EdgeId(0)));
+        while (!queue_.empty()) {
+            std::pop_heap(queue_.begin(), queue_.end(), cmp);
+            QueueElement next = queue_.back();
+            queue_.pop_back();
+
+            if (DistanceCounted(next.curr_vertex))
+                continue;
+            Insert(g_.int_id(next.curr_vertex), next.distance);
+
+            if (++vertex_number > MAX_DIJKSTRA_VERTICES) {
+                vertex_limit_exceeded_ = true;
+                continue;
+            }
+            if (vertex_number >= MAX_DIJKSTRA_VERTICES || next.distance > length_bound_)
+                continue;
+
+            for (EdgeId e : g_.OutgoingEdges(next.curr_vertex)) {
+                VertexId v = g_.EdgeEnd(e);
+                if (DistanceCounted(v))
+                    continue;
+                size_t distance = next.distance + g_.length(e);
+                if (distance <= length_bound_) {
+                    queue_.push_back(QueueElement(distance, v, next.curr_vertex, e));
+                    std::push_heap(queue_.begin(), queue_.end(), cmp);
+                }
+            }
+        }
+    }
+
+    //returns true iff limits were exceeded
+    bool Go(VertexId v) {
+        if (++call_cnt_ >= MAX_CALL_CNT)
+            return true;
+
+        if (v == start_ && curr_len_ >= min_len_)
+            lengths_->push_back(curr_len_);
+
+        // Incoming edges of all the vertices on the current path share the buffer
+        size_t begin = incoming_.size();
+        for (EdgeId e : g_.IncomingEdges(v))
+            if (DistanceCounted(g_.EdgeStart(e)))
+                incoming_.push_back(e);
+        size_t end = incoming_.size();
+
+        std::sort(incoming_.begin() + begin, incoming_.end(), [&] (EdgeId e1, EdgeId e2) {
+            return GetDistance(g_.EdgeStart(e1)) < GetDistance(g_.EdgeStart(e2));
+        });
+
+        bool exceeded_limits = false;
+        for (size_t i = begin; i < end && !exceeded_limits; ++i) {
+            EdgeId e = incoming_[i];
+            VertexId start_v = g_.EdgeStart(e);
+            size_t len = g_.length(e);
+            if (GetDistance(start_v) + len + curr_len_ > max_len_)
+                continue;
+            uint32_t &usage = Usage(start_v);
+            if (usage >= MAX_VERTEX_USAGE)
+                continue;
+
+            curr_len_ += len;
+            usage += 1;
+            exceeded_limits = Go(start_v);
+            Usage(start_v) -= 1;
+            curr_len_ -= len;
+        }
+        incoming_.resize(begin);
+        return exceeded_limits;
+    }
+
+public:
+    PathLengthsFinder(const Graph &g)
+            : g_(g), start_(0), length_bound_(0), vertex_limit_exceeded_(false),
+              slots_(INITIAL_SLOTS, Slot{0, 0, 0, 0}), used_(0), stamp_(0),
+              min_len_(0), max_len_(0), curr_len_(0), call_cnt_(0), lengths_(nullptr) {}
+
+    /**
+     * Sets the start vertex and the upper bound of path lengths,
+     * Dijkstra is rerun only if they differ from the previous ones.
+     */
+    void SetStart(VertexId start, size_t length_bound) {
+        if (stamp_ != 0 && start == start_ && length_bound == length_bound_)
+            return;
+        start_ = start;
+        length_bound_ = length_bound;
+        RunDijkstra();
+    }
+
+    bool VertexLimitExceeded() const {
+        return vertex_limit_exceeded_;
+    }
+
+    /**
+     * Fills sorted distinct lengths of paths from the start vertex to the end one
+     * which lie in [min_len, max_len]. Returns true iff dfs limits were exceeded.
+     */
+    bool Process(VertexId end, size_t min_len, size_t max_len, std::vector<size_t> &lengths) {
+        lengths.clear();
+        if (!DistanceCounted(end) || GetDistance(end) > max_len)
+            return false;
+
+        min_len_ = min_len;
+        max_len_ = max_len;
+        curr_len_ = 0;
+        call_cnt_ = 0;
+        lengths_ = &lengths;
+        incoming_.clear();
+
+        Usage(end) += 1;
+        bool code = Go(end);
+        Usage(end) -= 1;
+        VERIFY(curr_len_ == 0);
+
+        std::sort(lengths.begin(), lengths.end());
+        lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+        return code;
+    }
+};
+
+}
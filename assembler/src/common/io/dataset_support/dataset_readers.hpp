@@ -21,11 +21,12 @@ PairedStreamPtr paired_easy_reader(const SequencingLibrary<debruijn_graph::confi
                                    size_t insert_size,
                                    bool change_read_order = false,
                                    bool use_orientation = true,
-                                   OffsetType offset_type = PhredOffset) {
+                                   OffsetType offset_type = PhredOffset,
+                                   unsigned gz_threads = 1) {
     ReadStreamList<PairedRead> streams;
     for (auto read_pair : lib.paired_reads()) {
         streams.push_back(PairedEasyStream(read_pair.first, read_pair.second, followed_by_rc, insert_size, change_read_order,
-                                           use_orientation, lib.orientation(), offset_type));
+                                           use_orientation, lib.orientation(), offset_type, gz_threads));
     }
     return MultifileWrap<PairedRead>(streams);
 }
@@ -35,16 +36,17 @@ ReadStreamList<SingleRead> single_easy_readers(const SequencingLibrary<debruijn_
                                                bool followed_by_rc,
                                                bool including_paired_reads,
                                                bool handle_Ns = true,
-                                               OffsetType offset_type = PhredOffset) {
+                                               OffsetType offset_type = PhredOffset,
+                                               unsigned gz_threads = 1) {
     ReadStreamList<SingleRead> streams;
     if (including_paired_reads) {
       for (const auto& read : lib.reads()) {
         //do we need input_file function here?
-        streams.push_back(EasyStream(read, followed_by_rc, handle_Ns, offset_type));
+        streams.push_back(EasyStream(read, followed_by_rc, handle_Ns, offset_type, gz_threads));
       }
     } else {
       for (const auto& read : lib.single_reads()) {
-        streams.push_back(EasyStream(read, followed_by_rc, handle_Ns, offset_type));
+        streams.push_back(EasyStream(read, followed_by_rc, handle_Ns, offset_type, gz_threads));
       }
     }
     return streams;
@@ -55,9 +57,10 @@ SingleStreamPtr single_easy_reader(const SequencingLibrary<debruijn_graph::confi
                                    bool followed_by_rc,
                                    bool including_paired_reads,
                                    bool handle_Ns = true,
-                                   OffsetType offset_type = PhredOffset) {
+                                   OffsetType offset_type = PhredOffset,
+                                   unsigned gz_threads = 1) {
     return MultifileWrap<io::SingleRead>(
-           single_easy_readers(lib, followed_by_rc, including_paired_reads, handle_Ns, offset_type));
+           single_easy_readers(lib, followed_by_rc, including_paired_reads, handle_Ns, offset_type, gz_threads));
 }
 
 inline
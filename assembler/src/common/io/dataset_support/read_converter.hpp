@@ -30,7 +30,7 @@ typedef SequencingLibrary<DataSetData> SequencingLibraryT;
 class ReadConverter {
 
 private:
-    const static size_t current_binary_format_version = 11;
+    const static size_t current_binary_format_version = 12;
 
     static bool CheckBinaryReadsExist(SequencingLibraryT& lib) {
         return fs::FileExists(lib.data().binary_reads_info.bin_reads_info_file);
@@ -46,20 +46,16 @@ private:
         info.open(data.binary_reads_info.bin_reads_info_file.c_str(), std::ios_base::in);
         DEBUG("Reading binary information file " << data.binary_reads_info.bin_reads_info_file);
 
-        size_t chunk_num = 0;
         size_t format = 0;
         size_t lib_index = 0;
 
         info >> format;
-        if (!info.eof()) {
-            info >> chunk_num;
-        }
         if (!info.eof()) {
             info >> lib_index;
         }
 
-        if (chunk_num != data.binary_reads_info.chunk_num ||
-            format != current_binary_format_version ||
+        // Binary reads are independent of the number of chunks they are read in
+        if (format != current_binary_format_version ||
             lib_index != data.lib_index) {
             return false;
         }
@@ -78,25 +74,25 @@ private:
         auto& data = lib.data();
         std::ofstream info;
         info.open(data.binary_reads_info.bin_reads_info_file.c_str(), std::ios_base::out);
-        info << "0 0 0";
+        info << "0 0";
         info.close();
 
         INFO("Converting reads to binary format for library #" << data.lib_index << " (takes a while)");
+        //Files are read one after another, so each of them may use the whole thread budget
+        //for decompression (the two files of a pair are read simultaneously)
+        unsigned gz_threads = (unsigned) std::max(data.binary_reads_info.chunk_num, size_t(1));
         INFO("Converting paired reads");
-        PairedStreamPtr paired_reader = paired_easy_reader(lib, false, 0, false, false);
-        BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix,
-                                          data.binary_reads_info.chunk_num,
-                                          data.binary_reads_info.buffer_size);
+        PairedStreamPtr paired_reader = paired_easy_reader(lib, false, 0, false, false, PhredOffset,
+                                                           std::max(gz_threads / 2, 1u));
+        BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix);
 
         ReadStreamStat paired_stat = paired_converter.ToBinary(*paired_reader, lib.orientation());
         paired_stat.read_count_ *= 2;
 
         INFO("Converting single reads");
 
-        SingleStreamPtr single_reader = single_easy_reader(lib, false, false);
-        BinaryWriter single_converter(data.binary_reads_info.single_read_prefix,
-                                          data.binary_reads_info.chunk_num,
-                                          data.binary_reads_info.buffer_size);
+        SingleStreamPtr single_reader = single_easy_reader(lib, false, false, true, PhredOffset, gz_threads);
+        BinaryWriter single_converter(data.binary_reads_info.single_read_prefix);
         ReadStreamStat single_stat = single_converter.ToBinary(*single_reader);
 
         paired_stat.merge(single_stat);
@@ -106,7 +102,6 @@ private:
 
         info.open(data.binary_reads_info.bin_reads_info_file.c_str(), std::ios_base::out);
         info << current_binary_format_version << " " <<
-            data.binary_reads_info.chunk_num << " " <<
             data.lib_index << " " <<
             data.read_length << " " <<
             data.read_count << " " <<
@@ -141,7 +136,7 @@ BinaryPairedStreams raw_paired_binary_readers(SequencingLibraryT &lib,
     ReadStreamList<PairedReadSeq> paired_streams;
     for (size_t i = 0; i < data.binary_reads_info.chunk_num; ++i) {
         paired_streams.push_back(make_shared<BinaryFilePairedStream>(data.binary_reads_info.paired_read_prefix,
-                                                                         i, insert_size));
+                                                                         insert_size, i, data.binary_reads_info.chunk_num));
     }
     return apply_paired_wrappers(followed_by_rc, paired_streams);
 }
@@ -156,13 +151,14 @@ BinarySingleStreams raw_single_binary_readers(SequencingLibraryT &lib,
 
     BinarySingleStreams single_streams;
     for (size_t i = 0; i < data.binary_reads_info.chunk_num; ++i) {
-        single_streams.push_back(make_shared<BinaryFileSingleStream>(data.binary_reads_info.single_read_prefix, i));
+        single_streams.push_back(make_shared<BinaryFileSingleStream>(data.binary_reads_info.single_read_prefix,
+                                                                         i, data.binary_reads_info.chunk_num));
     }
     if (including_paired_reads) {
         BinaryPairedStreams paired_streams;
         for (size_t i = 0; i < data.binary_reads_info.chunk_num; ++i) {
             paired_streams.push_back(make_shared<BinaryFilePairedStream>(data.binary_reads_info.paired_read_prefix,
-                                                                             i, 0));
+                                                                             0, i, data.binary_reads_info.chunk_num));
         }
 
         return apply_single_wrappers(followed_by_rc, single_streams, &paired_streams);
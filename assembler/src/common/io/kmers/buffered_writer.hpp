@@ -0,0 +1,152 @@
+//***************************************************************************
+//* Copyright (c) 2015 Saint Petersburg State University
+//* Copyright (c) 2011-2014 Saint Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#ifndef HAMMER_BUFFERED_WRITER_HPP
+#define HAMMER_BUFFERED_WRITER_HPP
+
+#include "common/utils/verify.hpp"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// Sequential writer with a large user-space buffer. File is opened once and
+// data goes to disk in buffer-sized chunks. In async mode the buffer is
+// double-buffered: one half is filled while the other is written in background.
+class BufferedWriter {
+    int StreamFile;
+    std::unique_ptr<uint8_t[]> Buffer, BackBuffer;
+    size_t BufSize, BufOffset, BytesWritten;
+    bool Async;
+    std::future<void> PendingFlush;
+
+    BufferedWriter(const BufferedWriter &) = delete;
+
+    static void WriteAll(int fd, const uint8_t *buf, size_t amount) {
+        while (amount) {
+            ssize_t res = ::write(fd, buf, amount);
+            if (res == -1 && errno == EINTR)
+                continue;
+            VERIFY_MSG(res != -1,
+                       "write(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
+            buf += res;
+            amount -= res;
+        }
+    }
+
+    void WaitFlush() {
+        if (PendingFlush.valid())
+            PendingFlush.get();
+    }
+
+    void FlushBuffer() {
+        if (!BufOffset)
+            return;
+
+        if (!Async) {
+            WriteAll(StreamFile, Buffer.get(), BufOffset);
+        } else {
+            WaitFlush();
+            std::swap(Buffer, BackBuffer);
+            PendingFlush = std::async(std::launch::async, WriteAll,
+                                      StreamFile, BackBuffer.get(), BufOffset);
+        }
+        BufOffset = 0;
+    }
+
+public:
+    static const size_t DefaultBufferSize = 16 * 1024 * 1024;
+
+    BufferedWriter(const std::string &FileName,
+                   size_t BufferSize = DefaultBufferSize, bool async = false, bool append = false)
+            : StreamFile(-1), BufSize(BufferSize), BufOffset(0), BytesWritten(0), Async(async) {
+        VERIFY(BufferSize);
+        StreamFile = ::open(FileName.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), (mode_t) 0660);
+        VERIFY_MSG(StreamFile != -1,
+                   "open(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
+        // Buffers are left uninitialized, so untouched pages are never faulted in
+        Buffer.reset(new uint8_t[BufSize]);
+        if (Async)
+            BackBuffer.reset(new uint8_t[BufSize]);
+    }
+
+    virtual ~BufferedWriter() {
+        close();
+    }
+
+    void write(const void *buf, size_t amount) {
+        const uint8_t *data = (const uint8_t *) buf;
+        BytesWritten += amount;
+
+        // Fast path for small records
+        if (BufOffset + amount < BufSize) {
+            memcpy(Buffer.get() + BufOffset, data, amount);
+            BufOffset += amount;
+            return;
+        }
+
+        // Large chunks bypass the buffer
+        if (!Async && amount >= BufSize) {
+            FlushBuffer();
+            WriteAll(StreamFile, data, amount);
+            return;
+        }
+
+        while (amount) {
+            size_t chunk = std::min(amount, BufSize - BufOffset);
+            memcpy(Buffer.get() + BufOffset, data, chunk);
+            BufOffset += chunk;
+            data += chunk;
+            amount -= chunk;
+
+            if (BufOffset == BufSize)
+                FlushBuffer();
+        }
+    }
+
+    // Pushes all buffered data to the file and waits for pending background write
+    void flush() {
+        FlushBuffer();
+        WaitFlush();
+    }
+
+    void close() {
+        if (StreamFile == -1)
+            return;
+
+        flush();
+        ::close(StreamFile);
+        StreamFile = -1;
+    }
+
+    size_t written() const { return BytesWritten; }
+};
+
+template<typename T>
+class BufferedRecordArrayWriter : public BufferedWriter {
+    size_t elcnt_;
+public:
+    BufferedRecordArrayWriter(const std::string &FileName, size_t elcnt = 1,
+                              size_t BufSize = DefaultBufferSize, bool async = false, bool append = false) :
+            BufferedWriter(FileName, BufSize, async, append), elcnt_(elcnt) { }
+
+    void write(const T *el, size_t amount) {
+        BufferedWriter::write((const void *) el, amount * sizeof(T) * elcnt_);
+    }
+
+    size_t size() const { return written() / sizeof(T) / elcnt_; }
+};
+
+#endif // HAMMER_BUFFERED_WRITER_HPP
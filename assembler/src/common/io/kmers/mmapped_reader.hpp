@@ -103,6 +103,20 @@ public:
         BlockOffset = BytesRead = 0;
     }
 
+    // Anonymous writable region of given size, not backed by any file
+    explicit MMappedReader(size_t sz)
+            : StreamFile(-1), Unlink(false), FileName(""), FileSize(sz), BlockOffset(0), BytesRead(0),
+              BlockSize(sz), InitialOffset(0) {
+        if (BlockSize) {
+            MappedRegion =
+                    (uint8_t *) mmap(NULL, BlockSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                                     -1, 0);
+            VERIFY_MSG((intptr_t) MappedRegion != -1L,
+                       "mmap(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
+        } else
+            MappedRegion = NULL;
+    }
+
     MMappedReader(MMappedReader &&other) {
         // First, copy out the stuff
         MappedRegion = other.MappedRegion;
@@ -301,6 +315,12 @@ public:
         VERIFY(FileSize % (sizeof(T) * elcnt_) == 0);
     }
 
+    // In-memory array of sz bytes, see MMappedReader(size_t)
+    MMappedRecordArrayReader(size_t elcnt, size_t sz) :
+            MMappedReader(sz), elcnt_(elcnt) {
+        VERIFY(FileSize % (sizeof(T) * elcnt_) == 0);
+    }
+
     void read(T *el, size_t amount) {
         MMappedReader::read(el, amount * sizeof(T) * elcnt_);
     }
@@ -0,0 +1,260 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+#include "ireader.hpp"
+#include "single_read.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+namespace io {
+
+namespace binary {
+
+/*
+ * Block-indexed storage of converted reads. Records (single reads or pairs)
+ * are packed into blocks, each of them could be decoded on its own. The block
+ * index allows any number of streams to read disjoint ranges of the file.
+ *
+ * File layout:
+ *   header: magic, ReadStreamStat, number of blocks, offset of the index
+ *   blocks: reads as varint length and offsets followed by the nucleotides, 4 per byte
+ *   index:  offset and totals of preceding records for every block and the
+ *           final sentinel, so the stats of any range of blocks are known
+ */
+static const uint64_t BlockFileMagic = 0x3244524e49425053ULL; // "SPBINRD2"
+
+struct BlockIndexEntry {
+    uint64_t offset;
+    uint64_t first_record;
+    uint64_t total_len;
+    // Maximal record length in the block preceding the entry
+    uint64_t max_len;
+};
+
+class BlockFileWriter {
+    std::ofstream file_;
+    size_t block_size_;
+    std::vector<uint8_t> block_;
+    std::vector<BlockIndexEntry> index_;
+    std::vector<seq_element_type> packed_;
+    uint64_t offset_;
+    ReadStreamStat stat_;
+    size_t record_len_, record_nucls_, block_max_len_;
+
+    void PutVarint(uint64_t v) {
+        while (v >= 0x80) {
+            block_.push_back(uint8_t(v | 0x80));
+            v >>= 7;
+        }
+        block_.push_back(uint8_t(v));
+    }
+
+    void WriteHeader(const ReadStreamStat &stat, uint64_t blocks, uint64_t index_offset) {
+        file_.write((const char*)&BlockFileMagic, sizeof(BlockFileMagic));
+        stat.write(file_);
+        file_.write((const char*)&blocks, sizeof(blocks));
+        file_.write((const char*)&index_offset, sizeof(index_offset));
+    }
+
+    void FlushBlock() {
+        if (block_.empty())
+            return;
+
+        file_.write((const char*)block_.data(), block_.size());
+        offset_ += block_.size();
+        block_.clear();
+        index_.push_back({ offset_, stat_.read_count_, stat_.total_len_, block_max_len_ });
+        block_max_len_ = 0;
+    }
+
+public:
+    static const size_t DefaultBlockSize = 1 << 18;
+
+    BlockFileWriter(const std::string &filename, size_t block_size = DefaultBlockSize)
+            : file_(filename, std::ios_base::binary), block_size_(block_size),
+              record_len_(0), record_nucls_(0), block_max_len_(0) {
+        VERIFY_MSG(file_.is_open(), "Cannot open binary reads file " << filename);
+        WriteHeader(stat_, 0, 0);
+        offset_ = file_.tellp();
+        index_.push_back({ offset_, 0, 0, 0 });
+        block_.reserve(block_size_ + block_size_ / 4);
+    }
+
+    // Writes one read of the current record, reverse complemented if needed
+    template<class SingleReadT>
+    void Write(const SingleReadT &r, bool rc = false) {
+        Sequence seq = r.sequence();
+        SequenceOffsetT left = r.GetLeftOffset(), right = r.GetRightOffset();
+        if (rc) {
+            seq = !seq;
+            std::swap(left, right);
+        }
+
+        size_t size = seq.size();
+        record_len_ = std::max(record_len_, size);
+        record_nucls_ += size;
+        PutVarint(size);
+        PutVarint(left);
+        PutVarint(right);
+
+        packed_.resize(Sequence::PackedSize(size));
+        seq.CopyPackedData(packed_.data());
+        size_t bytes = (size + 3) / 4, offset = block_.size();
+        block_.resize(offset + bytes);
+        memcpy(block_.data() + offset, packed_.data(), bytes);
+    }
+
+    // Records never cross block boundaries
+    void EndRecord() {
+        stat_.read_count_ += 1;
+        stat_.max_len_ = std::max(stat_.max_len_, record_len_);
+        stat_.total_len_ += record_nucls_;
+        block_max_len_ = std::max(block_max_len_, record_len_);
+        record_len_ = record_nucls_ = 0;
+
+        if (block_.size() >= block_size_)
+            FlushBlock();
+    }
+
+    void Close() {
+        FlushBlock();
+
+        uint64_t index_offset = offset_;
+        file_.write((const char*)index_.data(), index_.size() * sizeof(index_[0]));
+        file_.seekp(0);
+        WriteHeader(stat_, index_.size() - 1, index_offset);
+        file_.close();
+        VERIFY_MSG(!file_.fail(), "Failed to write binary reads file");
+    }
+
+    // Stats of the records written so far, a record is either a single read or a pair
+    const ReadStreamStat &stat() const {
+        return stat_;
+    }
+};
+
+class BlockFileReader {
+    std::ifstream file_;
+    std::vector<BlockIndexEntry> index_;
+    size_t begin_, end_, current_;
+    std::vector<uint8_t> block_;
+    const uint8_t *pos_, *block_end_;
+    std::vector<seq_element_type> packed_;
+
+    uint64_t GetVarint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; ; shift += 7) {
+            VERIFY(pos_ < block_end_);
+            uint8_t b = *pos_++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+    }
+
+    void LoadBlock() {
+        const BlockIndexEntry &start = index_[current_], &end = index_[current_ + 1];
+        block_.resize(end.offset - start.offset);
+        file_.seekg(start.offset);
+        file_.read((char*)block_.data(), block_.size());
+        VERIFY_MSG(!file_.fail(), "Truncated binary reads file");
+        pos_ = block_.data();
+        block_end_ = pos_ + block_.size();
+        current_ += 1;
+    }
+
+public:
+    // Opens part 'part' of 'part_num' roughly equal parts of the file
+    BlockFileReader(const std::string &filename, size_t part = 0, size_t part_num = 1)
+            : file_(filename, std::ios_base::binary | std::ios_base::in),
+              begin_(0), end_(0), current_(0), pos_(NULL), block_end_(NULL) {
+        if (!file_.is_open())
+            return;
+
+        uint64_t magic = 0, blocks = 0, index_offset = 0;
+        file_.read((char*)&magic, sizeof(magic));
+        VERIFY_MSG(magic == BlockFileMagic, "Invalid binary reads file " << filename);
+        ReadStreamStat().read(file_);
+        file_.read((char*)&blocks, sizeof(blocks));
+        file_.read((char*)&index_offset, sizeof(index_offset));
+
+        index_.resize(blocks + 1);
+        file_.seekg(index_offset);
+        file_.read((char*)index_.data(), index_.size() * sizeof(index_[0]));
+        VERIFY_MSG(!file_.fail(), "Truncated binary reads file " << filename);
+
+        VERIFY(part < part_num);
+        begin_ = blocks * part / part_num;
+        end_ = blocks * (part + 1) / part_num;
+        reset();
+    }
+
+    bool is_open() const {
+        return file_.is_open();
+    }
+
+    bool eof() const {
+        return pos_ == block_end_ && current_ == end_;
+    }
+
+    void reset() {
+        file_.clear();
+        current_ = begin_;
+        pos_ = block_end_ = NULL;
+    }
+
+    void close() {
+        file_.close();
+    }
+
+    // Stats of the part
+    ReadStreamStat stat() const {
+        ReadStreamStat stat;
+        if (index_.empty())
+            return stat;
+
+        stat.read_count_ = index_[end_].first_record - index_[begin_].first_record;
+        stat.total_len_ = index_[end_].total_len - index_[begin_].total_len;
+        for (size_t i = begin_; i < end_; ++i)
+            stat.max_len_ = std::max(stat.max_len_, size_t(index_[i + 1].max_len));
+        return stat;
+    }
+
+    // Number of records in the part
+    size_t size() const {
+        return index_.empty() ? 0 : index_[end_].first_record - index_[begin_].first_record;
+    }
+
+    template<class SingleReadT>
+    void Read(SingleReadT &r) {
+        VERIFY(!eof());
+        if (pos_ == block_end_)
+            LoadBlock();
+
+        size_t size = GetVarint();
+        SequenceOffsetT left = SequenceOffsetT(GetVarint());
+        SequenceOffsetT right = SequenceOffsetT(GetVarint());
+
+        size_t bytes = (size + 3) / 4;
+        VERIFY(bytes <= size_t(block_end_ - pos_));
+        packed_.assign(Sequence::PackedSize(size), 0);
+        memcpy(packed_.data(), pos_, bytes);
+        pos_ += bytes;
+
+        r = SingleReadT(Sequence(static_cast<const seq_element_type*>(packed_.data()), size), left, right);
+    }
+};
+
+}
+
+}
@@ -7,69 +7,57 @@
 
 #pragma once
 
-#include <fstream>
+#include <string>
 
 #include "utils/verify.hpp"
 #include "ireader.hpp"
 #include "single_read.hpp"
 #include "paired_read.hpp"
+#include "binary_blocks.hpp"
 
 namespace io {
 
 // == Deprecated classes ==
 // Use FileReadStream and InsertSizeModyfing instead
 
+// Streams part 'part' of 'part_num' of the binary reads file written by BinaryWriter
 class BinaryFileSingleStream: public PredictableReadStream<SingleReadSeq> {
 private:
-    std::ifstream stream_;
-    ReadStreamStat read_stat_;
-    size_t current_;
+    binary::BlockFileReader reader_;
 
 public:
 
-    BinaryFileSingleStream(const std::string& file_name_prefix, size_t file_num) {
-        std::string fname;
-        fname = file_name_prefix + "_" + std::to_string(file_num) + ".seq";
-        stream_.open(fname.c_str(), std::ios_base::binary | std::ios_base::in);
-
-        reset();
+    BinaryFileSingleStream(const std::string& file_name_prefix, size_t part = 0, size_t part_num = 1)
+            : reader_(file_name_prefix + ".seq", part, part_num) {
     }
 
     virtual bool is_open() {
-        return stream_.is_open();
+        return reader_.is_open();
     }
 
     virtual bool eof() {
-        return current_ == read_stat_.read_count_;
+        return reader_.eof();
     }
 
     virtual BinaryFileSingleStream& operator>>(SingleReadSeq& read) {
-        read.BinRead(stream_);
-        VERIFY(current_ < read_stat_.read_count_);
-
-        ++current_;
+        reader_.Read(read);
         return *this;
     }
 
     virtual void close() {
-        current_ = 0;
-        stream_.close();
+        reader_.close();
     }
 
     virtual void reset() {
-        stream_.clear();
-        stream_.seekg(0);
-        VERIFY(stream_.good());
-        read_stat_.read(stream_);
-        current_ = 0;
+        reader_.reset();
     }
 
     virtual size_t size() const {
-        return read_stat_.read_count_;
+        return reader_.size();
     }
 
     virtual ReadStreamStat get_stat() const {
-        return read_stat_;
+        return reader_.stat();
     }
 
 };
@@ -77,61 +65,50 @@ public:
 class BinaryFilePairedStream: public PredictableReadStream<PairedReadSeq> {
 
 private:
-    std::ifstream stream_;
+    binary::BlockFileReader reader_;
 
     size_t insert_size_;
 
-    ReadStreamStat read_stat_;
-
-    size_t current_;
-
-
 public:
 
-    BinaryFilePairedStream(const std::string& file_name_prefix, size_t file_num, size_t insert_szie): stream_(), insert_size_ (insert_szie) {
-        std::string fname;
-        fname = file_name_prefix + "_" + std::to_string(file_num) + ".seq";
-        stream_.open(fname.c_str(), std::ios_base::binary | std::ios_base::in);
-
-        reset();
+    BinaryFilePairedStream(const std::string& file_name_prefix, size_t insert_size,
+                           size_t part = 0, size_t part_num = 1)
+            : reader_(file_name_prefix + ".seq", part, part_num), insert_size_(insert_size) {
     }
 
     virtual bool is_open() {
-        return stream_.is_open();
+        return reader_.is_open();
     }
 
     virtual bool eof() {
-        return current_ >= read_stat_.read_count_;
+        return reader_.eof();
     }
 
     virtual BinaryFilePairedStream& operator>>(PairedReadSeq& read) {
-        read.BinRead(stream_, insert_size_);
-        VERIFY(current_ < read_stat_.read_count_);
+        SingleReadSeq first, second;
+        reader_.Read(first);
+        reader_.Read(second);
 
-        ++current_;
+        read = PairedReadSeq(first, second,
+                             insert_size_ - (size_t) first.GetLeftOffset() - (size_t) second.GetRightOffset());
         return *this;
     }
 
     virtual void close() {
-        current_ = 0;
-        stream_.close();
+        reader_.close();
     }
 
 
     virtual void reset() {
-        stream_.clear();
-        stream_.seekg(0);
-        VERIFY(stream_.good());
-        read_stat_.read(stream_);
-        current_ = 0;
+        reader_.reset();
     }
 
     virtual size_t size() const {
-        return read_stat_.read_count_;
+        return reader_.size();
     }
 
     ReadStreamStat get_stat() const {
-        ReadStreamStat stat = read_stat_;
+        ReadStreamStat stat = reader_.stat();
         stat.read_count_ *= 2;
         return stat;
     }
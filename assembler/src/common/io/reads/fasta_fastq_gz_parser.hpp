@@ -26,12 +26,12 @@
 #ifndef COMMON_IO_FASTAFASTQGZPARSER_HPP
 #define COMMON_IO_FASTAFASTQGZPARSER_HPP
 
-#include <zlib.h>
 #include <string>
 #include "kseq/kseq.h"
 #include "utils/verify.hpp"
 #include "single_read.hpp"
 #include "io/reads/parser.hpp"
+#include "io/reads/parallel_gz_reader.hpp"
 #include "sequence/quality.hpp"
 #include "sequence/nucl.hpp"
 
@@ -43,7 +43,7 @@ namespace fastafastqgz {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
 // STEP 1: declare the type of file handler and the read() function
-KSEQ_INIT(gzFile, gzread)
+KSEQ_INIT(ParallelGzReader*, ParallelGzRead)
 #pragma GCC diagnostic pop
 }
 
@@ -54,10 +54,11 @@ public:
      *
      * @param filename The name of the file to be opened.
      * @param offset The offset of the read quality.
+     * @param gz_threads The number of threads decompressing the file.
      */
     FastaFastqGzParser(const std::string& filename, OffsetType offset_type =
-            PhredOffset) :
-            Parser(filename, offset_type), fp_(), seq_(NULL) {
+            PhredOffset, unsigned gz_threads = 1) :
+            Parser(filename, offset_type), gz_threads_(gz_threads), seq_(NULL) {
         open();
     }
 
@@ -109,7 +110,7 @@ public:
             // STEP 5: destroy seq
             fastafastqgz::kseq_destroy(seq_);
             // STEP 6: close the file handler
-            gzclose(fp_);
+            fp_.reset();
             is_open_ = false;
             eof_ = true;
         }
@@ -117,9 +118,13 @@ public:
 
 private:
     /*
-     * @variable File that is associated with gzipped data file.
+     * @variable The number of threads decompressing the data file.
      */
-    gzFile fp_;
+    unsigned gz_threads_;
+    /*
+     * @variable Reader decompressing the data file in background.
+     */
+    std::unique_ptr<ParallelGzReader> fp_;
     /*
      * @variable Data element that stores last SingleRead got from
      * stream.
@@ -132,13 +137,14 @@ private:
     /* virtual */
     void open() {
         // STEP 2: open the file handler
-        fp_ = gzopen(filename_.c_str(), "r");
-        if (!fp_) {
+        fp_.reset(new ParallelGzReader(filename_, gz_threads_));
+        if (!fp_->is_open()) {
+            fp_.reset();
             is_open_ = false;
             return;
         }
         // STEP 3: initialize seq
-        seq_ = fastafastqgz::kseq_init(fp_);
+        seq_ = fastafastqgz::kseq_init(fp_.get());
         eof_ = false;
         is_open_ = true;
         ReadAhead();
@@ -24,18 +24,19 @@ class SeparatePairedReadStream : public ReadStream<PairedRead> {
    * be opened.
    * @param distance Distance between parts of PairedReads.
    * @param offset The offset of the read quality.
+   * @param gz_threads The number of threads decompressing each of the files.
    */
   explicit SeparatePairedReadStream(const std::string& filename1, const std::string& filename2,
          size_t insert_size, bool change_order = false,
          bool use_orientation = true, LibraryOrientation orientation = LibraryOrientation::FR,
-         OffsetType offset_type = PhredOffset)
+         OffsetType offset_type = PhredOffset, unsigned gz_threads = 1)
       : insert_size_(insert_size),
         change_order_(change_order),
         use_orientation_(use_orientation),
         changer_(GetOrientationChanger<PairedRead>(orientation)),
         offset_type_(offset_type),
-        first_(new FileReadStream(filename1, offset_type_)),
-        second_(new FileReadStream(filename2, offset_type_)),
+        first_(new FileReadStream(filename1, offset_type_, gz_threads)),
+        second_(new FileReadStream(filename2, offset_type_, gz_threads)),
         filename1_(filename1),
         filename2_(filename2){}
 
@@ -150,16 +151,17 @@ class InterleavingPairedReadStream : public ReadStream<PairedRead> {
    * @param filename Single file
    * @param distance Distance between parts of PairedReads.
    * @param offset The offset of the read quality.
+   * @param gz_threads The number of threads decompressing the file.
    */
   explicit InterleavingPairedReadStream(const std::string& filename, size_t insert_size, bool change_order = false,
           bool use_orientation = true, LibraryOrientation orientation = LibraryOrientation::FR,
-          OffsetType offset_type = PhredOffset)
+          OffsetType offset_type = PhredOffset, unsigned gz_threads = 1)
       : filename_(filename), insert_size_(insert_size),
         change_order_(change_order),
         use_orientation_(use_orientation),
         changer_(GetOrientationChanger<PairedRead>(orientation)),
         offset_type_(offset_type),
-        single_(new FileReadStream(filename_, offset_type_)) {}
+        single_(new FileReadStream(filename_, offset_type_, gz_threads)) {}
 
   /*
    * Check whether the stream is opened.
@@ -0,0 +1,369 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace io {
+
+/*
+ * Background decompressing reader for (possibly gzipped) sequence files.
+ * Decompression runs on separate threads, so it overlaps with parsing of
+ * the already decompressed data. BGZF files (gzip members carrying the
+ * block size in the 'BC' extra subfield) are inflated block-parallel by
+ * a pool of worker threads; other gzip files and plain text are read by
+ * a single background thread via zlib. Output is always in file order.
+ * The input is never rewound, so pipes and FIFOs are fine.
+ */
+class ParallelGzReader {
+    struct Chunk {
+        std::vector<unsigned char> in;
+        // Offsets of BGZF blocks inside 'in', the last one is the end
+        std::vector<size_t> blocks;
+        std::vector<unsigned char> out;
+        bool ready;
+
+        Chunk() : ready(false) {}
+    };
+    typedef std::shared_ptr<Chunk> ChunkPtr;
+
+    static const size_t BlocksPerChunk = 16;
+    static const size_t StreamChunkSize = 1 << 20;
+    static const size_t BGZFHeaderSize = 18;
+
+    int fd_;
+    bool is_open_;
+    unsigned nthreads_;
+    size_t max_pending_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_, ready_cv_, space_cv_;
+    std::deque<ChunkPtr> pending_, todo_;
+    bool done_, stop_;
+
+    std::thread producer_;
+    std::vector<std::thread> workers_;
+
+    ChunkPtr current_;
+    size_t current_pos_;
+
+    ParallelGzReader(const ParallelGzReader &) = delete;
+    void operator=(const ParallelGzReader &) = delete;
+
+    size_t ReadFully(unsigned char *buf, size_t amount) {
+        size_t total = 0;
+        while (total < amount) {
+            ssize_t res = ::read(fd_, buf + total, amount - total);
+            if (res == -1 && errno == EINTR)
+                continue;
+            VERIFY_MSG(res != -1, "read(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
+            if (res <= 0)
+                break;
+            total += res;
+        }
+        return total;
+    }
+
+    // Returns BGZF block size if the header is a BGZF member header, 0 otherwise
+    static size_t BGZFBlockSize(const unsigned char *h) {
+        if (h[0] != 31 || h[1] != 139 || h[2] != 8 || !(h[3] & 4))
+            return 0;
+        // Only the layout with the single 'BC' subfield written by bgzip/htslib is recognized
+        if (h[10] != 6 || h[11] != 0 || h[12] != 'B' || h[13] != 'C' || h[14] != 2 || h[15] != 0)
+            return 0;
+        return (size_t(h[16]) | (size_t(h[17]) << 8)) + 1;
+    }
+
+    // Pushes the chunk to the ordered output, waiting for the consumer if too much is buffered
+    bool Enqueue(const ChunkPtr &chunk, bool inflate) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this] { return stop_ || pending_.size() < max_pending_; });
+        if (stop_)
+            return false;
+        pending_.push_back(chunk);
+        if (inflate) {
+            todo_.push_back(chunk);
+            work_cv_.notify_one();
+        } else
+            ready_cv_.notify_one();
+        return true;
+    }
+
+    void Finish() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        work_cv_.notify_all();
+        ready_cv_.notify_all();
+    }
+
+    // Reads BGZF blocks starting from 'header'. Returns false when the file
+    // ends, true if a non-BGZF member was encountered (it is left at the beginning of 'header')
+    bool ProduceBGZF(unsigned char *header, size_t &header_size) {
+        while (true) {
+            ChunkPtr chunk = std::make_shared<Chunk>();
+            while (chunk->blocks.size() < BlocksPerChunk) {
+                size_t bsize = BGZFBlockSize(header);
+                if (header_size < BGZFHeaderSize || !bsize)
+                    break;
+
+                size_t offset = chunk->in.size();
+                chunk->blocks.push_back(offset);
+                chunk->in.resize(offset + bsize);
+                memcpy(chunk->in.data() + offset, header, BGZFHeaderSize);
+                size_t rest = bsize - BGZFHeaderSize;
+                size_t read = ReadFully(chunk->in.data() + offset + BGZFHeaderSize, rest);
+                VERIFY_MSG(read == rest, "Truncated BGZF block");
+
+                header_size = ReadFully(header, BGZFHeaderSize);
+            }
+
+            if (!chunk->blocks.empty()) {
+                chunk->blocks.push_back(chunk->in.size());
+                if (!Enqueue(chunk, /*inflate*/true))
+                    return false;
+            }
+
+            if (header_size == 0)
+                return false;
+            if (header_size < BGZFHeaderSize || !BGZFBlockSize(header))
+                return true;
+        }
+    }
+
+    // Moves the unconsumed input to the front of the buffer and reads more, returns false at the end of file
+    bool Refill(z_stream &zs, std::vector<unsigned char> &in) {
+        memmove(in.data(), zs.next_in, zs.avail_in);
+        size_t size = zs.avail_in + ReadFully(in.data() + zs.avail_in, in.size() - zs.avail_in);
+        bool more = size > zs.avail_in;
+        zs.next_in = in.data();
+        zs.avail_in = (uInt)size;
+        return more;
+    }
+
+    static bool IsGzip(const z_stream &zs) {
+        return zs.avail_in >= 2 && zs.next_in[0] == 31 && zs.next_in[1] == 139;
+    }
+
+    // Decompresses the rest of the file with zlib, 'prefix' holds the bytes already read from it.
+    // Like gzread, concatenated gzip members are decompressed one after another,
+    // trailing garbage is ignored and the data without gzip header is passed as is
+    void ProduceStream(const unsigned char *prefix, size_t prefix_size) {
+        std::vector<unsigned char> in(StreamChunkSize);
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        memcpy(in.data(), prefix, prefix_size);
+        zs.next_in = in.data();
+        zs.avail_in = (uInt)prefix_size;
+        Refill(zs, in);
+
+        bool gzip = IsGzip(zs);
+        if (gzip) {
+            VERIFY_MSG(inflateInit2(&zs, 15 + 16) == Z_OK, "Cannot initialize zlib");
+        }
+
+        bool eof = false;
+        while (!eof) {
+            ChunkPtr chunk = std::make_shared<Chunk>();
+            if (!gzip) {
+                chunk->out.assign(zs.next_in, zs.next_in + zs.avail_in);
+                zs.avail_in = 0;
+                eof = !Refill(zs, in);
+            } else {
+                chunk->out.resize(StreamChunkSize);
+                zs.next_out = chunk->out.data();
+                zs.avail_out = (uInt)StreamChunkSize;
+                while (zs.avail_out && !eof) {
+                    if (!zs.avail_in && !Refill(zs, in)) {
+                        // Truncated member, gzread also returns the data decompressed so far
+                        eof = true;
+                        break;
+                    }
+                    int res = inflate(&zs, Z_NO_FLUSH);
+                    if (res == Z_STREAM_END) {
+                        if (zs.avail_in < 2)
+                            Refill(zs, in);
+                        if (!IsGzip(zs)) {
+                            eof = true;
+                            break;
+                        }
+                        VERIFY_MSG(inflateReset(&zs) == Z_OK, "Cannot initialize zlib");
+                        continue;
+                    }
+                    VERIFY_MSG(res == Z_OK || res == Z_BUF_ERROR, "Failed to decompress input file");
+                }
+                chunk->out.resize(StreamChunkSize - zs.avail_out);
+            }
+            chunk->ready = true;
+            if (chunk->out.empty())
+                continue;
+            if (!Enqueue(chunk, /*inflate*/false))
+                break;
+        }
+
+        if (gzip)
+            inflateEnd(&zs);
+    }
+
+    void Produce() {
+        unsigned char header[BGZFHeaderSize];
+        size_t header_size = ReadFully(header, BGZFHeaderSize);
+
+        if (header_size == BGZFHeaderSize && BGZFBlockSize(header)) {
+            for (unsigned i = 0; i < nthreads_; ++i)
+                workers_.emplace_back(&ParallelGzReader::Inflate, this);
+            if (ProduceBGZF(header, header_size))
+                ProduceStream(header, header_size);
+        } else if (header_size)
+            ProduceStream(header, header_size);
+
+        Finish();
+    }
+
+    static void InflateBlock(const unsigned char *in, size_t in_size, std::vector<unsigned char> &out) {
+        size_t xlen = size_t(in[10]) | (size_t(in[11]) << 8);
+        const unsigned char *footer = in + in_size - 8;
+        size_t isize = size_t(footer[4]) | (size_t(footer[5]) << 8) |
+                       (size_t(footer[6]) << 16) | (size_t(footer[7]) << 24);
+        uLong crc = uLong(footer[0]) | (uLong(footer[1]) << 8) |
+                    (uLong(footer[2]) << 16) | (uLong(footer[3]) << 24);
+
+        size_t offset = out.size();
+        out.resize(offset + isize);
+
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        VERIFY_MSG(inflateInit2(&zs, -15) == Z_OK, "Cannot initialize zlib");
+        zs.next_in = const_cast<unsigned char*>(in + 12 + xlen);
+        zs.avail_in = (uInt)(in_size - 12 - xlen - 8);
+        zs.next_out = out.data() + offset;
+        zs.avail_out = (uInt)isize;
+        int res = inflate(&zs, Z_FINISH);
+        inflateEnd(&zs);
+
+        VERIFY_MSG(res == Z_STREAM_END && zs.avail_out == 0, "Corrupted BGZF block");
+        VERIFY_MSG(crc32(crc32(0L, Z_NULL, 0), out.data() + offset, (uInt)isize) == crc,
+                   "BGZF block CRC mismatch");
+    }
+
+    bool Stopped() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stop_;
+    }
+
+    void Inflate() {
+        while (true) {
+            ChunkPtr chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_cv_.wait(lock, [this] { return stop_ || done_ || !todo_.empty(); });
+                if (todo_.empty())
+                    return;
+                chunk = todo_.front();
+                todo_.pop_front();
+            }
+
+            chunk->out.reserve(chunk->blocks.size() * 65536);
+            for (size_t i = 0; i + 1 < chunk->blocks.size(); ++i) {
+                // Nobody is going to read the rest
+                if (Stopped())
+                    return;
+                InflateBlock(chunk->in.data() + chunk->blocks[i],
+                             chunk->blocks[i + 1] - chunk->blocks[i], chunk->out);
+            }
+            std::vector<unsigned char>().swap(chunk->in);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunk->ready = true;
+            ready_cv_.notify_all();
+        }
+    }
+
+    // Moves to the next decompressed chunk, returns false at the end of file
+    bool NextChunk() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_cv_.wait(lock, [this] { return (!pending_.empty() && pending_.front()->ready) ||
+                                             (pending_.empty() && done_); });
+        if (pending_.empty())
+            return false;
+        current_ = pending_.front();
+        current_pos_ = 0;
+        pending_.pop_front();
+        space_cv_.notify_one();
+        return true;
+    }
+
+public:
+    // nthreads is the number of threads inflating BGZF blocks, the caller is responsible
+    // for fitting it into the thread budget
+    ParallelGzReader(const std::string &filename, unsigned nthreads = 1)
+            : fd_(-1), is_open_(false), nthreads_(std::max(nthreads, 1u)),
+              max_pending_(2 * nthreads_ + 2), done_(false), stop_(false), current_pos_(0) {
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if (fd_ == -1)
+            return;
+        is_open_ = true;
+        producer_ = std::thread(&ParallelGzReader::Produce, this);
+    }
+
+    ~ParallelGzReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            work_cv_.notify_all();
+            space_cv_.notify_all();
+        }
+        if (producer_.joinable())
+            producer_.join();
+        for (auto &worker : workers_)
+            worker.join();
+        if (fd_ != -1)
+            ::close(fd_);
+    }
+
+    bool is_open() const { return is_open_; }
+
+    // Reads up to len decompressed bytes, returns 0 at the end of file
+    int read(void *buf, unsigned len) {
+        unsigned char *out = (unsigned char*)buf;
+        unsigned total = 0;
+        while (total < len) {
+            if (!current_ || current_pos_ == current_->out.size()) {
+                if (total || !NextChunk())
+                    break;
+                continue;
+            }
+            size_t cnt = std::min(size_t(len - total), current_->out.size() - current_pos_);
+            memcpy(out + total, current_->out.data() + current_pos_, cnt);
+            current_pos_ += cnt;
+            total += (unsigned)cnt;
+        }
+        return (int)total;
+    }
+};
+
+// read() function for kseq
+inline int ParallelGzRead(ParallelGzReader *reader, void *buf, unsigned len) {
+    return reader->read(buf, len);
+}
+
+}
@@ -60,17 +60,19 @@ std::string GetExtension(const std::string& filename) {
  *
  * @param filename The name of the file to be opened.
  * @param offset The offset of the read quality.
+ * @param gz_threads The number of threads decompressing the file.
 
  * @return Pointer to the new parser object with these filename and
  * offset.
  */
 Parser* SelectParser(const std::string& filename,
-                     OffsetType offset_type /*= PhredOffset*/) {
+                     OffsetType offset_type /*= PhredOffset*/,
+                     unsigned gz_threads /*= 1*/) {
   std::string ext = GetExtension(filename);
   if (ext == "bam")
       return new BAMParser(filename, offset_type);
 
-  return new FastaFastqGzParser(filename, offset_type);
+  return new FastaFastqGzParser(filename, offset_type, gz_threads);
   /*
   if ((ext == "fastq") || (ext == "fastq.gz") ||
       (ext == "fasta") || (ext == "fasta.gz") ||
@@ -130,12 +130,14 @@ std::string GetExtension(const std::string &filename);
 *
 * @param filename The name of the file to be opened.
 * @param offset The offset of the read quality.
+* @param gz_threads The number of threads decompressing the file.
 
 * @return Pointer to the new parser object with these filename and
 * offset.
 */
 Parser *SelectParser(const std::string &filename,
-                     OffsetType offset_type = PhredOffset);
+                     OffsetType offset_type = PhredOffset,
+                     unsigned gz_threads = 1);
 
 //todo delete???
 void first_fun(int);
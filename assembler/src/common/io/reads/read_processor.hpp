@@ -12,6 +12,13 @@
 
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <sched.h>
+
 #pragma GCC diagnostic push
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wunused-private-field"
@@ -22,24 +29,107 @@ class ReadProcessor {
     typedef char cacheline_pad_t[cacheline_size];
 
     unsigned nthreads_;
+    size_t batch_size_;
     cacheline_pad_t pad0;
     size_t read_;
     cacheline_pad_t pad1;
     size_t processed_;
     cacheline_pad_t pad2;
 
-private:
+    // Reads are handed over to the workers in batches. Read objects stay in
+    // their batch and are overwritten by the next fill, so their buffers are reused.
+    template<class ReadT, class ResultT = bool>
+    struct Batch {
+        std::vector<ReadT> reads;
+        size_t size;
+        std::vector<ResultT> results;
+    };
+
+    // Fixed set of batches recycled through a free list
+    template<class BatchT>
+    class BatchPool {
+        std::vector<BatchT> batches_;
+        mpmc_bounded_queue<BatchT*> free_;
+
+    public:
+        BatchPool(size_t count, size_t batch_size)
+                : batches_(count), free_(RoundPow2(count)) {
+            for (auto &batch : batches_) {
+                batch.reads.resize(batch_size);
+                batch.size = 0;
+                free_.enqueue(&batch);
+            }
+        }
+
+        bool try_acquire(BatchT *&batch) {
+            return free_.dequeue(batch);
+        }
+
+        BatchT *acquire() {
+            BatchT *batch;
+            while (!free_.dequeue(batch))
+                sched_yield();
+            return batch;
+        }
+
+        void release(BatchT *batch) {
+            batch->size = 0;
+            free_.enqueue(batch);
+        }
+    };
+
+    static size_t RoundPow2(size_t n) {
+        size_t res = 2;
+        while (res < n)
+            res <<= 1;
+        return res;
+    }
+
+    // Operations taking the read by reference work directly on the batch
+    // storage. Operations taking std::unique_ptr get the read moved out into a
+    // separate object.
+    template<class Op, class ReadT>
+    static auto Process(Op &op, ReadT &r, int) -> decltype(op(r)) {
+        return op(r);
+    }
+
+    template<class Op, class ReadT>
+    static auto Process(Op &op, ReadT &r, long) -> decltype(op(std::unique_ptr<ReadT>())) {
+        return op(std::unique_ptr<ReadT>(new ReadT(std::move(r))));
+    }
+
+    // Reads are reset before filling since not every parser sets all the
+    // fields (e.g. no quality for FASTA). Filling ends early once stop is set.
+    template<class Reader, class BatchT>
+    static size_t Fill(Reader &irs, BatchT &batch, const std::atomic<bool> *stop = nullptr) {
+        typedef typename Reader::ReadT ReadT;
+
+        size_t cnt = 0;
+        while (cnt < batch.reads.size() && !irs.eof()) {
+            if (stop && stop->load(std::memory_order_relaxed))
+                break;
+
+            ReadT &r = batch.reads[cnt++];
+            r = ReadT();
+            irs >> r;
+        }
+        batch.size = cnt;
+
+        return cnt;
+    }
+
     template<class Reader, class Op>
     bool RunSingle(Reader &irs, Op &op) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        typedef typename Reader::ReadT ReadT;
+        ReadT r;
 
         while (!irs.eof()) {
-            ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-            irs >> *r;
+            r = ReadT();
+            irs >> r;
             read_ += 1;
 
             processed_ += 1;
-            if (op(std::move(r))) // Pass ownership of read down to processor
+            if (Process(op, r, 0))
                 return true;
         }
 
@@ -48,14 +138,15 @@ private:
 
     template<class Reader, class Op, class Writer>
     void RunSingle(Reader &irs, Op &op, Writer &writer) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        typedef typename Reader::ReadT ReadT;
+        ReadT r;
 
         while (!irs.eof()) {
-            ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-            irs >> *r;
+            r = ReadT();
+            irs >> r;
             read_ += 1;
 
-            auto res = op(std::move(r)); // Pass ownership of read down to processor
+            auto res = Process(op, r, 0);
             processed_ += 1;
 
             if (res)
@@ -63,142 +154,179 @@ private:
         }
     }
 
-public:
-    ReadProcessor(unsigned nthreads)
-            : nthreads_(nthreads), read_(0), processed_(0) { }
-
-    size_t read() const { return read_; }
-
-    size_t processed() const { return processed_; }
-
     template<class Reader, class Op>
-    bool Run(Reader &irs, Op &op) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+    bool RunParallel(const std::vector<Reader*> &readers, Op &op) {
+        typedef Batch<typename Reader::ReadT> BatchT;
 
-        if (nthreads_ < 2)
-            return RunSingle(irs, op);
-
-        // Round nthreads to next power of two
-        unsigned bufsize = nthreads_ - 1;
-        bufsize = (bufsize >> 1) | bufsize;
-        bufsize = (bufsize >> 2) | bufsize;
-        bufsize = (bufsize >> 4) | bufsize;
-        bufsize = (bufsize >> 8) | bufsize;
-        bufsize = (bufsize >> 16) | bufsize;
-        bufsize += 1;
+        // Parsing is usually much cheaper than processing, so only a quarter
+        // of threads (but at least one) is reading, each from its own file.
+        unsigned nproducers = (unsigned)std::min(readers.size(), size_t(std::max(nthreads_ / 4, 1u)));
 
-        mpmc_bounded_queue<ReadPtr> in_queue(2 * bufsize);
+        size_t bufsize = RoundPow2(nthreads_);
+        mpmc_bounded_queue<BatchT*> in_queue(2 * bufsize);
+        BatchPool<BatchT> pool(2 * bufsize + nthreads_, batch_size_);
 
-        bool stop = false;
-#   pragma omp parallel shared(in_queue, irs, op, stop) num_threads(nthreads_)
+        std::atomic<size_t> next_reader(0);
+        std::atomic<unsigned> producing(nproducers);
+        std::atomic<bool> stop(false);
+#   pragma omp parallel shared(in_queue, pool, next_reader, producing, readers, op, stop) num_threads(nthreads_)
         {
-#     pragma omp master
-            {
-                while (!irs.eof()) {
-                    ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-                    irs >> *r;
+            if ((unsigned)omp_get_thread_num() < nproducers) {
+                for (size_t i = next_reader++; !stop && i < readers.size(); i = next_reader++) {
+                    Reader &irs = *readers[i];
+                    while (!irs.eof() && !stop) {
+                        BatchT *batch = pool.acquire();
+                        size_t cnt = Fill(irs, *batch, &stop);
 #         pragma omp atomic
-                    read_ += 1;
-
-                    while (!in_queue.enqueue(std::move(r)))
-                        sched_yield();
+                        read_ += cnt;
 
-#         pragma omp flush (stop)
-                    if (stop)
-                        break;
+                        while (!in_queue.enqueue(batch))
+                            sched_yield();
+                    }
                 }
 
-                in_queue.close();
+                // The last producer finishing closes the queue
+                if (--producing == 0)
+                    in_queue.close();
             }
 
             while (1) {
-                ReadPtr r;
+                BatchT *batch;
 
-                if (!in_queue.wait_dequeue(r))
+                if (!in_queue.wait_dequeue(batch))
                     break;
 
+                bool res = false;
+                for (size_t i = 0; i < batch->size; ++i)
+                    res |= Process(op, batch->reads[i], 0);
+
 #       pragma omp atomic
-                processed_ += 1;
+                processed_ += batch->size;
 
-                bool res = op(std::move(r));
-                if (res) {
-#         pragma omp atomic
-                    stop |= res;
-                }
+                pool.release(batch);
+                if (res)
+                    stop = true;
             }
         }
 
-#   pragma omp flush(stop)
         return stop;
     }
 
+    template<class BatchT, class Writer>
+    static void Flush(mpmc_bounded_queue<BatchT*> &out_queue, BatchPool<BatchT> &pool, Writer &writer) {
+        BatchT *batch;
+        while (out_queue.dequeue(batch)) {
+            for (auto &res : batch->results)
+                writer << *res;
+            pool.release(batch);
+        }
+    }
+
+public:
+    static const size_t DefaultBatchSize = 1024;
+
+    ReadProcessor(unsigned nthreads, size_t batch_size = DefaultBatchSize)
+            : nthreads_(nthreads), batch_size_(std::max(batch_size, size_t(1))), read_(0), processed_(0) { }
+
+    size_t read() const { return read_; }
+
+    size_t processed() const { return processed_; }
+
+    // Op is called for every read either as op(ReadT&) or, if it does not
+    // accept references, as op(std::unique_ptr<ReadT>). Returning true from op
+    // stops the processing; reads already taken from the stream are still processed.
+    // The stop is noticed by the reader right away, but up to a few batches per
+    // thread might be queued by then, so pass a small batch_size if op should
+    // not see many reads after it asked to stop.
+    template<class Reader, class Op>
+    bool Run(Reader &irs, Op &op) {
+        if (nthreads_ < 2)
+            return RunSingle(irs, op);
+
+        return RunParallel(std::vector<Reader*>{ &irs }, op);
+    }
+
+    // Same as Run(), but for several input streams. Different streams are
+    // read concurrently by several producer threads, so the order of reads
+    // is not preserved even across the files.
+    template<class Reader, class Op>
+    bool RunMultiple(const std::vector<Reader*> &readers, Op &op) {
+        if (nthreads_ < 2) {
+            for (Reader *irs : readers)
+                if (RunSingle(*irs, op))
+                    return true;
+            return false;
+        }
+
+        return RunParallel(readers, op);
+    }
+
     template<class Reader, class Op, class Writer>
     void Run(Reader &irs, Op &op, Writer &writer) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        typedef typename Reader::ReadT ReadT;
+        typedef decltype(Process(op, std::declval<ReadT&>(), 0)) ResultT;
+        typedef Batch<ReadT, ResultT> BatchT;
 
         if (nthreads_ < 2) {
             RunSingle(irs, op, writer);
             return;
         }
 
-        // Round nthreads to next power of two
-        unsigned bufsize = nthreads_ - 1;
-        bufsize = (bufsize >> 1) | bufsize;
-        bufsize = (bufsize >> 2) | bufsize;
-        bufsize = (bufsize >> 4) | bufsize;
-        bufsize = (bufsize >> 8) | bufsize;
-        bufsize = (bufsize >> 16) | bufsize;
-        bufsize += 1;
-
-        mpmc_bounded_queue<ReadPtr> in_queue(bufsize), out_queue(2 * bufsize);
-#   pragma omp parallel shared(in_queue, out_queue, irs, op, writer) num_threads(nthreads_)
+        // Every batch could end up in the output queue, so it never overflows
+        size_t bufsize = RoundPow2(nthreads_), nbatches = 2 * bufsize + nthreads_;
+        mpmc_bounded_queue<BatchT*> in_queue(bufsize), out_queue(RoundPow2(nbatches));
+        BatchPool<BatchT> pool(nbatches, batch_size_);
+#   pragma omp parallel shared(in_queue, out_queue, pool, irs, op, writer) num_threads(nthreads_)
         {
 #     pragma omp master
             {
                 while (!irs.eof()) {
-                    ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-                    irs >> *r;
+                    // Keep flushing the output queue while waiting, this is
+                    // where the batches are returned to the pool.
+                    BatchT *batch;
+                    while (!pool.try_acquire(batch)) {
+                        Flush(out_queue, pool, writer);
+                        sched_yield();
+                    }
 
-                    // First, try to provide read to the queue. If it's full, never mind.
-                    bool status = in_queue.enqueue(std::move(r));
+                    read_ += Fill(irs, *batch);
 
-                    // Flush down the output queue
-                    ReadPtr outr;
-                    while (out_queue.dequeue(outr))
-                        writer << *outr;
+                    while (!in_queue.enqueue(batch)) {
+                        Flush(out_queue, pool, writer);
+                        sched_yield();
+                    }
 
-                    // If the input queue was originally full, wait until we can insert
-                    // the read once again.
-                    if (!status)
-                        while (!in_queue.enqueue(std::move(r)))
-                            sched_yield();
+                    Flush(out_queue, pool, writer);
                 }
 
                 in_queue.close();
 
                 // Flush down the output queue while in master threads.
-                ReadPtr outr;
-                while (out_queue.dequeue(outr))
-                    writer << *outr;
+                Flush(out_queue, pool, writer);
             }
 
             while (1) {
-                ReadPtr r;
+                BatchT *batch;
 
-                if (!in_queue.wait_dequeue(r))
+                if (!in_queue.wait_dequeue(batch))
                     break;
 
-                auto res = op(std::move(r));
-                if (res)
-                    while (!out_queue.enqueue(std::move(res)))
-                        sched_yield();
+                batch->results.clear();
+                for (size_t i = 0; i < batch->size; ++i) {
+                    auto res = Process(op, batch->reads[i], 0);
+                    if (res)
+                        batch->results.push_back(std::move(res));
+                }
+
+#       pragma omp atomic
+                processed_ += batch->size;
+
+                out_queue.enqueue(batch);
             }
         }
 
         // Flush down the output queue
-        ReadPtr outr;
-        while (out_queue.dequeue(outr))
-            writer << *outr;
+        Flush(out_queue, pool, writer);
     }
 };
 
@@ -29,6 +29,7 @@ public:
     typedef typename InnerIndex::KMer KMer;
     typedef typename InnerIndex::KMerIdx KMerIdx;
     typedef typename InnerIndex::KmerPos Value;
+    typedef typename InnerIndex::KeyWithHash KeyWithHash;
 
 private:
     InnerIndex inner_index_;
@@ -36,12 +37,22 @@ private:
     EdgeIndexRefiller refiller_;
     bool delete_index_;
 
+    // Events buffered in batched mode, deleted edges keep their sequences
+    bool batched_;
+    std::vector<EdgeId> added_;
+    std::vector<std::pair<EdgeId, Sequence>> deleted_;
+
+    bool HasPending() const {
+        return !added_.empty() || !deleted_.empty();
+    }
+
 public:
     EdgeIndex(const Graph& g, const std::string &workdir)
             : omnigraph::GraphActionHandler<Graph>(g, "EdgeIndex"),
               inner_index_(g, workdir),
               updater_(g, inner_index_),
-              delete_index_(true) {
+              delete_index_(true),
+              batched_(false) {
     }
 
     virtual ~EdgeIndex() {
@@ -57,32 +68,79 @@ public:
     }
 
     const InnerIndex &inner_index() const {
-        VERIFY(this->IsAttached());
+        VERIFY(this->IsAttached() && !HasPending());
         return inner_index_;
     }
 
     void HandleAdd(EdgeId e) override {
-        updater_.UpdateKmers(e);
+        if (batched_)
+            added_.push_back(e);
+        else
+            updater_.UpdateKmers(e);
     }
 
     void HandleDelete(EdgeId e) override {
-        updater_.DeleteKmers(e);
+        if (batched_)
+            deleted_.emplace_back(e, this->g().EdgeNucls(e));
+        else
+            updater_.DeleteKmers(e);
+    }
+
+    // Applies the buffered events in parallel: k-mers of the deleted edges are
+    // removed first, then the k-mers of the added edges which are still alive are put
+    void HandleFlush() override {
+        if (!HasPending())
+            return;
+
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < deleted_.size(); ++i)
+            updater_.DeleteKmers(deleted_[i].first, deleted_[i].second);
+
+        std::vector<EdgeId> gone;
+        gone.reserve(deleted_.size());
+        for (const auto &entry : deleted_)
+            gone.push_back(entry.first);
+        std::sort(gone.begin(), gone.end());
+
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < added_.size(); ++i) {
+            if (!std::binary_search(gone.begin(), gone.end(), added_[i]))
+                updater_.UpdateKmers(added_[i]);
+        }
+
+        added_.clear();
+        deleted_.clear();
+    }
+
+    // In batched mode the index is updated only on flush, switching it off flushes
+    void SetBatched(bool batched) {
+        if (!batched)
+            HandleFlush();
+        batched_ = batched;
     }
 
     bool contains(const KMer& kmer) const {
-        VERIFY(this->IsAttached());
+        VERIFY(this->IsAttached() && !HasPending());
         return inner_index_.contains(inner_index_.ConstructKWH(kmer));
     }
 
     const pair<EdgeId, size_t> get(const KMer& kmer) const {
-        VERIFY(this->IsAttached());
-        auto kwh = inner_index_.ConstructKWH(kmer);
-        if (!inner_index_.contains(kwh)) {
-            return make_pair(EdgeId(0), -1u);
-        } else {
-            EdgeInfo<EdgeId> entry = inner_index_.get_value(kwh);
-            return std::make_pair(entry.edge_id, (size_t)entry.offset);
-        }
+        VERIFY(this->IsAttached() && !HasPending());
+        return get(inner_index_.ConstructKWH(kmer));
+    }
+
+    //Batched version of get(), lookups of the k-mers overlap in memory
+    void get(const std::vector<KMer> &kmers, std::vector<pair<EdgeId, size_t>> &positions) const {
+        VERIFY(this->IsAttached() && !HasPending());
+        std::vector<KeyWithHash> kwhs;
+        kwhs.reserve(kmers.size());
+        for (const KMer &kmer : kmers)
+            kwhs.push_back(inner_index_.ConstructKWH(kmer));
+        inner_index_.ResolveKWHs(kwhs.begin(), kwhs.end());
+
+        positions.clear();
+        for (const KeyWithHash &kwh : kwhs)
+            positions.push_back(get(kwh));
     }
 
     void Refill() {
@@ -96,8 +154,19 @@ public:
     }
 
     void clear() {
+        added_.clear();
+        deleted_.clear();
         inner_index_.clear();
     }
 
+private:
+    const pair<EdgeId, size_t> get(const KeyWithHash &kwh) const {
+        if (!inner_index_.contains(kwh)) {
+            return make_pair(EdgeId(0), -1u);
+        } else {
+            EdgeInfo<EdgeId> entry = inner_index_.get_value(kwh);
+            return std::make_pair(entry.edge_id, (size_t)entry.offset);
+        }
+    }
 };
 }
@@ -30,6 +30,10 @@ class KmerMapper : public omnigraph::GraphActionHandler<Graph> {
     bool verification_on_;
     bool normalized_;
 
+    // Sequences of the glued edges buffered in batched mode
+    bool batched_;
+    std::vector<std::pair<Sequence, Sequence>> pending_;
+
     bool CheckAllDifferent(const Sequence &old_s, const Sequence &new_s) const {
         std::set<Kmer> kmers;
         Kmer kmer = old_s.start<Kmer>(k_) >> 0;
@@ -45,12 +49,64 @@ class KmerMapper : public omnigraph::GraphActionHandler<Graph> {
         return kmers.size() == old_s.size() - k_ + 1 + new_s.size() - k_ + 1;
     }
 
+    // Pairs of different k-mers at the aligned positions of the sequences,
+    // does not depend on the current mapping
+    void CollectRemapping(const Sequence &old_s, const Sequence &new_s,
+                          std::vector<std::pair<Kmer, Kmer>> &remapping) const {
+        size_t old_length = old_s.size() - k_ + 1;
+        size_t new_length = new_s.size() - k_ + 1;
+        UniformPositionAligner aligner(old_s.size() - k_ + 1,
+                                       new_s.size() - k_ + 1);
+        Kmer old_kmer = old_s.start<Kmer>(k_) >> 'A';
+        typename Kmer::less2 kmer_less;
+        for (size_t i = k_ - 1; i < old_s.size(); ++i) {
+            old_kmer <<= old_s[i];
+
+            size_t old_kmer_offset = i - k_ + 1;
+            size_t new_kmer_offest = aligner.GetPosition(old_kmer_offset);
+            if (old_kmer_offset * 2 + 1 == old_length && new_length % 2 == 0) {
+                Kmer middle(k_-1, new_s, new_length / 2);
+                if (kmer_less(middle, !middle)) {
+                    new_kmer_offest = new_length - 1 - new_kmer_offest;
+                }
+            }
+            Kmer new_kmer(k_, new_s, new_kmer_offest);
+            if (old_kmer == new_kmer)
+                continue;
+
+            remapping.emplace_back(old_kmer, new_kmer);
+        }
+    }
+
+    void ApplyRemapping(const std::vector<std::pair<Kmer, Kmer>> &remapping) {
+        for (const auto &entry : remapping) {
+            const Kmer &old_kmer = entry.first, &new_kmer = entry.second;
+
+            // Checking if already have info for this kmer
+            if (mapping_.count(old_kmer))
+                continue;
+
+            if (mapping_.count(new_kmer)) {
+                // Special case of remapping back.
+                // Not sure that we actually need it
+                if (Substitute(new_kmer) == old_kmer)
+                    mapping_.erase(new_kmer);
+                else
+                    continue;
+            }
+
+            mapping_.set(old_kmer, new_kmer);
+            normalized_ = false;
+        }
+    }
+
 public:
     KmerMapper(const Graph &g) :
             base(g, "KmerMapper"),
             k_(unsigned(g.k() + 1)),
             mapping_(k_),
-            normalized_(false) {
+            normalized_(false),
+            batched_(false) {
     }
 
     virtual ~KmerMapper() {}
@@ -64,6 +120,7 @@ public:
     }
 
     void Normalize() {
+        VERIFY(pending_.empty());
         if (normalized_)
             return;
 
@@ -97,52 +154,45 @@ public:
 
     void RemapKmers(const Sequence &old_s, const Sequence &new_s) {
         VERIFY(this->IsAttached());
-        size_t old_length = old_s.size() - k_ + 1;
-        size_t new_length = new_s.size() - k_ + 1;
-        UniformPositionAligner aligner(old_s.size() - k_ + 1,
-                                       new_s.size() - k_ + 1);
-        Kmer old_kmer = old_s.start<Kmer>(k_) >> 'A';
-        typename Kmer::less2 kmer_less;
-        for (size_t i = k_ - 1; i < old_s.size(); ++i) {
-            old_kmer <<= old_s[i];
+        std::vector<std::pair<Kmer, Kmer>> remapping;
+        CollectRemapping(old_s, new_s, remapping);
+        ApplyRemapping(remapping);
+    }
 
-            // Checking if already have info for this kmer
-            if (mapping_.count(old_kmer))
-                continue;
+    void HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) override {
+        VERIFY(this->g().EdgeNucls(new_edge) == this->g().EdgeNucls(edge2));
+        if (batched_)
+            pending_.emplace_back(this->g().EdgeNucls(edge1), this->g().EdgeNucls(edge2));
+        else
+            RemapKmers(this->g().EdgeNucls(edge1), this->g().EdgeNucls(edge2));
+    }
 
-            size_t old_kmer_offset = i - k_ + 1;
-            size_t new_kmer_offest = aligner.GetPosition(old_kmer_offset);
-            if (old_kmer_offset * 2 + 1 == old_length && new_length % 2 == 0) {
-                Kmer middle(k_-1, new_s, new_length / 2);
-                if (kmer_less(middle, !middle)) {
-                    new_kmer_offest = new_length - 1 - new_kmer_offest;
-                }
-            }
-            Kmer new_kmer(k_, new_s, new_kmer_offest);
-            if (old_kmer == new_kmer)
-                continue;
+    // K-mers of the buffered glues are aligned in parallel, the remapping is
+    // then applied in the order of the events since it depends on the mapping state
+    void HandleFlush() override {
+        if (pending_.empty())
+            return;
 
-            if (mapping_.count(new_kmer)) {
-                // Special case of remapping back.
-                // Not sure that we actually need it
-                if (Substitute(new_kmer) == old_kmer)
-                    mapping_.erase(new_kmer);
-                else
-                    continue;
-            }
+        std::vector<std::pair<Sequence, Sequence>> glues;
+        glues.swap(pending_);
+        std::vector<std::vector<std::pair<Kmer, Kmer>>> remappings(glues.size());
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < glues.size(); ++i)
+            CollectRemapping(glues[i].first, glues[i].second, remappings[i]);
 
-            mapping_.set(old_kmer, new_kmer);
-            normalized_ = false;
-        }
+        for (const auto &remapping : remappings)
+            ApplyRemapping(remapping);
     }
 
-    void HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) override {
-        VERIFY(this->g().EdgeNucls(new_edge) == this->g().EdgeNucls(edge2));
-        RemapKmers(this->g().EdgeNucls(edge1), this->g().EdgeNucls(edge2));
+    // In batched mode glues are processed only on flush, switching it off flushes
+    void SetBatched(bool batched) {
+        if (!batched)
+            HandleFlush();
+        batched_ = batched;
     }
 
     Kmer Substitute(const Kmer &kmer) const {
-        VERIFY(this->IsAttached());
+        VERIFY(this->IsAttached() && pending_.empty());
         Kmer answer = kmer;
         const auto *rawval = mapping_.find(answer);
         while (rawval != nullptr) {
@@ -202,6 +252,7 @@ public:
     }
 
     void clear() {
+        pending_.clear();
         normalized_ = false;
         return mapping_.clear();
     }
@@ -0,0 +1,141 @@
+//***************************************************************************
+//* Copyright (c) 2015 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/paths/mapping_path.hpp"
+#include "utils/filesystem/path_helper.hpp"
+
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace debruijn_graph {
+
+/*
+ * On-disk cache of read mapping paths of a single library.
+ * The first pass over the library streams records mapping paths of all reads
+ * (one file per stream), subsequent passes replay them in the same order
+ * instead of mapping reads again. Graph must not change while cache is in use.
+ * Record format: uint32 mapping count, then for each mapping edge int_id (uint64)
+ * followed by initial and mapped ranges (4 x uint32).
+ */
+template<class Graph>
+class MappingPathCache {
+    typedef typename Graph::EdgeId EdgeId;
+
+    struct MappingRecord {
+        uint64_t edge_id;
+        uint32_t initial_start, initial_end;
+        uint32_t mapped_start, mapped_end;
+    };
+
+    const Graph &g_;
+    std::string work_dir_;
+    std::vector<EdgeId> edges_;
+    std::vector<std::unique_ptr<std::fstream>> chunks_;
+    bool ready_;
+    bool in_pass_;
+
+    std::string ChunkName(size_t stream) const {
+        return fs::append_path(work_dir_, std::to_string(stream) + ".mpc");
+    }
+
+    void FillEdges() {
+        size_t max_id = 0;
+        for (auto it = g_.ConstEdgeBegin(); !it.IsEnd(); ++it)
+            max_id = std::max(max_id, g_.int_id(*it));
+        edges_.resize(max_id + 1);
+        for (auto it = g_.ConstEdgeBegin(); !it.IsEnd(); ++it)
+            edges_[g_.int_id(*it)] = *it;
+    }
+
+public:
+    MappingPathCache(const Graph &g, const std::string &work_dir)
+            : g_(g), work_dir_(fs::make_temp_dir(work_dir, "mapping_cache")),
+              ready_(false), in_pass_(false) {}
+
+    ~MappingPathCache() {
+        chunks_.clear();
+        fs::remove_dir(work_dir_);
+    }
+
+    //true if all paths were recorded and can be replayed
+    bool ready() const {
+        return ready_;
+    }
+
+    void StartPass(size_t streams_count) {
+        VERIFY(!in_pass_);
+        VERIFY_MSG(!ready_ || chunks_.size() == streams_count,
+                   "Number of streams differs from the cached one");
+        if (ready_ && edges_.empty())
+            FillEdges();
+
+        chunks_.clear();
+        for (size_t i = 0; i < streams_count; ++i) {
+            auto mode = std::ios_base::binary | (ready_ ? std::ios_base::in : std::ios_base::out | std::ios_base::trunc);
+            chunks_.emplace_back(new std::fstream(ChunkName(i), mode));
+            VERIFY_MSG(chunks_.back()->good(), "Failed to open mapping cache chunk " << ChunkName(i));
+        }
+        in_pass_ = true;
+    }
+
+    void FinishPass() {
+        VERIFY(in_pass_);
+        for (auto &chunk : chunks_) {
+            if (!ready_)
+                chunk->flush();
+            VERIFY_MSG(!chunk->fail(), "Mapping cache I/O error");
+        }
+        //keep the number of chunks, but release the descriptors
+        for (auto &chunk : chunks_)
+            chunk->close();
+        ready_ = true;
+        in_pass_ = false;
+    }
+
+    //Not thread-safe for the same stream
+    void Write(size_t stream, const MappingPath<EdgeId> &path) {
+        VERIFY(!ready_);
+        std::fstream &chunk = *chunks_[stream];
+        uint32_t size = (uint32_t) path.size();
+        chunk.write((const char *) &size, sizeof(size));
+        for (size_t i = 0; i < path.size(); ++i) {
+            const auto &mapping = path[i];
+            const MappingRange &range = mapping.second;
+            MappingRecord record = { g_.int_id(mapping.first),
+                                     (uint32_t) range.initial_range.start_pos, (uint32_t) range.initial_range.end_pos,
+                                     (uint32_t) range.mapped_range.start_pos, (uint32_t) range.mapped_range.end_pos };
+            chunk.write((const char *) &record, sizeof(record));
+        }
+    }
+
+    //Not thread-safe for the same stream
+    MappingPath<EdgeId> Read(size_t stream) {
+        VERIFY(ready_);
+        std::fstream &chunk = *chunks_[stream];
+        uint32_t size = 0;
+        chunk.read((char *) &size, sizeof(size));
+        VERIFY_MSG(!chunk.fail(), "Mapping cache is shorter than the library");
+
+        std::vector<EdgeId> edges;
+        std::vector<MappingRange> ranges;
+        edges.reserve(size);
+        ranges.reserve(size);
+        for (uint32_t i = 0; i < size; ++i) {
+            MappingRecord record;
+            chunk.read((char *) &record, sizeof(record));
+            VERIFY(!chunk.fail() && record.edge_id < edges_.size());
+            edges.push_back(edges_[record.edge_id]);
+            ranges.emplace_back(record.initial_start, record.initial_end,
+                                record.mapped_start, record.mapped_end);
+        }
+        return MappingPath<EdgeId>(edges, ranges);
+    }
+};
+
+}
@@ -291,9 +291,51 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   size_t k_;
   bool optimization_on_;
 
+  typedef std::pair<EdgeId, size_t> KmerPosition;
+
+  //Index lookups of consecutive k-mers (e.g. when none of the k-mers covering
+  //a sequencing error are in the graph) are done in batches of growing size,
+  //so that their memory accesses overlap. Threaded k-mers are never looked up.
+  class LookupAhead {
+    const Index &index_;
+    const Sequence &sequence_;
+    size_t k_;
+    size_t start_, batch_;
+    std::vector<Kmer> kmers_;
+    std::vector<KmerPosition> positions_;
+
+  public:
+    LookupAhead(const Index &index, const Sequence &sequence, size_t k)
+            : index_(index), sequence_(sequence), k_(k), start_(0), batch_(0) {}
+
+    KmerPosition get(const Kmer &kmer, size_t kmer_pos) {
+      const size_t MaxBatch = 16;
+      if (kmer_pos >= start_ && kmer_pos < start_ + positions_.size())
+        return positions_[kmer_pos - start_];
+
+      batch_ = (batch_ && kmer_pos == start_ + positions_.size()) ? std::min(2 * batch_, MaxBatch) : 1;
+      start_ = kmer_pos;
+      if (batch_ == 1) {
+        positions_.assign(1, index_.get(kmer));
+        return positions_.front();
+      }
+
+      size_t cnt = std::min(batch_, sequence_.size() - k_ + 1 - kmer_pos);
+      kmers_.assign(1, kmer);
+      for (size_t i = 1; i < cnt; ++i)
+        kmers_.push_back(kmers_.back() << sequence_[kmer_pos + k_ - 1 + i]);
+      index_.get(kmers_, positions_);
+      return positions_.front();
+    }
+  };
+
   bool FindKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed,
                 RangeMappings& range_mappings) const {
-    std::pair<EdgeId, size_t> position = index_.get(kmer);
+    return FindKmer(index_.get(kmer), kmer_pos, passed, range_mappings);
+  }
+
+  bool FindKmer(const KmerPosition &position, size_t kmer_pos, std::vector<EdgeId> &passed,
+                RangeMappings& range_mappings) const {
     if (position.second == -1u)
         return false;
     
@@ -344,7 +386,7 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   }
 
   bool ProcessKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed_edges,
-                   RangeMappings& range_mapping, bool try_thread) const {
+                   RangeMappings& range_mapping, bool try_thread, LookupAhead &lookup) const {
     if (try_thread) {
         if (!TryThread(kmer, kmer_pos, passed_edges, range_mapping)) {
             FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
@@ -359,7 +401,7 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
         return false;
     }
 
-    return FindKmer(kmer, kmer_pos, passed_edges, range_mapping);
+    return FindKmer(lookup.get(kmer, kmer_pos), kmer_pos, passed_edges, range_mapping);
   }
 
  public:
@@ -379,14 +421,15 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
       return MappingPath<EdgeId>();
     }
 
+    LookupAhead lookup(index_, sequence, k_);
     Kmer kmer = sequence.start<Kmer>(k_);
     bool try_thread = false;
     try_thread = ProcessKmer(kmer, 0, passed_edges,
-                             range_mapping, try_thread);
+                             range_mapping, try_thread, lookup);
     for (size_t i = k_; i < sequence.size(); ++i) {
       kmer <<= sequence[i];
       try_thread = ProcessKmer(kmer, i - k_ + 1, passed_edges,
-                               range_mapping, try_thread);
+                               range_mapping, try_thread, lookup);
     }
 
     return MappingPath<EdgeId>(passed_edges, range_mapping);
@@ -10,6 +10,7 @@
 
 #include "sequence_mapper.hpp"
 #include "short_read_mapper.hpp"
+#include "mapping_path_cache.hpp"
 #include "io/reads/paired_read.hpp"
 #include "io/reads/read_stream_vector.hpp"
 #include "pipeline/graph_pack.hpp"
@@ -43,16 +44,24 @@ class SequenceMapperNotifier {
 public:
     typedef SequenceMapper<conj_graph_pack::graph_t> SequenceMapperT;
 
+    typedef MappingPathCache<conj_graph_pack::graph_t> MappingPathCacheT;
+
     typedef std::vector<SequenceMapperListener*> ListenersContainer;
 
     SequenceMapperNotifier(const conj_graph_pack& gp, size_t lib_count)
-            : gp_(gp), listeners_(lib_count) { }
+            : gp_(gp), listeners_(lib_count), caches_(lib_count, nullptr) { }
 
     void Subscribe(size_t lib_index, SequenceMapperListener* listener) {
         VERIFY(lib_index < listeners_.size());
         listeners_[lib_index].push_back(listener);
     }
 
+    //Mapping paths of the library will be recorded to (or replayed from) the cache
+    void UseCache(size_t lib_index, MappingPathCacheT* cache) {
+        VERIFY(lib_index < caches_.size());
+        caches_[lib_index] = cache;
+    }
+
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
@@ -60,6 +69,11 @@ public:
             threads_count = streams.size();
 
         streams.reset();
+        MappingPathCacheT* cache = caches_[lib_index];
+        if (cache) {
+            INFO((cache->ready() ? "Replaying" : "Recording") << " cached mapping paths");
+            cache->StartPass(streams.size());
+        }
         NotifyStartProcessLibrary(lib_index, threads_count);
         size_t counter = 0, n = 15;
         size_t fmem = utils::get_free_memory();
@@ -97,10 +111,24 @@ public:
             NotifyMergeBuffer(lib_index, i);
 
         INFO("Total " << counter << " reads processed");
+        if (cache)
+            cache->FinishPass();
         NotifyStopProcessLibrary(lib_index);
     }
 
 private:
+    template<class MapF>
+    MappingPath<EdgeId> MapWithCache(size_t ilib, size_t istream, MapF map) const {
+        MappingPathCacheT* cache = caches_[ilib];
+        if (!cache)
+            return map();
+        if (cache->ready())
+            return cache->Read(istream);
+        MappingPath<EdgeId> path = map();
+        cache->Write(istream, path);
+        return path;
+    }
+
     template<class ReadType>
     void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
 
@@ -121,6 +149,7 @@ private:
     const conj_graph_pack& gp_;
 
     std::vector<std::vector<SequenceMapperListener*> > listeners_;  //first vector's size = count libs
+    std::vector<MappingPathCacheT*> caches_;
 };
 
 template<>
@@ -131,8 +160,8 @@ inline void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r
 
     const Sequence& read1 = r.first().sequence();
     const Sequence& read2 = r.second().sequence();
-    MappingPath<EdgeId> path1 = mapper.MapSequence(read1);
-    MappingPath<EdgeId> path2 = mapper.MapSequence(read2);
+    MappingPath<EdgeId> path1 = MapWithCache(ilib, ithread, [&] { return mapper.MapSequence(read1); });
+    MappingPath<EdgeId> path2 = MapWithCache(ilib, ithread, [&] { return mapper.MapSequence(read2); });
     for (const auto& listener : listeners_[ilib]) {
         TRACE("Dist: " << r.second().size() << " - " << r.insert_size() << " = " << r.second().size() - r.insert_size());
         listener->ProcessPairedRead(ithread, r, path1, path2);
@@ -146,8 +175,8 @@ inline void SequenceMapperNotifier::NotifyProcessRead(const io::PairedRead& r,
                                                       const SequenceMapperT& mapper,
                                                       size_t ilib,
                                                       size_t ithread) const {
-    MappingPath<EdgeId> path1 = mapper.MapRead(r.first());
-    MappingPath<EdgeId> path2 = mapper.MapRead(r.second());
+    MappingPath<EdgeId> path1 = MapWithCache(ilib, ithread, [&] { return mapper.MapRead(r.first()); });
+    MappingPath<EdgeId> path2 = MapWithCache(ilib, ithread, [&] { return mapper.MapRead(r.second()); });
     for (const auto& listener : listeners_[ilib]) {
         TRACE("Dist: " << r.second().size() << " - " << r.insert_size() << " = " << r.second().size() - r.insert_size());
         listener->ProcessPairedRead(ithread, r, path1, path2);
@@ -162,7 +191,7 @@ inline void SequenceMapperNotifier::NotifyProcessRead(const io::SingleReadSeq& r
                                                       size_t ilib,
                                                       size_t ithread) const {
     const Sequence& read = r.sequence();
-    MappingPath<EdgeId> path = mapper.MapSequence(read);
+    MappingPath<EdgeId> path = MapWithCache(ilib, ithread, [&] { return mapper.MapSequence(read); });
     for (const auto& listener : listeners_[ilib])
         listener->ProcessSingleRead(ithread, r, path);
 }
@@ -172,7 +201,7 @@ inline void SequenceMapperNotifier::NotifyProcessRead(const io::SingleRead& r,
                                                       const SequenceMapperT& mapper,
                                                       size_t ilib,
                                                       size_t ithread) const {
-    MappingPath<EdgeId> path = mapper.MapRead(r);
+    MappingPath<EdgeId> path = MapWithCache(ilib, ithread, [&] { return mapper.MapRead(r); });
     for (const auto& listener : listeners_[ilib])
         listener->ProcessSingleRead(ithread, r, path);
 }
@@ -19,6 +19,7 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <queue>
 #include "weight_counter.hpp"
 #include "pe_utils.hpp"
 
@@ -226,6 +227,12 @@ public:
         return wc_;
     }
 
+    //Paired info of a path is collected once per its state, not for every weight requested
+    void CachePairedInfo() {
+        if (wc_)
+            wc_->CachePairedInfo();
+    }
+
 protected:
     bool HasIdealInfo(EdgeId e1, EdgeId e2, size_t dist) const {
         return math::gr(wc_->PairedLibrary().IdealPairedInfo(e1, e2, (int) dist), 0.);
@@ -803,7 +810,7 @@ private:
         if (g_.length(e) > max_repeat_length_)
             return true;
         DEBUG("Analyze unique edge " << g_.int_id(e));
-        if (cov_map_.size() == 0) {
+        if (cov_map_.empty()) {
             return false;
         }
         auto cov_paths = cov_map_.GetCoveringPaths(e);
@@ -18,7 +18,9 @@
 #include "path_filter.hpp"
 #include "overlap_analysis.hpp"
 #include "assembly_graph/graph_support/scaff_supplementary.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include <cmath>
+#include <unordered_set>
 
 namespace path_extend {
 
@@ -187,18 +189,21 @@ public:
     }
 
     vector<const BidirectionalPath*> FindCandidatePaths(const BidirectionalPath &path) const {
-        set<const BidirectionalPath*> candidates;
+        vector<const BidirectionalPath*> candidates;
         size_t cum_len = 0;
         for (size_t i = 0; i < path.Size(); ++i) {
             if (cum_len > max_diff_)
                 break;
             EdgeId e = path.At(i);
             if (g_.length(e) >= min_edge_len_) {
-                utils::insert_all(candidates, coverage_map_.GetCoveringPaths(e));
+                auto edge_paths = coverage_map_.GetEdgePaths(e);
+                candidates.insert(candidates.end(), edge_paths->begin(), edge_paths->end());
                 cum_len += path.ShiftLength(i);
             }
         }
-        return vector<const BidirectionalPath*>(candidates.begin(), candidates.end());
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        return candidates;
     }
 
 private:
@@ -663,18 +668,61 @@ private:
     DECL_LOGGER("CompositeGapAnalyzer");
 };
 
+/*
+ * Record of the state the extenders keep between paths (the visited IS cycles).
+ * Speculative growth leaves the state intact: found cycles are only flagged
+ * and the edges the known cycles were looked up for are remembered.
+ * Otherwise the edges of the cycles added to the state are remembered.
+ */
+struct ExtensionJournal {
+    const bool speculative;
+    bool cycle_found;
+    vector<EdgeId> cycle_queries;
+    vector<EdgeId> cycle_edges;
+
+    explicit ExtensionJournal(bool speculative_growth)
+            : speculative(speculative_growth), cycle_found(false) {}
+
+    void clear() {
+        cycle_found = false;
+        cycle_queries.clear();
+        cycle_edges.clear();
+    }
+};
+
 //Detects a cycle as a minsuffix > IS present earlier in the path. Overlap is allowed.
 class InsertSizeLoopDetector {
 protected:
     GraphCoverageMap visited_cycles_coverage_map_;
     PathContainer path_storage_;
     size_t min_cycle_len_;
+    ExtensionJournal *journal_;
+
+    void AddCycle(BidirectionalPath *p, BidirectionalPath *cp) {
+        path_storage_.AddPair(p, cp);
+        visited_cycles_coverage_map_.Subscribe(p);
+        visited_cycles_coverage_map_.Subscribe(cp);
+    }
 
 public:
     InsertSizeLoopDetector(const Graph& g, size_t is):
         visited_cycles_coverage_map_(g),
         path_storage_(),
-        min_cycle_len_(is) {
+        min_cycle_len_(is),
+        journal_(nullptr) {
+    }
+
+    void SetJournal(ExtensionJournal *journal) {
+        journal_ = journal;
+    }
+
+    //Adds the cycles the other detector has visited since the last sync, in the same order
+    void SyncWith(const InsertSizeLoopDetector &other) {
+        VERIFY(path_storage_.size() <= other.path_storage_.size());
+        for (size_t i = path_storage_.size(); i < other.path_storage_.size(); ++i) {
+            AddCycle(new BidirectionalPath(*other.path_storage_.Get(i)),
+                     new BidirectionalPath(*other.path_storage_.GetConjugate(i)));
+        }
     }
 
     ~InsertSizeLoopDetector() {
@@ -743,6 +791,8 @@ public:
     //seems that it is outofdate
     bool InExistingLoop(const BidirectionalPath& path) {
         DEBUG("Checking existing loops");
+        if (journal_ && journal_->speculative)
+            journal_->cycle_queries.push_back(path.Back());
         auto visited_cycles = visited_cycles_coverage_map_.GetEdgePaths(path.Back());
         for (auto cycle : *visited_cycles) {
             DEBUG("checking  cycle ");
@@ -791,10 +841,19 @@ public:
             DEBUG("Wrong position in IS cycle");
             return;
         }
+        if (journal_ && journal_->speculative) {
+            journal_->cycle_found = true;
+            return;
+        }
         BidirectionalPath * p = new BidirectionalPath(path.SubPath(pos));
         BidirectionalPath * cp = new BidirectionalPath(p->Conjugate());
-        visited_cycles_coverage_map_.Subscribe(p);
-        visited_cycles_coverage_map_.Subscribe(cp);
+        AddCycle(p, cp);
+        if (journal_) {
+            for (size_t i = 0; i < p->Size(); ++i) {
+                journal_->cycle_edges.push_back(p->At(i));
+                journal_->cycle_edges.push_back(cp->At(i));
+            }
+        }
         DEBUG("add cycle");
         p->PrintDEBUG();
     }
@@ -809,13 +868,32 @@ public:
 
     virtual bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage = nullptr) = 0;
 
+    //State kept between paths, see CompositeExtender
+    virtual void SetJournal(ExtensionJournal * /*journal*/) { }
+
+    virtual void SyncWith(const PathExtender & /*other*/) { }
+
 protected:
     const Graph &g_;
     DECL_LOGGER("PathExtender")
 };
 
+/*
+ * Grows the seeds in the given order.
+ *
+ * With parallel growth enabled every thread has its own extenders, its own coverage map
+ * and a speculative storage of used unique edges. Seeds are taken in batches and grown
+ * speculatively against the state of the batch start, then the results are committed
+ * one by one in the seed order. A result is committed only if sequential growth would
+ * have given the same: the seed is still not covered, the checks of used unique edges
+ * give the same answers and the visited IS cycles did not change for the edges looked up.
+ * Other seeds (including the ones which found new IS cycles) are regrown sequentially.
+ * So the paths are the same as with sequential growth whatever the number of threads.
+ */
 class CompositeExtender {
 public:
+    typedef vector<shared_ptr<PathExtender>> Extenders;
+    typedef std::function<Extenders (const GraphCoverageMap&, UsedUniqueStorage&)> ExtendersFactory;
 
     CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
                       UsedUniqueStorage &unique,
@@ -825,88 +903,276 @@ public:
               cover_map_(cov_map),
               used_storage_(unique),
               extenders_(pes),
-              max_diff_len_(max_diff_len) {
+              max_diff_len_(max_diff_len),
+              journal_(/*speculative*/false),
+              committed_seeds_(0),
+              regrown_seeds_(0) {
+    }
+
+    /**
+     * Enables parallel growth by the given number of threads,
+     * the factory should make the same extenders as the main ones.
+     */
+    void EnableParallelGrowth(size_t thread_num, const ExtendersFactory &factory) {
+        workers_.clear();
+        if (thread_num <= 1)
+            return;
+        for (size_t i = 0; i < thread_num; ++i) {
+            workers_.emplace_back(new Worker(g_, used_storage_));
+            Worker &worker = *workers_.back();
+            worker.extenders = factory(worker.cover_map, worker.used_storage);
+            VERIFY(worker.extenders.size() == extenders_.size());
+            for (size_t j = 0; j < extenders_.size(); ++j) {
+                worker.extenders[j]->SyncWith(*extenders_[j]);
+                worker.extenders[j]->SetJournal(&worker.journal);
+            }
+        }
+        for (const auto &extender : extenders_)
+            extender->SetJournal(&journal_);
     }
 
     void GrowAll(PathContainer& paths, PathContainer& result) {
         result.clear();
-        GrowAllPaths(paths, result);
+        if (workers_.empty())
+            GrowAllPaths(paths, result);
+        else
+            GrowAllPathsParallel(paths, result);
         result.FilterEmptyPaths();
     }
 
     void GrowPath(BidirectionalPath& path, PathContainer* paths_storage) {
-        while (MakeGrowStep(path, paths_storage)) { }
+        GrowPath(extenders_, path, paths_storage, nullptr);
+    }
+
+    //Seeds of the last parallel growth committed from speculation
+    size_t CommittedSeeds() const {
+        return committed_seeds_;
+    }
+
+    //Seeds of the last parallel growth which were regrown sequentially and gave a path
+    size_t RegrownSeeds() const {
+        return regrown_seeds_;
     }
 
 
 private:
+    struct Worker {
+        GraphCoverageMap cover_map;
+        UsedUniqueStorage used_storage;
+        ExtensionJournal journal;
+        Extenders extenders;
+
+        Worker(const Graph &g, const UsedUniqueStorage &base)
+                : cover_map(g), used_storage(&base), journal(/*speculative*/true) {}
+    };
+
+    struct SpeculativeGrowth {
+        bool grown;
+        //grown path pair followed by the pairs added by the extenders
+        PathContainer paths;
+        UsedUniqueStorage::Changes used_changes;
+        vector<EdgeId> cycle_queries;
+
+        SpeculativeGrowth() : grown(false) {}
+    };
+
+    static const size_t SEEDS_PER_THREAD = 16;
+
     const Graph &g_;
     GraphCoverageMap &cover_map_;
     UsedUniqueStorage &used_storage_;
     vector<shared_ptr<PathExtender>> extenders_;
     size_t max_diff_len_;
+    ExtensionJournal journal_;
+    vector<std::unique_ptr<Worker>> workers_;
+    size_t committed_seeds_;
+    size_t regrown_seeds_;
 
-    bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) {
+    bool MakeGrowStep(const Extenders &extenders, BidirectionalPath& path, PathContainer* paths_storage,
+                      const ExtensionJournal *journal) {
         DEBUG("make grow step composite extender");
 
         size_t current = 0;
-        while (current < extenders_.size()) {
-            DEBUG("step " << current << " of total " << extenders_.size());
-            if (extenders_[current]->MakeGrowStep(path, paths_storage)) {
+        while (current < extenders.size()) {
+            //no sense to grow further, the path will be regrown anyway
+            if (journal && journal->cycle_found)
+                return false;
+            DEBUG("step " << current << " of total " << extenders.size());
+            if (extenders[current]->MakeGrowStep(path, paths_storage)) {
                 return true;
             }
            ++current;
         }
         return false;
     }
-    
+
+    void GrowPath(const Extenders &extenders, BidirectionalPath& path, PathContainer* paths_storage,
+                  const ExtensionJournal *journal) {
+        while (MakeGrowStep(extenders, path, paths_storage, journal)) { }
+    }
+
+    void GrowPathPair(const Extenders &extenders, BidirectionalPath &path, BidirectionalPath &conjugate_path,
+                      PathContainer &paths_storage, const ExtensionJournal *journal = nullptr) {
+        size_t count_trying = 0;
+        size_t current_path_len = 0;
+        do {
+            current_path_len = path.Length();
+            count_trying++;
+            GrowPath(extenders, path, &paths_storage, journal);
+            GrowPath(extenders, conjugate_path, &paths_storage, journal);
+        } while (count_trying < 10 && (path.Length() != current_path_len));
+    }
+
+    //In 2015 modes do not use a seed already used in paths.
+    //FIXME what is the logic here?
+    bool UseSeedEdges(const BidirectionalPath &seed, UsedUniqueStorage &used_storage) const {
+        if (!used_storage.UniqueCheckEnabled())
+            return true;
+        for (size_t ind =0; ind < seed.Size(); ind++) {
+            EdgeId eid = seed.At(ind);
+            if (used_storage.IsUsedAndUnique(eid)) {
+                DEBUG("Used edge " << g_.int_id(eid));
+                return false;
+            } else {
+                used_storage.insert(eid);
+            }
+        }
+        return true;
+    }
+
+    void ReportProgress(size_t i, size_t total) const {
+        VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << total << " (" << i * 100 / total << "%)");
+        if (total > 10 && i % (total / 10 + 1) == 0) {
+            INFO("Processed " << i << " paths from " << total << " (" << i * 100 / total << "%)");
+        }
+    }
+
+    void GrowSeed(const PathContainer& paths, size_t i, PathContainer& result) {
+        if (!UseSeedEdges(*paths.Get(i), used_storage_)) {
+            DEBUG("skipping already used seed");
+            return;
+        }
+
+        if (!cover_map_.IsCovered(*paths.Get(i))) {
+            AddPath(result, *paths.Get(i), cover_map_);
+            BidirectionalPath * path = new BidirectionalPath(*paths.Get(i));
+            BidirectionalPath * conjugatePath = new BidirectionalPath(*paths.GetConjugate(i));
+            SubscribeCoverageMap(path, cover_map_);
+            SubscribeCoverageMap(conjugatePath, cover_map_);
+            result.AddPair(path, conjugatePath);
+            GrowPathPair(extenders_, *path, *conjugatePath, result);
+            DEBUG("result path " << path->GetId());
+            path->PrintDEBUG();
+        }
+    }
+
     void GrowAllPaths(PathContainer& paths, PathContainer& result) {
         for (size_t i = 0; i < paths.size(); ++i) {
-            VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
-            if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
-                INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
+            ReportProgress(i, paths.size());
+            GrowSeed(paths, i, result);
+        }
+    }
+
+    //Only reads the shared state, seeds which can not be committed are left not grown
+    void GrowSpeculatively(const PathContainer& paths, size_t i, Worker &worker, SpeculativeGrowth &res) {
+        const BidirectionalPath &seed = *paths.Get(i);
+        //Committed paths do not change, so a covered seed stays covered
+        if (cover_map_.IsCovered(seed))
+            return;
+        if (!UseSeedEdges(seed, worker.used_storage)) {
+            worker.used_storage.TakeChanges();
+            return;
+        }
+
+        worker.journal.clear();
+        PathContainer grown, storage;
+        BidirectionalPath * path = new BidirectionalPath(seed);
+        BidirectionalPath * conjugatePath = new BidirectionalPath(*paths.GetConjugate(i));
+        SubscribeCoverageMap(path, worker.cover_map);
+        SubscribeCoverageMap(conjugatePath, worker.cover_map);
+        grown.AddPair(path, conjugatePath);
+        GrowPathPair(worker.extenders, *path, *conjugatePath, storage, &worker.journal);
+
+        res.used_changes = worker.used_storage.TakeChanges();
+        if (!worker.journal.cycle_found) {
+            res.grown = true;
+            res.paths.AddPair(new BidirectionalPath(*path), new BidirectionalPath(*conjugatePath));
+            for (auto it = storage.begin(); it != storage.end(); ++it)
+                res.paths.AddPair(new BidirectionalPath(*it.get()), new BidirectionalPath(*it.getConjugate()));
+            res.cycle_queries.swap(worker.journal.cycle_queries);
+        }
+        //Removes the pair from the coverage map of the worker
+        path->Clear();
+        conjugatePath->Clear();
+    }
+
+    bool CanCommit(const PathContainer& paths, size_t i, const SpeculativeGrowth &spec,
+                   const std::unordered_set<EdgeId> &new_cycle_edges) const {
+        if (!spec.grown || cover_map_.IsCovered(*paths.Get(i)))
+            return false;
+        for (EdgeId e : spec.cycle_queries)
+            if (new_cycle_edges.count(e))
+                return false;
+        return used_storage_.Consistent(spec.used_changes);
+    }
+
+    void Commit(const PathContainer& paths, size_t i, const SpeculativeGrowth &spec, PathContainer& result) {
+        used_storage_.Apply(spec.used_changes);
+        AddPath(result, *paths.Get(i), cover_map_);
+        BidirectionalPath * path = new BidirectionalPath(*spec.paths.Get(0));
+        BidirectionalPath * conjugatePath = new BidirectionalPath(*spec.paths.GetConjugate(0));
+        SubscribeCoverageMap(path, cover_map_);
+        SubscribeCoverageMap(conjugatePath, cover_map_);
+        result.AddPair(path, conjugatePath);
+        for (size_t j = 1; j < spec.paths.size(); ++j)
+            result.AddPair(new BidirectionalPath(*spec.paths.Get(j)), new BidirectionalPath(*spec.paths.GetConjugate(j)));
+        DEBUG("result path " << path->GetId());
+        path->PrintDEBUG();
+    }
+
+    void GrowAllPathsParallel(PathContainer& paths, PathContainer& result) {
+        INFO("Growing paths speculatively by " << workers_.size() << " threads");
+        const size_t batch_size = SEEDS_PER_THREAD * workers_.size();
+        std::unordered_set<EdgeId> new_cycle_edges;
+        committed_seeds_ = 0;
+        regrown_seeds_ = 0;
+        for (size_t start = 0; start < paths.size(); start += batch_size) {
+            const size_t end = std::min(start + batch_size, paths.size());
+            vector<SpeculativeGrowth> batch(end - start);
+
+            #pragma omp parallel for schedule(dynamic) num_threads((int) workers_.size())
+            for (size_t i = start; i < end; ++i) {
+                GrowSpeculatively(paths, i, *workers_[omp_get_thread_num()], batch[i - start]);
             }
-            //In 2015 modes do not use a seed already used in paths.
-            //FIXME what is the logic here?
-            if (used_storage_.UniqueCheckEnabled()) {
-                bool was_used = false;
-                for (size_t ind =0; ind < paths.Get(i)->Size(); ind++) {
-                    EdgeId eid = paths.Get(i)->At(ind);
-                    if (used_storage_.IsUsedAndUnique(eid)) {
-                        DEBUG("Used edge " << g_.int_id(eid));
-                        was_used = true;
-                        break;
-                    } else {
-                        used_storage_.insert(eid);
-                    }
-                }
-                if (was_used) {
-                    DEBUG("skipping already used seed");
-                    continue;
+
+            for (size_t i = start; i < end; ++i) {
+                ReportProgress(i, paths.size());
+                const SpeculativeGrowth &spec = batch[i - start];
+                if (CanCommit(paths, i, spec, new_cycle_edges)) {
+                    Commit(paths, i, spec, result);
+                    committed_seeds_ += 1;
+                } else {
+                    size_t result_size = result.size();
+                    GrowSeed(paths, i, result);
+                    if (result.size() > result_size)
+                        regrown_seeds_ += 1;
+                    new_cycle_edges.insert(journal_.cycle_edges.begin(), journal_.cycle_edges.end());
+                    journal_.clear();
                 }
             }
 
-            if (!cover_map_.IsCovered(*paths.Get(i))) {
-                AddPath(result, *paths.Get(i), cover_map_);
-                BidirectionalPath * path = new BidirectionalPath(*paths.Get(i));
-                BidirectionalPath * conjugatePath = new BidirectionalPath(*paths.GetConjugate(i));
-                SubscribeCoverageMap(path, cover_map_);
-                SubscribeCoverageMap(conjugatePath, cover_map_);
-                result.AddPair(path, conjugatePath);
-                size_t count_trying = 0;
-                size_t current_path_len = 0;
-                do {
-                    current_path_len = path->Length();
-                    count_trying++;
-                    GrowPath(*path, &result);
-                    GrowPath(*conjugatePath, &result);
-                } while (count_trying < 10 && (path->Length() != current_path_len));
-                DEBUG("result path " << path->GetId());
-                path->PrintDEBUG();
+            if (!new_cycle_edges.empty()) {
+                for (const auto &worker : workers_)
+                    for (size_t j = 0; j < extenders_.size(); ++j)
+                        worker->extenders[j]->SyncWith(*extenders_[j]);
+                new_cycle_edges.clear();
             }
         }
+        INFO(committed_seeds_ << " of " << paths.size() << " seeds were grown in parallel, "
+             << regrown_seeds_ << " were regrown");
     }
 
+    DECL_LOGGER("CompositeExtender");
 };
 
 //All Path-Extenders inherit this one
@@ -991,6 +1257,13 @@ public:
 
     }
 
+    void SetJournal(ExtensionJournal *journal) override {
+        is_detector_.SetJournal(journal);
+    }
+
+    void SyncWith(const PathExtender &other) override {
+        is_detector_.SyncWith(dynamic_cast<const LoopDetectingPathExtender&>(other).is_detector_);
+    }
 
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) override {
         if (is_detector_.InExistingLoop(path)) {
@@ -166,6 +166,7 @@ void load(pe_config::ParamSetT& p, boost::property_tree::ptree const& pt, bool c
     using config_common::load;
     load(p.sm, pt, "scaffolding_mode", complete);
     load(p.normalize_weight, pt,  "normalize_weight", complete);
+    load(p.cache_paired_info, pt, "cache_paired_info", complete);
     load(p.overlap_removal, pt, "overlap_removal", complete);
     load(p.multi_path_extend, pt, "multi_path_extend", complete);
     load(p.split_edge_length, pt, "split_edge_length", complete);
@@ -242,6 +243,8 @@ void load(pe_config::MainPEParamsT& p, boost::property_tree::ptree const& pt,
           bool complete) {
     using config_common::load;
     load(p.debug_output, pt, "debug_output", complete);
+    load(p.parallel_extension, pt, "parallel_extension", complete);
+    load(p.check_parallel_extension, pt, "check_parallel_extension", complete);
     load(p.output, pt, "output", complete);
     load(p.viz, pt, "visualize", complete);
     load(p.param_set, pt, "params", complete);
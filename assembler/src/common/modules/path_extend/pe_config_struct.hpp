@@ -105,6 +105,7 @@ struct pe_config {
         scaffolding_mode sm;
 
         bool normalize_weight;
+        bool cache_paired_info;
         size_t split_edge_length;
 
         bool multi_path_extend;
@@ -242,6 +243,8 @@ struct pe_config {
     struct MainPEParamsT {
         bool debug_output;
         std::string etc_dir;
+        bool parallel_extension;
+        bool check_parallel_extension;
 
         OutputParamsT output;
         VisualizeParamsT viz;
@@ -16,6 +16,8 @@
 
 #include "path_extender.hpp"
 
+#include <limits>
+
 namespace path_extend {
 
 typedef const BidirectionalPath * PathPtr;
@@ -25,7 +27,22 @@ inline void PopFront(BidirectionalPath * const path, size_t cnt) {
     path->GetConjPath()->PopBack(cnt);
 }
 
+/*
+ * Overlaps are marked in two phases: first they are found for all paths in parallel
+ * (paths and coverage map are not changed at this point), then they are added to the splits
+ * in the order of paths, so the check against the already added regions gives the same result
+ * as the sequential marking.
+ */
 class OverlapRemover {
+    //Overlap of the path start with the other path
+    struct Overlap {
+        size_t size;
+        PathPtr other;
+        Range other_range;
+        //overlap is skipped if the region of the other path has been already added
+        bool check_added;
+    };
+
     const Graph &g_;
     const PathContainer &paths_;
     const OverlapFindingHelper helper_;
@@ -46,33 +63,29 @@ class OverlapRemover {
     }
 
     //NB! This can only be launched over paths taken from path container!
-    size_t AnalyzeOverlaps(const BidirectionalPath &path, const BidirectionalPath &other,
-                           bool end_start_only, bool retain_one_copy) const {
+    //Does not depend on the splits, the check of already added region is left to MarkStartOverlaps
+    Overlap AnalyzeOverlaps(const BidirectionalPath &path, const BidirectionalPath &other,
+                            bool end_start_only, bool retain_one_copy) const {
         VERIFY(!retain_one_copy || !end_start_only);
         auto range_pair = helper_.FindOverlap(path, other, end_start_only);
         size_t overlap = range_pair.first.size();
         auto other_range = range_pair.second;
 
         if (overlap == 0) {
-            return 0;
+            return Overlap{0, &other, other_range, false};
         }
 
         //checking if region on the other path has not been already added
-        //TODO discuss if the logic is needed/correct. It complicates the procedure and prevents trivial parallelism.
-        if (retain_one_copy &&
-                AlreadyAdded(other,
-                             other_range.start_pos,
-                             other_range.end_pos) &&
+        //TODO discuss if the logic is needed/correct. It complicates the procedure and makes the marking order dependent.
+        bool check_added = retain_one_copy &&
                 /*forcing "cut_all" behavior on conjugate paths*/
                 &other != path.GetConjPath() &&
                 /*certain overkill*/
-                &other != &path) {
-            return 0;
-        }
+                &other != &path;
 
         if (&other == &path) {
             if (overlap == path.Size())
-                return 0;
+                return Overlap{0, &other, other_range, false};
             overlap = std::min(overlap, other_range.start_pos);
         }
 
@@ -86,17 +99,31 @@ class OverlapRemover {
         DEBUG(other.str());
         DEBUG("Range " << other_range);
 
-        return overlap;
+        return Overlap{overlap, &other, other_range, check_added};
     }
 
-    void MarkStartOverlaps(const BidirectionalPath &path, bool end_start_only, bool retain_one_copy) {
-        set<size_t> overlap_poss;
+    vector<Overlap> FindStartOverlaps(const BidirectionalPath &path, bool end_start_only, bool retain_one_copy) const {
+        vector<Overlap> overlaps;
         for (PathPtr candidate : helper_.FindCandidatePaths(path)) {
-            size_t overlap = AnalyzeOverlaps(path, *candidate,
-                                             end_start_only, retain_one_copy);
-            if (overlap > 0) {
-                overlap_poss.insert(overlap);
+            Overlap overlap = AnalyzeOverlaps(path, *candidate,
+                                              end_start_only, retain_one_copy);
+            if (overlap.size > 0) {
+                overlaps.push_back(overlap);
+            }
+        }
+        return overlaps;
+    }
+
+    void MarkStartOverlaps(const BidirectionalPath &path, const vector<Overlap> &overlaps) {
+        set<size_t> overlap_poss;
+        for (const Overlap &overlap : overlaps) {
+            if (overlap.check_added &&
+                    AlreadyAdded(*overlap.other,
+                                 overlap.other_range.start_pos,
+                                 overlap.other_range.end_pos)) {
+                continue;
             }
+            overlap_poss.insert(overlap.size);
         }
         if (!overlap_poss.empty()) {
             utils::insert_all(splits_[&path], overlap_poss);
@@ -104,12 +131,23 @@ class OverlapRemover {
     }
 
     void InnerMarkOverlaps(bool end_start_only, bool retain_one_copy) {
+        vector<PathPtr> paths;
         for (auto path_pair: paths_) {
             //TODO think if this "optimization" is necessary
             if (path_pair.first->Size() == 0)
                 continue;
-            MarkStartOverlaps(*path_pair.first, end_start_only, retain_one_copy);
-            MarkStartOverlaps(*path_pair.second, end_start_only, retain_one_copy);
+            paths.push_back(path_pair.first);
+            paths.push_back(path_pair.second);
+        }
+
+        vector<vector<Overlap>> overlaps(paths.size());
+        # pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < paths.size(); ++i) {
+            overlaps[i] = FindStartOverlaps(*paths[i], end_start_only, retain_one_copy);
+        }
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            MarkStartOverlaps(*paths[i], overlaps[i]);
         }
     }
 
@@ -207,26 +245,55 @@ private:
     DECL_LOGGER("PathSplitter");
 };
 
+/*
+ * Covering paths are found for all paths in parallel, then the paths are removed in the order
+ * of the container. A path is redundant if its covering path has not been removed before,
+ * otherwise the check is repeated over the paths remaining in the coverage map,
+ * so the result is the same as with the sequential check.
+ */
 class PathDeduplicator {
+    static const size_t NO_COVERING_PATH = std::numeric_limits<size_t>::max();
+    //Covering path does not belong to the container and is never removed
+    static const size_t EXTERNAL_PATH = NO_COVERING_PATH - 1;
+
     const Graph& g_;
     PathContainer &paths_;
     const bool equal_only_;
     const OverlapFindingHelper helper_;
 
+    bool Covers(PathPtr candidate, PathPtr path) const {
+        TRACE("Considering candidate " << candidate->GetId());
+//                VERIFY(candidate != path && candidate != path->GetConjPath());
+        if (candidate == path || candidate == path->GetConjPath())
+            return false;
+        return equal_only_ ? helper_.IsEqual(*path, *candidate) : helper_.IsSubpath(*path, *candidate);
+    }
+
     bool IsRedundant(PathPtr path) const {
         TRACE("Checking if path redundant " << path->GetId());
         for (auto candidate : helper_.FindCandidatePaths(*path)) {
-            TRACE("Considering candidate " << candidate->GetId());
-//                VERIFY(candidate != path && candidate != path->GetConjPath());
-            if (candidate == path || candidate == path->GetConjPath())
-                continue;
-            if (equal_only_ ? helper_.IsEqual(*path, *candidate) : helper_.IsSubpath(*path, *candidate)) {
+            if (Covers(candidate, path))
                 return true;
-            }
         }
         return false;
     }
 
+    //Pair index of the covering path, the latest pairs are tried first as they are less likely to be removed
+    size_t FindCoveringPair(PathPtr path, const unordered_map<PathPtr, size_t> &pair_index) const {
+        TRACE("Checking if path redundant " << path->GetId());
+        vector<std::pair<size_t, PathPtr>> candidates;
+        for (auto candidate : helper_.FindCandidatePaths(*path)) {
+            auto it = pair_index.find(candidate);
+            candidates.emplace_back(it == pair_index.end() ? size_t(EXTERNAL_PATH) : it->second, candidate);
+        }
+        std::sort(candidates.rbegin(), candidates.rend());
+        for (const auto &candidate : candidates) {
+            if (Covers(candidate.second, path))
+                return candidate.first;
+        }
+        return NO_COVERING_PATH;
+    }
+
 public:
 
     PathDeduplicator(const Graph &g,
@@ -242,11 +309,29 @@ public:
 
     //TODO use path container filtering?
     void Deduplicate() {
-        for (auto path_pair : paths_) {
-            auto path = path_pair.first;
-            if (IsRedundant(path)) {
+        unordered_map<PathPtr, size_t> pair_index;
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            pair_index[paths_.Get(i)] = i;
+            pair_index[paths_.GetConjugate(i)] = i;
+        }
+
+        vector<size_t> covering_pair(paths_.size());
+        # pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            covering_pair[i] = FindCoveringPair(paths_.Get(i), pair_index);
+        }
+
+        vector<bool> removed(paths_.size(), false);
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            size_t j = covering_pair[i];
+            if (j == NO_COVERING_PATH)
+                continue;
+            auto path = paths_.Get(i);
+            //removed paths have already left the coverage map
+            if (j == EXTERNAL_PATH || !removed[j] || IsRedundant(path)) {
                 TRACE("Clearing path " << path->str());
                 path->Clear();
+                removed[i] = true;
             }
         }
     }
@@ -17,6 +17,11 @@
 
 #include "assembly_graph/paths/bidirectional_path.hpp"
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace path_extend {
 
 using namespace debruijn_graph;
@@ -35,35 +40,166 @@ inline bool InTwoEdgeCycle(EdgeId e, const Graph &g) {
     return false;
 }
 
+/*
+ * Multiset of paths covering an edge, ordered by path ids as BidirectionalPathMultiset.
+ * Most edges are covered by a couple of paths, these are kept inline,
+ * the buffer is allocated only for the edges covered by more paths.
+ */
+class CoveringPaths {
+    static const uint32_t INLINE_SIZE = 2;
+
+    uint32_t size_;
+    uint32_t capacity_;
+    union {
+        BidirectionalPath *inline_[INLINE_SIZE];
+        BidirectionalPath **heap_;
+    };
+
+    bool OnHeap() const {
+        return capacity_ > INLINE_SIZE;
+    }
+
+    BidirectionalPath **data() {
+        return OnHeap() ? heap_ : inline_;
+    }
+
+    static bool Less(const BidirectionalPath *p1, const BidirectionalPath *p2) {
+        return p1->GetId() < p2->GetId();
+    }
+
+    void Grow() {
+        BidirectionalPath **buffer = new BidirectionalPath *[2 * capacity_];
+        std::copy(begin(), end(), buffer);
+        if (OnHeap())
+            delete[] heap_;
+        heap_ = buffer;
+        capacity_ *= 2;
+    }
+
+public:
+    typedef BidirectionalPath *const *const_iterator;
+    typedef const_iterator iterator;
+
+    CoveringPaths()
+            : size_(0), capacity_(INLINE_SIZE) {}
+
+    CoveringPaths(const CoveringPaths&) = delete;
+    CoveringPaths& operator=(const CoveringPaths&) = delete;
+
+    CoveringPaths(CoveringPaths &&that)
+            : size_(that.size_), capacity_(that.capacity_) {
+        if (that.OnHeap())
+            heap_ = that.heap_;
+        else
+            std::copy(that.inline_, that.inline_ + that.size_, inline_);
+        that.size_ = 0;
+        that.capacity_ = INLINE_SIZE;
+    }
+
+    ~CoveringPaths() {
+        if (OnHeap())
+            delete[] heap_;
+    }
+
+    const_iterator begin() const {
+        return OnHeap() ? heap_ : inline_;
+    }
+
+    const_iterator end() const {
+        return begin() + size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t count(const BidirectionalPath *path) const {
+        auto range = std::equal_range(begin(), end(), path, Less);
+        return size_t(range.second - range.first);
+    }
+
+    void insert(BidirectionalPath *path) {
+        if (size_ == capacity_)
+            Grow();
+        BidirectionalPath **first = data();
+        BidirectionalPath **pos = std::upper_bound(first, first + size_, path, Less);
+        std::copy_backward(pos, first + size_, first + size_ + 1);
+        *pos = path;
+        size_ += 1;
+    }
+
+    // Removes one occurrence of the path, returns false if there was none
+    bool erase(const BidirectionalPath *path) {
+        BidirectionalPath **first = data();
+        BidirectionalPath **pos = std::lower_bound(first, first + size_, path, Less);
+        if (pos == first + size_ || Less(path, *pos))
+            return false;
+        std::copy(pos + 1, first + size_, pos);
+        size_ -= 1;
+        return true;
+    }
+};
+
 // Handles all paths in PathContainer.
 // For each edge output all paths  that _traverse_ this path. If path contains multiple instances - count them. Position of the edge is not reported.
+// Paths of edges are kept in pages indexed by edge int ids, pages are allocated for the covered id ranges only.
+// Concurrent map is sharded by pages and may be updated from many threads at once (but not read while being updated).
 class GraphCoverageMap: public PathListener {
 public:
-    typedef BidirectionalPathMultiset MapDataT;
+    typedef CoveringPaths MapDataT;
 
 private:
+    static const size_t PAGE_BITS = 10;
+    static const size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+    static const size_t LOCK_NUM = 64;
+
     const Graph& g_;
 
-    std::unordered_map<EdgeId, MapDataT * > edge_coverage_;
-    const MapDataT empty_;
+    std::vector<std::unique_ptr<MapDataT[]>> pages_;
+    std::unique_ptr<std::mutex[]> locks_;
 
-    void EdgeAdded(EdgeId e, BidirectionalPath * path) {
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end()) {
-            edge_coverage_.insert(std::make_pair(e, new MapDataT()));
+    MapDataT *Find(EdgeId e) {
+        size_t page = e.int_id() >> PAGE_BITS;
+        if (page >= pages_.size() || !pages_[page])
+            return nullptr;
+        return &pages_[page][e.int_id() & (PAGE_SIZE - 1)];
+    }
+
+    const MapDataT *Find(EdgeId e) const {
+        return const_cast<GraphCoverageMap*>(this)->Find(e);
+    }
+
+    MapDataT &Get(EdgeId e) {
+        size_t page = e.int_id() >> PAGE_BITS;
+        if (page >= pages_.size()) {
+            VERIFY_MSG(!locks_, "Edge id " << e.int_id() << " is out of the concurrent coverage map");
+            pages_.resize(page + 1);
         }
-        edge_coverage_[e]->insert(path);
+        if (!pages_[page])
+            pages_[page].reset(new MapDataT[PAGE_SIZE]);
+        return pages_[page][e.int_id() & (PAGE_SIZE - 1)];
+    }
+
+    std::unique_lock<std::mutex> Lock(EdgeId e) {
+        if (!locks_)
+            return std::unique_lock<std::mutex>();
+        return std::unique_lock<std::mutex>(locks_[(e.int_id() >> PAGE_BITS) % LOCK_NUM]);
+    }
+
+    void EdgeAdded(EdgeId e, BidirectionalPath * path) {
+        auto lock = Lock(e);
+        Get(e).insert(path);
     }
 
     void EdgeRemoved(EdgeId e, BidirectionalPath * path) {
-        auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            if (iter->second->count(path) == 0) {
-                DEBUG("Error erasing path from coverage map");
-            } else {
-                auto entry = iter->second->find(path);
-                iter->second->erase(entry);
-            }
+        auto lock = Lock(e);
+        MapDataT *data = Find(e);
+        if (data && !data->erase(path)) {
+            DEBUG("Error erasing path from coverage map");
         }
     }
 
@@ -75,14 +211,6 @@ private:
         }
     }
 
-    size_t EdgeCount() const {
-        size_t result = 0;
-        for (auto e = g_.ConstEdgeBegin(); !e.IsEnd(); ++e) {
-            ++result;
-        }
-        return result;
-    }
-
 public:
     GraphCoverageMap(const GraphCoverageMap&) = delete;
     GraphCoverageMap& operator=(const GraphCoverageMap&) = delete;
@@ -90,9 +218,12 @@ public:
     GraphCoverageMap(GraphCoverageMap&&) = default;
     GraphCoverageMap& operator=(GraphCoverageMap&&) = default;
 
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
-        //FIXME heavy constructor
-        edge_coverage_.reserve(EdgeCount());
+    // Pages of the concurrent map are laid out for all current ids of the graph
+    explicit GraphCoverageMap(const Graph& g, bool concurrent = false) : g_(g) {
+        if (concurrent) {
+            pages_.resize((g.GetGraphIdDistributor().GetMax() >> PAGE_BITS) + 1);
+            locks_.reset(new std::mutex[LOCK_NUM]);
+        }
     }
 
     GraphCoverageMap(const Graph& g, const PathContainer& paths, bool subscribe = false) :
@@ -100,12 +231,6 @@ public:
         AddPaths(paths, subscribe);
     }
 
-    ~GraphCoverageMap() {
-        for (auto iter = edge_coverage_.begin(); iter != edge_coverage_.end(); ++iter) {
-            delete iter->second;
-        }
-    }
-
     void AddPaths(const PathContainer& paths, bool subscribe = false) {
         for (auto path_pair : paths) {
             ProcessPath(path_pair.first, subscribe);
@@ -138,11 +263,9 @@ public:
     }
 
     const MapDataT *  GetEdgePaths(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            return iter->second;
-        }
-        return &empty_;
+        static const MapDataT empty;
+        const MapDataT *data = Find(e);
+        return data ? data : &empty;
     }
 
     int GetCoverage(EdgeId e) const {
@@ -167,16 +290,12 @@ public:
         return BidirectionalPathSet(mapData->begin(), mapData->end());
     }
 
-    std::unordered_map <EdgeId, MapDataT * >::const_iterator begin() const {
-        return edge_coverage_.begin();
-    }
-
-    std::unordered_map <EdgeId, MapDataT * >::const_iterator end() const {
-        return edge_coverage_.end();
-    }
-
-    size_t size() const {
-        return edge_coverage_.size();
+    // True if no path has ever covered an edge
+    bool empty() const {
+        for (const auto &page : pages_)
+            if (page)
+                return false;
+        return true;
     }
 
     const Graph& graph() const {
@@ -30,7 +30,8 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongReadsExtender(size_t lib_
     if (!dataset_info_.reads[lib_index].is_contig_lib()) {
         resolvable_repeat_length_bound = std::max(resolvable_repeat_length_bound, lib.data().read_length);
     }
-    INFO("resolvable_repeat_length_bound set to " << resolvable_repeat_length_bound);
+    if (verbose_)
+        INFO("resolvable_repeat_length_bound set to " << resolvable_repeat_length_bound);
     bool investigate_short_loop = lib.is_contig_lib() || lib.is_long_read_lib() || support_.UseCoverageResolverForSingleReads(lib.type());
 
     auto long_read_ec = MakeLongReadsExtensionChooser(lib_index, read_paths_cov_map);
@@ -57,6 +58,8 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongEdgePEExtender(size_t lib
         make_shared<LongEdgeExtensionChooser>(gp_.g, wc,
                                               opts.weight_threshold,
                                               opts.priority_coeff);
+    if (params_.pset.cache_paired_info)
+        extension->CachePairedInfo();
 
     return make_shared<SimpleExtender>(gp_, cover_map_,
                                        used_unique_storage_,
@@ -148,14 +151,17 @@ shared_ptr<PathExtender> ExtendersGenerator::MakeMatePairScaffoldingExtender(siz
     const auto &lib = dataset_info_.reads[lib_index];
     const auto &pset = params_.pset;
     shared_ptr<PairedInfoLibrary> paired_lib;
-    INFO("Creating Scaffolding 2015 extender for lib #" << lib_index);
+    if (verbose_)
+        INFO("Creating Scaffolding 2015 extender for lib #" << lib_index);
 
     //FIXME: DimaA
     if (gp_.paired_indices[lib_index].size() > gp_.clustered_indices[lib_index].size()) {
-        INFO("Paired unclustered indices not empty, using them");
+        if (verbose_)
+            INFO("Paired unclustered indices not empty, using them");
         paired_lib = MakeNewLib(gp_.g, lib, gp_.paired_indices[lib_index]);
     } else if (gp_.clustered_indices[lib_index].size() != 0) {
-        INFO("clustered indices not empty, using them");
+        if (verbose_)
+            INFO("clustered indices not empty, using them");
         paired_lib = MakeNewLib(gp_.g, lib, gp_.clustered_indices[lib_index]);
     } else {
         ERROR("All paired indices are empty!");
@@ -200,6 +206,8 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeCoordCoverageExtender(size_t
                                                                          meta_wc,
                                                                          params_.pset.extension_options.weight_threshold,
                                                                          params_.pset.extension_options.priority_coeff);
+    if (params_.pset.cache_paired_info)
+        permissive_pi_chooser->CachePairedInfo();
 
     auto coord_cov_chooser = make_shared<CoordinatedCoverageExtensionChooser>(gp_.g, *provider,
                                                                               params_.pset.coordinated_coverage.max_edge_length_in_repeat,
@@ -232,6 +240,8 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeRNAExtender(size_t lib_index,
         make_shared<RNAExtensionChooser>(gp_.g, wc,
                                          opts.weight_threshold,
                                          opts.priority_coeff);
+    if (params_.pset.cache_paired_info)
+        extension->CachePairedInfo();
 
     return make_shared<MultiExtender>(gp_, cover_map_,
                                       used_unique_storage_,
@@ -272,7 +282,8 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakePEExtender(size_t lib_index,
             iip = make_shared<CoverageAwareIdealInfoProvider>(gp_.g, paired_lib, dataset_info_.RL());
         } else {
             double lib_cov = support_.EstimateLibCoverage(lib_index);
-            INFO("Estimated coverage of library #" << lib_index << " is " << lib_cov);
+            if (verbose_)
+                INFO("Estimated coverage of library #" << lib_index << " is " << lib_cov);
             iip = make_shared<GlobalCoverageAwareIdealInfoProvider>(gp_.g, paired_lib, dataset_info_.RL(), lib_cov);
         }
     }
@@ -283,6 +294,8 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakePEExtender(size_t lib_index,
     auto extension_chooser = make_shared<SimpleExtensionChooser>(gp_.g, wc,
                                                          opts.weight_threshold,
                                                          opts.priority_coeff);
+    if (params_.pset.cache_paired_info)
+        extension_chooser->CachePairedInfo();
 
     return make_shared<SimpleExtender>(gp_, cover_map_,
                                        used_unique_storage_,
@@ -327,7 +340,8 @@ void ExtendersGenerator::PrintExtenders(const Extenders &extenders) const {
 
 Extenders ExtendersGenerator::MakeMPExtenders() const {
     Extenders extenders = MakeMPExtenders(unique_data_.main_unique_storage_);
-    INFO("Using " << extenders.size() << " mate-pair " << support_.LibStr(extenders.size()));
+    if (verbose_)
+        INFO("Using " << extenders.size() << " mate-pair " << support_.LibStr(extenders.size()));
 
     for (const auto& unique_storage : unique_data_.unique_storages_) {
         utils::push_back_all(extenders, MakeMPExtenders(unique_storage));
@@ -357,7 +371,8 @@ Extenders ExtendersGenerator::MakePBScaffoldingExtenders() const {
 
     for (size_t lib_index = 0; lib_index < dataset_info_.reads.lib_count(); lib_index++) {
         if (support_.IsForSingleReadScaffolder(dataset_info_.reads[lib_index])) {
-            INFO("Creating scaffolding extender for lib " << lib_index);
+            if (verbose_)
+                INFO("Creating scaffolding extender for lib " << lib_index);
             shared_ptr<ConnectionCondition> condition = make_shared<LongReadsLibConnectionCondition>(gp_.g,
                                                                                                      lib_index, 2,
                                                                                                      unique_data_.long_reads_cov_map_[lib_index]);
@@ -383,7 +398,8 @@ Extenders ExtendersGenerator::MakePBScaffoldingExtenders() const {
 
         }
     }
-    INFO("Using " << result.size() << " long reads scaffolding " << support_.LibStr(result.size()));
+    if (verbose_)
+        INFO("Using " << result.size() << " long reads scaffolding " << support_.LibStr(result.size()));
     std::stable_sort(result.begin(), result.end());
 
     return ExtractExtenders(result);
@@ -393,7 +409,8 @@ Extenders ExtendersGenerator::MakePBScaffoldingExtenders() const {
 Extenders ExtendersGenerator::MakeCoverageExtenders() const {
     Extenders result;
 
-    INFO("Using additional coordinated coverage extender");
+    if (verbose_)
+        INFO("Using additional coordinated coverage extender");
     result.push_back(MakeCoordCoverageExtender(0 /* lib index */));
 
     return result;
@@ -469,9 +486,11 @@ Extenders ExtendersGenerator::MakeBasicExtenders() const {
     utils::push_back_all(result, ExtractExtenders(scaffolding_extenders));
     utils::push_back_all(result, ExtractExtenders(loop_resolving_extenders));
 
-    INFO("Using " << pe_libs << " paired-end " << support_.LibStr(pe_libs));
-    INFO("Using " << scf_pe_libs << " paired-end scaffolding " << support_.LibStr(scf_pe_libs));
-    INFO("Using " << single_read_libs << " single read " << support_.LibStr(single_read_libs));
+    if (verbose_) {
+        INFO("Using " << pe_libs << " paired-end " << support_.LibStr(pe_libs));
+        INFO("Using " << scf_pe_libs << " paired-end scaffolding " << support_.LibStr(scf_pe_libs));
+        INFO("Using " << single_read_libs << " single read " << support_.LibStr(single_read_libs));
+    }
 
     PrintExtenders(result);
     return result;
@@ -50,6 +50,8 @@ class ExtendersGenerator {
     UsedUniqueStorage &used_unique_storage_;
 
     const PELaunchSupport &support_;
+    //Per-thread copies for parallel growth are made quietly
+    const bool verbose_;
 
 public:
     ExtendersGenerator(const config::dataset &dataset_info,
@@ -58,14 +60,16 @@ public:
                        const GraphCoverageMap &cover_map,
                        const UniqueData &unique_data,
                        UsedUniqueStorage &used_unique_storage,
-                       const PELaunchSupport& support) :
+                       const PELaunchSupport& support,
+                       bool verbose = true) :
         dataset_info_(dataset_info),
         params_(params),
         gp_(gp),
         cover_map_(cover_map),
         unique_data_(unique_data),
         used_unique_storage_(used_unique_storage),
-        support_(support) { }
+        support_(support),
+        verbose_(verbose) { }
 
     Extenders MakePBScaffoldingExtenders() const;
 
@@ -304,7 +304,7 @@ void PathExtendLauncher::AddScaffUniqueStorage(size_t uniqe_edge_len) {
     additional_edge_analyzer.FillUniqueEdgeStorage(unique_data_.unique_storages_.back());
 }
 
-Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &generator) {
+void PathExtendLauncher::FillMPUniqueEdgeStorages() {
     const pe_config::ParamSetT &pset = params_.pset;
 
     size_t cur_length = unique_data_.min_unique_length_ - pset.scaffolding2015.unique_length_step;
@@ -319,8 +319,6 @@ Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &gen
         INFO("Will add final extenders for length " << lower_bound);
         AddScaffUniqueStorage(lower_bound);
     }
-
-    return generator.MakeMPExtenders();
 }
 
 void PathExtendLauncher::FillPathContainer(size_t lib_index, size_t size_threshold) {
@@ -382,43 +380,52 @@ void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     INFO(unique_data_.unique_pb_storage_.size() << " unique edges");
 }
 
-Extenders PathExtendLauncher::ConstructPBExtenders(const ExtendersGenerator &generator) {
-    FillPBUniqueEdgeStorages();
-    return generator.MakePBScaffoldingExtenders();
-}
-
-
-Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
-                                                 UsedUniqueStorage &used_unique_storage) {
-    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
+void PathExtendLauncher::FillExtendersData() {
     if (support_.SingleReadsMapped() || support_.HasLongReads())
         FillLongReadsCoverageMaps();
 
+    if (params_.pset.sm == sm_old)
+        return;
+    if (support_.HasLongReads())
+        FillPBUniqueEdgeStorages();
+    if (support_.HasMPReads())
+        FillMPUniqueEdgeStorages();
+}
+
+//Extenders data should be filled before
+Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
+                                                 UsedUniqueStorage &used_unique_storage,
+                                                 bool verbose) const {
+    if (verbose)
+        INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
     ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
-                                 unique_data_, used_unique_storage, support_);
+                                 unique_data_, used_unique_storage, support_, verbose);
     Extenders extenders = generator.MakeBasicExtenders();
 
     //long reads scaffolding extenders.
     if (support_.HasLongReads()) {
         if (params_.pset.sm == sm_old) {
-            INFO("Will not use new long read scaffolding algorithm in this mode");
+            if (verbose)
+                INFO("Will not use new long read scaffolding algorithm in this mode");
         } else {
-            utils::push_back_all(extenders, ConstructPBExtenders(generator));
+            utils::push_back_all(extenders, generator.MakePBScaffoldingExtenders());
         }
     }
 
     if (support_.HasMPReads()) {
         if (params_.pset.sm == sm_old) {
-            INFO("Will not use mate-pairs is this mode");
+            if (verbose)
+                INFO("Will not use mate-pairs is this mode");
         } else {
-            utils::push_back_all(extenders, ConstructMPExtenders(generator));
+            utils::push_back_all(extenders, generator.MakeMPExtenders());
         }
     }
 
     if (params_.pset.use_coordinated_coverage)
         utils::push_back_all(extenders, generator.MakeCoverageExtenders());
 
-    INFO("Total number of extenders is " << extenders.size());
+    if (verbose)
+        INFO("Total number of extenders is " << extenders.size());
     return extenders;
 }
 
@@ -474,6 +481,27 @@ void PathExtendLauncher::FilterPaths() {
     }
 }
 
+void PathExtendLauncher::CheckParallelExtension(PathContainer &seeds, const PathContainer &paths,
+                                                const PathExtendResolver &resolver) const {
+    INFO("Growing paths sequentially to check the parallel growth");
+    GraphCoverageMap cover_map(gp_.g);
+    UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_);
+    CompositeExtender composite_extender(gp_.g, cover_map,
+                                         used_unique_storage,
+                                         ConstructExtenders(cover_map, used_unique_storage, /*verbose*/false),
+                                         params_.max_path_diff);
+    auto sequential_paths = resolver.ExtendSeeds(seeds, composite_extender);
+
+    VERIFY_MSG(sequential_paths.size() == paths.size(),
+               "Parallel growth gave " << paths.size() << " paths instead of " << sequential_paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        VERIFY_MSG(*paths.Get(i) == *sequential_paths.Get(i) &&
+                   *paths.GetConjugate(i) == *sequential_paths.GetConjugate(i),
+                   "Path " << i << " differs from the one grown sequentially");
+    }
+    INFO("Parallel growth gave the same paths");
+}
+
 void PathExtendLauncher::Launch() {
     INFO("ExSPAnder repeat resolving tool started");
     make_dir(params_.output_dir);
@@ -493,6 +521,7 @@ void PathExtendLauncher::Launch() {
     seeds.SortByLength();
     DebugOutputPaths(seeds, "init_paths");
 
+    FillExtendersData();
     GraphCoverageMap cover_map(gp_.g);
     UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_);
     Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
@@ -500,9 +529,18 @@ void PathExtendLauncher::Launch() {
                                          used_unique_storage,
                                          extenders,
                                          params_.max_path_diff);
+    if (params_.pe_cfg.parallel_extension) {
+        composite_extender.EnableParallelGrowth(omp_get_max_threads(),
+                                                [this](const GraphCoverageMap &thread_cover_map,
+                                                       UsedUniqueStorage &thread_used_storage) {
+            return ConstructExtenders(thread_cover_map, thread_used_storage, /*verbose*/false);
+        });
+    }
 
     auto paths = resolver.ExtendSeeds(seeds, composite_extender);
     DebugOutputPaths(paths, "raw_paths");
+    if (params_.pe_cfg.parallel_extension && params_.pe_cfg.check_parallel_extension)
+        CheckParallelExtension(seeds, paths, resolver);
 
     RemoveOverlapsAndArtifacts(paths, cover_map, resolver);
     DebugOutputPaths(paths, "before_loop_traversal");
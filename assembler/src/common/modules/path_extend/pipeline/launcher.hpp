@@ -67,13 +67,17 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
-    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
+    void FillExtendersData();
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage,
+                                 bool verbose = true) const;
 
-    void AddScaffUniqueStorage(size_t uniqe_edge_len);
+    void CheckParallelExtension(PathContainer &seeds, const PathContainer &paths,
+                                const PathExtendResolver &resolver) const;
+
+    void FillMPUniqueEdgeStorages();
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
+    void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
     void FilterPaths();
 
@@ -18,6 +18,8 @@
 #include "assembly_graph/paths/bidirectional_path.hpp"
 #include "paired_library.hpp"
 #include <algorithm>
+#include <limits>
+#include <memory>
 #include <boost/math/special_functions/fpclassify.hpp>
 
 namespace path_extend {
@@ -57,6 +59,65 @@ struct EdgeWithPairedInfo {
     }
 };
 
+// Ideal and actual paired info between the edge of the path with the given index and a candidate
+struct PathEdgePairedInfo {
+    size_t e_;
+    double ideal_;
+    double actual_;
+
+    PathEdgePairedInfo(size_t e, double ideal, double actual) :
+            e_(e), ideal_(ideal), actual_(actual) {
+    }
+};
+
+/*
+ * Paired info between a path and candidate extensions memoized for the current state of the path.
+ * Within a step choosers ask for the same path and candidates several times
+ * (ambiguity exclusion, then weights), the info is collected once
+ * and is dropped as soon as the path changes.
+ */
+class PathPairedInfoCache {
+    struct Entry {
+        EdgeId candidate;
+        int gap;
+        std::vector<PathEdgePairedInfo> info;
+    };
+
+    uint64_t path_id_;
+    size_t version_;
+    //entries beyond size_ are not valid, their storage is reused
+    std::vector<Entry> entries_;
+    size_t size_;
+
+public:
+    PathPairedInfoCache() :
+            path_id_(std::numeric_limits<uint64_t>::max()), version_(0), size_(0) {
+    }
+
+    //Returns the storage for the info and sets cached if it is already filled
+    std::vector<PathEdgePairedInfo>& Get(const BidirectionalPath& path, EdgeId candidate, int gap, bool& cached) {
+        if (path.GetId() != path_id_ || path.Version() != version_) {
+            path_id_ = path.GetId();
+            version_ = path.Version();
+            size_ = 0;
+        }
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].candidate == candidate && entries_[i].gap == gap) {
+                cached = true;
+                return entries_[i].info;
+            }
+        }
+        if (size_ == entries_.size())
+            entries_.emplace_back();
+        Entry& entry = entries_[size_++];
+        entry.candidate = candidate;
+        entry.gap = gap;
+        entry.info.clear();
+        cached = false;
+        return entry.info;
+    }
+};
+
 struct EdgeWithDistance {
     EdgeId e_;
     int d_;
@@ -113,6 +174,34 @@ protected:
     bool normalize_weight_;
     shared_ptr<IdealInfoProvider> ideal_provider_;
 
+    void CollectPairedInfo(const BidirectionalPath& path, EdgeId e, int gap,
+                           std::vector<PathEdgePairedInfo>& info) const {
+        info.clear();
+        for (const EdgeWithPairedInfo& e_w_pi : ideal_provider_->FindCoveredEdges(path, e, gap)) {
+            double actual = lib_->CountPairedInfo(path[e_w_pi.e_], e,
+                                                  (int) path.LengthAt(e_w_pi.e_) + gap);
+            info.push_back(PathEdgePairedInfo(e_w_pi.e_, e_w_pi.pi_, actual));
+        }
+    }
+
+    //Ideal and actual info for all ideally covered edges of the path,
+    //without caching it is collected into the caller's buffer
+    const std::vector<PathEdgePairedInfo>& PairedInfo(const BidirectionalPath& path, EdgeId e, int gap,
+                                                      std::vector<PathEdgePairedInfo>& buffer) const {
+        if (!cache_) {
+            CollectPairedInfo(path, e, gap, buffer);
+            return buffer;
+        }
+        bool cached = false;
+        std::vector<PathEdgePairedInfo>& info = cache_->Get(path, e, gap, cached);
+        if (!cached)
+            CollectPairedInfo(path, e, gap, info);
+        return info;
+    }
+
+private:
+    mutable std::unique_ptr<PathPairedInfoCache> cache_;
+
 public:
 
     WeightCounter(const Graph& g, shared_ptr<PairedInfoLibrary> lib,
@@ -134,6 +223,12 @@ public:
         return *lib_;
     }
 
+    //Reuse paired info of the path while it stays the same
+    void CachePairedInfo() {
+        if (!cache_)
+            cache_.reset(new PathPairedInfoCache());
+    }
+
 protected:
     DECL_LOGGER("WeightCounter");
 };
@@ -144,14 +239,14 @@ class ReadCountWeightCounter: public WeightCounter {
             int add_gap = 0) const {
         std::vector<EdgeWithPairedInfo> answer;
 
-        for (const EdgeWithPairedInfo& e_w_pi : ideal_provider_->FindCoveredEdges(path, e, add_gap)) {
-            double w = lib_->CountPairedInfo(path[e_w_pi.e_], e,
-                    (int) path.LengthAt(e_w_pi.e_) + add_gap);
+        std::vector<PathEdgePairedInfo> buffer;
+        for (const PathEdgePairedInfo& info : PairedInfo(path, e, add_gap, buffer)) {
+            double w = info.actual_;
 
             if (normalize_weight_) {
-                w /= e_w_pi.pi_;
+                w /= info.ideal_;
             }
-            answer.push_back(EdgeWithPairedInfo(e_w_pi.e_, w));
+            answer.push_back(EdgeWithPairedInfo(info.e_, w));
         }
 
         return answer;
@@ -195,34 +290,33 @@ public:
 class PathCoverWeightCounter: public WeightCounter {
     double single_threshold_;
 
-    double TotalIdealNonExcluded(const std::vector<EdgeWithPairedInfo>& ideally_covered_edges, 
+    double TotalIdealNonExcluded(const std::vector<PathEdgePairedInfo>& ideally_covered_edges,
                         const std::set<size_t>& excluded_edges) const {
         double ideal_total = 0.0;
 
-        for (const EdgeWithPairedInfo& e_w_pi : ideally_covered_edges) {
-            if (!excluded_edges.count(e_w_pi.e_))
-                ideal_total += e_w_pi.pi_;
+        for (const PathEdgePairedInfo& info : ideally_covered_edges) {
+            if (!excluded_edges.count(info.e_))
+                ideal_total += info.ideal_;
         }
 
         return ideal_total;
     }
 
     std::vector<EdgeWithPairedInfo> CountLib(const BidirectionalPath& path, EdgeId e,
-            const std::vector<EdgeWithPairedInfo>& ideally_covered_edges, int add_gap = 0) const {
+            const std::vector<PathEdgePairedInfo>& ideally_covered_edges, int add_gap = 0) const {
         std::vector<EdgeWithPairedInfo> answer;
 
-        for (const auto& e_w_pi : ideally_covered_edges) {
-            double ideal_weight = e_w_pi.pi_;
-            TRACE("Supposedly covered edge " << e_w_pi.e_ << " "
-                                            << g_.str(path.At(e_w_pi.e_))
+        for (const auto& info : ideally_covered_edges) {
+            double ideal_weight = info.ideal_;
+            TRACE("Supposedly covered edge " << info.e_ << " "
+                                            << g_.str(path.At(info.e_))
                                             << " ideal weight " << ideal_weight);
 
-            TRACE("Querying paired library for edges " << g_.str(path[e_w_pi.e_])
+            TRACE("Querying paired library for edges " << g_.str(path[info.e_])
                                                        << " " << g_.str(e) << " at dist "
-                                                       << (path.LengthAt(e_w_pi.e_) + add_gap));
+                                                       << (path.LengthAt(info.e_) + add_gap));
 
-            double weight = lib_->CountPairedInfo(path[e_w_pi.e_], e,
-                    (int) path.LengthAt(e_w_pi.e_) + add_gap);
+            double weight = info.actual_;
 
             TRACE("Actual weight " << weight);
 
@@ -233,7 +327,7 @@ class PathCoverWeightCounter: public WeightCounter {
             TRACE("After normalization " << weight << " threshold " << single_threshold_);
 
             if (math::ge(weight, single_threshold_)) {
-                answer.push_back(EdgeWithPairedInfo(e_w_pi.e_, ideal_weight));
+                answer.push_back(EdgeWithPairedInfo(info.e_, ideal_weight));
             }
         }
 
@@ -255,7 +349,8 @@ public:
             const std::set<size_t>& excluded_edges, int gap) const override {
         TRACE("Counting weight for edge " << g_.str(e));
         double lib_weight = 0.;
-        const auto ideal_coverage = ideal_provider_->FindCoveredEdges(path, e, gap);
+        std::vector<PathEdgePairedInfo> buffer;
+        const auto& ideal_coverage = PairedInfo(path, e, gap, buffer);
 
         for (const auto& e_w_pi : CountLib(path, e, ideal_coverage, gap)) {
             if (!excluded_edges.count(e_w_pi.e_)) {
@@ -275,7 +370,8 @@ public:
     std::set<size_t> PairInfoExist(const BidirectionalPath& path, EdgeId e, 
                                     int gap = 0) const override {
         std::set<size_t> answer;
-        for (const auto& e_w_pi : CountLib(path, e, ideal_provider_->FindCoveredEdges(path, e, gap), gap)) {
+        std::vector<PathEdgePairedInfo> buffer;
+        for (const auto& e_w_pi : CountLib(path, e, PairedInfo(path, e, gap, buffer), gap)) {
             if (math::gr(e_w_pi.pi_, 0.)) {
                 answer.insert(e_w_pi.e_);
             }
@@ -289,6 +385,20 @@ class CoverageAwareIdealInfoProvider : public BasicIdealInfoProvider {
     const Graph& g_;
     size_t read_length_; 
 
+    //coverage estimate of the last path, it is the same for all candidates
+    mutable uint64_t estimated_path_id_;
+    mutable size_t estimated_version_;
+    mutable double estimated_coverage_;
+
+    double PathCoverage(const BidirectionalPath& path) const {
+        if (path.GetId() != estimated_path_id_ || path.Version() != estimated_version_) {
+            estimated_path_id_ = path.GetId();
+            estimated_version_ = path.Version();
+            estimated_coverage_ = EstimatePathCoverage(path);
+        }
+        return estimated_coverage_;
+    }
+
 public:
     //works for single lib only!!!
     virtual double EstimatePathCoverage(const BidirectionalPath& path) const  {
@@ -302,15 +412,16 @@ public:
 
     CoverageAwareIdealInfoProvider(const Graph& g, const shared_ptr<PairedInfoLibrary>& lib,
                                     size_t read_length) :
-                BasicIdealInfoProvider(lib), g_(g), read_length_(read_length) {
+                BasicIdealInfoProvider(lib), g_(g), read_length_(read_length),
+                estimated_path_id_(std::numeric_limits<uint64_t>::max()), estimated_version_(0),
+                estimated_coverage_(0.) {
         VERIFY(read_length_ > g_.k());
     }
 
-    //TODO optimize number of calls of EstimatePathCoverage(path)
     std::vector<EdgeWithPairedInfo> FindCoveredEdges(const BidirectionalPath& path, EdgeId candidate, int gap) const override {
         VERIFY(read_length_ != -1ul);
         //bypassing problems with ultra-low coverage estimates
-        double estimated_coverage = max(EstimatePathCoverage(path), 1.0);
+        double estimated_coverage = max(PathCoverage(path), 1.0);
         double correction_coeff = estimated_coverage / ((double(read_length_) - double(g_.k())) * MAGIC_COEFF);
         TRACE("Estimated coverage " << estimated_coverage);
         TRACE("Correction coefficient " << correction_coeff);
@@ -1050,90 +1050,64 @@ private:
     DECL_LOGGER("LocalizedComponentFinder");
 };
 
+//Component with the skeleton tree found for it, stored without attaching anything to the graph
 template<class Graph>
-class CandidateFinder : public VertexCondition<Graph> {
+struct BulgeCandidate {
     typedef typename Graph::VertexId VertexId;
-    size_t max_length_;
-    size_t length_diff_;
-
-public:
-    CandidateFinder(const Graph& g, size_t max_length, size_t length_diff) : 
-        VertexCondition<Graph>(g), max_length_(max_length), length_diff_(length_diff) {
-    }
+    typedef typename Graph::EdgeId EdgeId;
 
-    bool Check(VertexId v) const override {
-        const Graph& g = this->g();
-        LocalizedComponentFinder<Graph> comp_finder(g, max_length_,
-                                                    length_diff_, v);
-        while (comp_finder.ProceedFurther()) {
-            DEBUG("Found component candidate start_v " << g.str(v));
-            LocalizedComponent<Graph> component = comp_finder.component();
-            //todo introduce reasonable size bound
-            //if (component.size() > 1000) {
-            //    return false;
-            //}
-            ComponentColoring<Graph> coloring(component);
-            SkeletonTreeFinder<Graph> tree_finder(component, coloring);
-            DEBUG("Looking for a tree");
-            if (tree_finder.FindTree()) {
-                return true;
-            }
-        }
-        return false;
-    }
-private:
-    DECL_LOGGER("CBRCandidateFinder");
+    size_t candidate_cnt;
+    VertexId start_vertex;
+    //in the order of heights
+    vector<pair<VertexId, Range>> vertex_depth;
+    set<EdgeId> tree_edges;
 };
 
+//Components are searched in parallel and projected in batches of non-overlapping ones
 template<class Graph>
-class ComplexBulgeRemover : public PersistentProcessingAlgorithm<Graph, typename Graph::VertexId> {
+class ComplexBulgeRemover : public ComponentBatchAlgorithm<Graph, BulgeCandidate<Graph>> {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
-    typedef PersistentProcessingAlgorithm<Graph, VertexId> base;
+    typedef BulgeCandidate<Graph> Candidate;
+    typedef ComponentBatchAlgorithm<Graph, Candidate> base;
 
     size_t max_length_;
     size_t length_diff_;
     string pics_folder_;
 
-    bool ProcessComponent(LocalizedComponent<Graph>& component,
-            size_t candidate_cnt) {
-        DEBUG("Processing component");
-        ComponentColoring<Graph> coloring(component);
-        SkeletonTreeFinder<Graph> tree_finder(component, coloring);
-        DEBUG("Looking for a tree");
-        if (tree_finder.FindTree()) {
-            DEBUG("Tree found");
-            SkeletonTree<Graph> tree(component, tree_finder.GetTreeEdges());
-
-            if (!pics_folder_.empty()) {
-                PrintComponent(component, tree,
-                        pics_folder_ + "success/"
-                                + std::to_string(this->g().int_id(component.start_vertex()))
-                                + "_" + std::to_string(candidate_cnt) + ".dot");
-            }
+    bool ProjectComponent(const LocalizedComponent<Graph>& component,
+                          const ComponentColoring<Graph>& coloring,
+                          const SkeletonTree<Graph>& tree,
+                          size_t candidate_cnt) {
+        if (!pics_folder_.empty()) {
+            PrintComponent(component, tree,
+                    pics_folder_ + "success/"
+                            + std::to_string(this->g().int_id(component.start_vertex()))
+                            + "_" + std::to_string(candidate_cnt) + ".dot");
+        }
 
-            ComponentProjector<Graph> projector(this->g(), component, coloring, tree);
-            if (!projector.ProjectComponent()) {
-                //todo think of stopping the whole process
-                DEBUG("Component can't be projected");
-                return false;
-            }
-            DEBUG("Successfully processed component candidate " << candidate_cnt << " start_v " << this->g().str(component.start_vertex()));
-            return true;
-        } else {
-            DEBUG("Failed to find skeleton tree for candidate " << candidate_cnt << " start_v " << this->g().str(component.start_vertex()));
-            if (!pics_folder_.empty()) {
-                //todo check if we rewrite all of the previous pics!
-                PrintComponent(component,
-                        pics_folder_ + "fail/"
-                                + std::to_string(this->g().int_id(component.start_vertex())) //+ "_" + std::to_string(candidate_cnt)
-                                + ".dot");
-            }
+        ComponentProjector<Graph> projector(this->g(), component, coloring, tree);
+        if (!projector.ProjectComponent()) {
+            //todo think of stopping the whole process
+            DEBUG("Component can't be projected");
             return false;
         }
+        DEBUG("Successfully processed component candidate " << candidate_cnt << " start_v " << this->g().str(component.start_vertex()));
+        return true;
+    }
+
+    //todo shrink this set if needed
+    set<VertexId> Neighbours(VertexId v) const {
+        set<VertexId> answer;
+        for (EdgeId e : this->g().IncidentEdges(v)) {
+            answer.insert(this->g().EdgeStart(e));
+            answer.insert(this->g().EdgeEnd(e));
+        }
+        return answer;
     }
 
-    bool InnerProcess(VertexId v, std::vector<VertexId>& vertices_to_post_process) {
+protected:
+    boost::optional<Candidate> Find(VertexId v) const override {
         size_t candidate_cnt = 0;
         LocalizedComponentFinder<Graph> comp_finder(this->g(), max_length_,
                                                     length_diff_, v);
@@ -1141,52 +1115,61 @@ class ComplexBulgeRemover : public PersistentProcessingAlgorithm<Graph, typename
             candidate_cnt++;
             DEBUG("Found component candidate " << candidate_cnt << " start_v " << this->g().str(v));
             LocalizedComponent<Graph> component = comp_finder.component();
-            if (ProcessComponent(component, candidate_cnt)) {
-                GraphComponent<Graph> gc = component.AsGraphComponent();
-                std::copy(gc.v_begin(), gc.v_end(), std::back_inserter(vertices_to_post_process));
-                return true;
+            ComponentColoring<Graph> coloring(component);
+            SkeletonTreeFinder<Graph> tree_finder(component, coloring);
+            DEBUG("Looking for a tree");
+            if (tree_finder.FindTree()) {
+                DEBUG("Tree found");
+                Candidate answer{candidate_cnt, v, {}, tree_finder.GetTreeEdges()};
+                for (const auto& height_and_v : component.height_2_vertices())
+                    answer.vertex_depth.push_back(make_pair(height_and_v.second,
+                                                            component.distance_range(height_and_v.second)));
+                return answer;
+            }
+            DEBUG("Failed to find skeleton tree for candidate " << candidate_cnt << " start_v " << this->g().str(v));
+            if (!pics_folder_.empty()) {
+                //todo check if we rewrite all of the previous pics!
+                PrintComponent(component,
+                        pics_folder_ + "fail/"
+                                + std::to_string(this->g().int_id(v)) //+ "_" + std::to_string(candidate_cnt)
+                                + ".dot");
             }
         }
-        return false;
+        return boost::none;
     }
 
-    //todo shrink this set if needed
-    set<VertexId> Neighbours(VertexId v) const {
-        set<VertexId> answer;
-        for (EdgeId e : this->g().IncidentEdges(v)) {
-            answer.insert(this->g().EdgeStart(e));
-            answer.insert(this->g().EdgeEnd(e));
-        }
+    std::vector<VertexId> ComponentVertices(const Candidate& candidate) const override {
+        std::vector<VertexId> answer;
+        for (const auto& v_and_depth : candidate.vertex_depth)
+            answer.push_back(v_and_depth.first);
         return answer;
     }
 
-public:
-
-    //track_changes=false leads to every iteration run from scratch
-    ComplexBulgeRemover(Graph& g, size_t max_length, size_t length_diff,
-                        size_t chunk_cnt, const string& pics_folder = "") :
-            base(g, std::make_shared<omnigraph::ParallelInterestingElementFinder<Graph, VertexId>>(
-                CandidateFinder<Graph>(g, max_length, length_diff), chunk_cnt), 
-                false, std::less<VertexId>(), /*track changes*/false),
-            max_length_(max_length), 
-            length_diff_(length_diff), 
-            pics_folder_(pics_folder) {
-        if (!pics_folder_.empty()) {
-//            remove_dir(pics_folder_);
-            make_dir(pics_folder_);
-            make_dir(pics_folder_ + "success/");
-            make_dir(pics_folder_ + "fail/");
+    //component, coloring and tree are handlers, they should be gone before the vertices are compressed
+    bool ProjectCandidate(const Candidate& candidate, vector<VertexId>& vertices_to_post_process) {
+        //nothing around was changed since the search, so the component is restored as it was found
+        LocalizedComponent<Graph> component(this->g(), candidate.start_vertex);
+        for (const auto& v_and_depth : candidate.vertex_depth) {
+            if (v_and_depth.first != candidate.start_vertex)
+                component.AddVertex(v_and_depth.first, v_and_depth.second);
         }
+        ComponentColoring<Graph> coloring(component);
+        SkeletonTree<Graph> tree(component, candidate.tree_edges);
 
+        if (!ProjectComponent(component, coloring, tree, candidate.candidate_cnt))
+            return false;
+        GraphComponent<Graph> gc = component.AsGraphComponent();
+        std::copy(gc.v_begin(), gc.v_end(), std::back_inserter(vertices_to_post_process));
+        return true;
     }
 
-    bool Process(VertexId v) override {
+    bool Commit(VertexId v, Candidate& candidate) override {
         DEBUG("Processing vertex " << this->g().str(v));
         vector<VertexId> vertices_to_post_process;
         //a bit of hacking (look further)
         SmartSetIterator<Graph, VertexId> added_vertices(this->g(), true);
 
-        if (InnerProcess(v, vertices_to_post_process)) {
+        if (ProjectCandidate(candidate, vertices_to_post_process)) {
             for (VertexId p_p : vertices_to_post_process) {
                 //Neighbours(p_p) includes p_p
                 for (VertexId n : Neighbours(p_p)) {
@@ -1206,6 +1189,24 @@ public:
         }
     }
 
+public:
+
+    //every run starts from scratch
+    ComplexBulgeRemover(Graph& g, size_t max_length, size_t length_diff,
+                        size_t chunk_cnt, const string& pics_folder = "") :
+            base(g, chunk_cnt),
+            max_length_(max_length), 
+            length_diff_(length_diff), 
+            pics_folder_(pics_folder) {
+        if (!pics_folder_.empty()) {
+//            remove_dir(pics_folder_);
+            make_dir(pics_folder_);
+            make_dir(pics_folder_ + "success/");
+            make_dir(pics_folder_ + "fail/");
+        }
+
+    }
+
 private:
     DECL_LOGGER("ComplexBulgeRemover");
 };
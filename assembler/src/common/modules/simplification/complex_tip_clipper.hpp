@@ -120,43 +120,34 @@ private:
     DECL_LOGGER("ComplexTipClipper")
 };
 
+//Tips are searched in parallel and removed in batches of non-overlapping ones
 template<class Graph>
-class ComplexTipClipper : public PersistentProcessingAlgorithm<Graph, typename Graph::VertexId> {
+class ComplexTipClipper : public ComponentBatchAlgorithm<Graph, GraphComponent<Graph>> {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
-    typedef PersistentProcessingAlgorithm<Graph, VertexId> base;
+    typedef ComponentBatchAlgorithm<Graph, GraphComponent<Graph>> base;
     typedef typename ComponentRemover<Graph>::HandlerF HandlerF;
 
     string pics_folder_;
     ComplexTipFinder<Graph> finder_;
     ComponentRemover<Graph> component_remover_;
 
-public:
-    //track_changes=false leads to every iteration run from scratch
-    ComplexTipClipper(Graph& g, double relative_coverage,
-                      size_t max_edge_len, size_t max_path_len,
-                      size_t chunk_cnt,
-                      const string& pics_folder = "" ,
-                      HandlerF removal_handler = nullptr) :
-            base(g, nullptr, false, std::less<VertexId>(), /*track changes*/false),
-            pics_folder_(pics_folder),
-            finder_(g, relative_coverage, max_edge_len, max_path_len),
-            component_remover_(g, removal_handler) {
-        if (!pics_folder_.empty()) {
-            make_dir(pics_folder_);
-        }
-        this->interest_el_finder_ = std::make_shared<ParallelInterestingElementFinder<Graph, VertexId>>(
-                [&](VertexId v) {return !finder_(v).empty();}, chunk_cnt);
-    }
-
-    bool Process(VertexId v) override {
-        DEBUG("Processing vertex " << this->g().str(v));
+protected:
+    boost::optional<GraphComponent<Graph>> Find(VertexId v) const override {
         auto component = finder_(v);
         if (component.empty()) {
             DEBUG("Failed to detect complex tip starting with vertex " << this->g().str(v));
-            return false;
+            return boost::none;
         }
+        return component;
+    }
 
+    std::vector<VertexId> ComponentVertices(const GraphComponent<Graph>& component) const override {
+        return std::vector<VertexId>(component.v_begin(), component.v_end());
+    }
+
+    bool Commit(VertexId v, GraphComponent<Graph>& component) override {
+        DEBUG("Processing vertex " << this->g().str(v));
         if (!pics_folder_.empty()) {
             visualization::visualization_utils::WriteComponentSinksSources(component,
                                                       pics_folder_
@@ -171,6 +162,21 @@ public:
         return true;
     }
 
+public:
+    ComplexTipClipper(Graph& g, double relative_coverage,
+                      size_t max_edge_len, size_t max_path_len,
+                      size_t chunk_cnt,
+                      const string& pics_folder = "" ,
+                      HandlerF removal_handler = nullptr) :
+            base(g, chunk_cnt),
+            pics_folder_(pics_folder),
+            finder_(g, relative_coverage, max_edge_len, max_path_len),
+            component_remover_(g, removal_handler) {
+        if (!pics_folder_.empty()) {
+            make_dir(pics_folder_);
+        }
+    }
+
 private:
     DECL_LOGGER("ComplexTipClipper")
 };
@@ -5,43 +5,47 @@ namespace de {
 
 using namespace debruijn_graph;
 
-std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, EdgeId e2) const {
-    LengthMap m;
-    m.insert({e2, {}});
-
-    FillGraphDistancesLengths(e1, m);
-
-    return m[e2];
+GraphDistanceFinder::PathLengthsFinderT &GraphDistanceFinder::finder() const {
+    size_t thread = omp_get_thread_num();
+    VERIFY_MSG(thread < finders_.size(), "Thread " << thread << " is out of " << finders_.size());
+    auto &finder = finders_[thread];
+    if (!finder)
+        finder.reset(new PathLengthsFinderT(graph_));
+    return *finder;
 }
 
-void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    vector <size_t> path_lower_bounds;
+void GraphDistanceFinder::FillLengths(PathLengthsFinderT &finder, EdgeId e1, EdgeId e2,
+                                      GraphLengths &lengths) const {
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
-    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+    size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), graph_.length(e1),
+                                                           graph_.length(e2), gap_, delta_);
+    TRACE("Bounds for paths are " << path_lower_bound << " " << path_upper_bound);
+
+    finder.SetStart(graph_.EdgeEnd(e1), path_upper_bound);
+    finder.Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, lengths);
+    for (size_t j = 0; j < lengths.size(); ++j) {
+        lengths[j] += graph_.length(e1);
+        TRACE("Resulting distance set for " <<
+                                            " edge " << graph_.int_id(e2) <<
+                                            " #" << j << " length " << lengths[j]);
+    }
 
-    for (auto &entry : second_edges) {
-        EdgeId e2 = entry.first;
-        size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), graph_.length(e1),
-                                                               graph_.length(e2), gap_, delta_);
-
-        TRACE("Bounds for paths are " << path_lower_bound << " " << path_upper_bound);
-
-        DistancesLengthsCallback <Graph> callback(graph_);
-        paths_proc.Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
-        GraphLengths lengths = callback.distances();
-        for (size_t j = 0; j < lengths.size(); ++j) {
-            lengths[j] += graph_.length(e1);
-            TRACE("Resulting distance set for " <<
-                                                " edge " << graph_.int_id(e2) <<
-                                                " #" << j << " length " << lengths[j]);
-        }
+    if (e1 == e2)
+        lengths.push_back(0);
 
-        if (e1 == e2)
-            lengths.push_back(0);
+    std::sort(lengths.begin(), lengths.end());
+}
 
-        std::sort(lengths.begin(), lengths.end());
-        entry.second = lengths;
-    }
+std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, EdgeId e2) const {
+    GraphLengths lengths;
+    FillLengths(finder(), e1, e2, lengths);
+    return lengths;
+}
+
+void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
+    PathLengthsFinderT &f = finder();
+    for (auto &entry : second_edges)
+        FillLengths(f, e1, entry.first, entry.second);
 }
 
 void AbstractDistanceEstimator::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
@@ -11,7 +11,9 @@
 #include "utils/parallel/openmp_wrapper.h"
 #include "assembly_graph/core/basic_graph_stats.hpp"
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/frozen_graph.hpp"
 #include "assembly_graph/paths/path_processor.hpp"
+#include "assembly_graph/paths/path_lengths_finder.hpp"
 
 #include "paired_info/pair_info_bounds.hpp"
 #include "paired_info.hpp"
@@ -23,14 +25,19 @@ namespace de {
 
 //todo move to some more common place
 class GraphDistanceFinder {
+public:
+    typedef FrozenGraph<debruijn_graph::Graph> FrozenGraphT;
+
+private:
     typedef std::vector<debruijn_graph::EdgeId> Path;
     typedef std::vector<size_t> GraphLengths;
     typedef std::map<debruijn_graph::EdgeId, GraphLengths> LengthMap;
+    typedef PathLengthsFinder<FrozenGraphT> PathLengthsFinderT;
 
 public:
-    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta) :
+    GraphDistanceFinder(const FrozenGraphT &graph, size_t insert_size, size_t read_length, size_t delta) :
             graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
-            delta_((double) delta) { }
+            delta_((double) delta), finders_(std::max(omp_get_max_threads(), 1)) { }
 
     std::vector<size_t> GetGraphDistancesLengths(debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2) const;
 
@@ -38,16 +45,24 @@ public:
     void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
 
 private:
+    // Path searches of the thread, bounded Dijkstra from the last source edge is kept in it
+    PathLengthsFinderT &finder() const;
+
+    void FillLengths(PathLengthsFinderT &finder, debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2,
+                     GraphLengths &lengths) const;
+
     DECL_LOGGER("GraphDistanceFinder");
-    const debruijn_graph::Graph &graph_;
+    const FrozenGraphT &graph_;
     const size_t insert_size_;
     const int gap_;
     const double delta_;
+    // One per thread, created by the thread on first use
+    mutable std::vector<std::unique_ptr<PathLengthsFinderT>> finders_;
 };
 
 class AbstractDistanceEstimator {
 protected:
-    typedef UnclusteredPairedInfoIndexT<debruijn_graph::Graph> InPairedIndex;
+    typedef FrozenPairedInfoIndexT<debruijn_graph::Graph> InPairedIndex;
     typedef PairedInfoIndexT<debruijn_graph::Graph> OutPairedIndex;
     typedef typename InPairedIndex::HistProxy InHistogram;
     typedef typename OutPairedIndex::Histogram OutHistogram;
@@ -0,0 +1,484 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "histogram.hpp"
+#include "index_point.hpp"
+#include "utils/verify.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/parallel/parallel_wrapper.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Read-only paired index, built once from a filled buffer or index.
+ * @detail Data is kept in compressed sparse row form: sorted array of first edges,
+ *         for every first edge a sorted run of second edges, and for every edge pair
+ *         a range in the single array of packed points. The histogram of a pair and
+ *         the one of its conjugate share the same range, so every point is stored once.
+ *         Lookups are binary searches. The interface for reading mirrors PairedIndex.
+ * @param G graph type
+ * @param Traits Policy-like structure with associated types of inner and resulting points
+ */
+template<typename G, typename Traits>
+class FrozenPairedIndex {
+    struct HistRange {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    static const uint64_t NoOffset = std::numeric_limits<uint64_t>::max();
+
+public:
+    typedef G Graph;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+    typedef typename Traits::Expanded Point;
+    typedef typename Traits::Gapped InnerPoint;
+    typedef omnigraph::de::Histogram<Point> Histogram;
+
+    /**
+     * @brief Proxy set of points between two edges, expanded from the packed ones on-the-fly.
+     */
+    class HistProxy {
+    public:
+        class Iterator: public boost::iterator_facade<Iterator, Point, boost::random_access_traversal_tag, Point> {
+        public:
+            Iterator(const InnerPoint *ptr, DEDistance offset)
+                    : ptr_(ptr), offset_(offset)
+            {}
+
+        private:
+            friend class boost::iterator_core_access;
+
+            Point dereference() const {
+                return Traits::Expand(*ptr_, offset_);
+            }
+
+            void increment() { ++ptr_; }
+            void decrement() { --ptr_; }
+            void advance(ptrdiff_t n) { ptr_ += n; }
+
+            ptrdiff_t distance_to(const Iterator &other) const {
+                return other.ptr_ - ptr_;
+            }
+
+            bool equal(const Iterator &other) const {
+                return ptr_ == other.ptr_;
+            }
+
+            const InnerPoint *ptr_;
+            DEDistance offset_;
+        };
+
+        HistProxy(const InnerPoint *begin = nullptr, const InnerPoint *end = nullptr, DEDistance offset = 0)
+                : begin_(begin), end_(end), offset_(offset)
+        {}
+
+        Iterator begin() const {
+            return Iterator(begin_, offset_);
+        }
+
+        Iterator end() const {
+            return Iterator(end_, offset_);
+        }
+
+        /**
+         * @brief Finds the point with the minimal distance.
+         */
+        Point min() const {
+            VERIFY(!empty());
+            return *begin();
+        }
+
+        /**
+         * @brief Finds the point with the maximal distance.
+         */
+        Point max() const {
+            VERIFY(!empty());
+            return *--end();
+        }
+
+        /**
+         * @brief Returns the copy of all points in a simple flat histogram.
+         */
+        Histogram Unwrap() const {
+            return Histogram(begin(), end());
+        }
+
+        size_t size() const {
+            return end_ - begin_;
+        }
+
+        bool empty() const {
+            return begin_ == end_;
+        }
+
+    private:
+        const InnerPoint *begin_, *end_;
+        DEDistance offset_;
+    };
+
+    typedef typename HistProxy::Iterator HistIterator;
+
+    using EdgeHist = std::pair<EdgeId, HistProxy>;
+
+    /**
+     * @brief Proxy map representing neighbourhood of an edge, see PairedIndex::EdgeProxy.
+     */
+    class EdgeProxy {
+    public:
+        class Iterator: public boost::iterator_facade<Iterator, EdgeHist, boost::forward_traversal_tag, EdgeHist> {
+            void Skip() { //For a half iterator, skip conjugate pairs
+                while (half_ && pos_ != stop_ && index_->GreaterPair(edge_, index_->neighbours_[pos_]))
+                    ++pos_;
+            }
+
+        public:
+            Iterator(const FrozenPairedIndex &index, size_t pos, size_t stop, EdgeId edge, bool half)
+                    : index_(&index), pos_(pos), stop_(stop), edge_(edge), half_(half)
+            {
+                Skip();
+            }
+
+        private:
+            friend class boost::iterator_core_access;
+
+            void increment() {
+                ++pos_;
+                Skip();
+            }
+
+            bool equal(const Iterator &other) const {
+                return pos_ == other.pos_;
+            }
+
+            EdgeHist dereference() const {
+                return std::make_pair(index_->neighbours_[pos_], index_->Hist(pos_, edge_));
+            }
+
+            const FrozenPairedIndex *index_;
+            size_t pos_, stop_;
+            EdgeId edge_;
+            bool half_;
+        };
+
+        EdgeProxy(const FrozenPairedIndex &index, size_t begin, size_t end, EdgeId edge, bool half = false)
+                : index_(index), begin_(begin), end_(end), edge_(edge), half_(half)
+        {}
+
+        Iterator begin() const {
+            return Iterator(index_, begin_, end_, edge_, half_);
+        }
+
+        Iterator end() const {
+            return Iterator(index_, end_, end_, edge_, half_);
+        }
+
+        HistProxy operator[](EdgeId e2) const {
+            if (half_ && index_.GreaterPair(edge_, e2))
+                return HistProxy();
+            return index_.Get(edge_, e2);
+        }
+
+        bool empty() const {
+            return begin_ == end_;
+        }
+
+    private:
+        const FrozenPairedIndex &index_;
+        size_t begin_, end_;
+        EdgeId edge_;
+        bool half_;
+    };
+
+    typedef typename EdgeProxy::Iterator EdgeIterator;
+
+    FrozenPairedIndex(const Graph &graph)
+            : graph_(graph), size_(0) {
+        clear();
+    }
+
+    /**
+     * @brief Replaces the contents with the data of a filled buffer or index
+     *        (anything providing lock_table() over edge -> edge -> histogram pointer maps).
+     */
+    template<class Buffer>
+    void Assign(Buffer &from) {
+        typedef typename Buffer::InnerMap InnerMap;
+        typedef typename InnerMap::mapped_type HistPtr;
+
+        std::vector<std::pair<EdgeId, const InnerMap*>> maps;
+        {
+            auto locked_table = from.lock_table();
+            maps.reserve(locked_table.size());
+            for (const auto &kvpair : locked_table)
+                if (!kvpair.second.empty())
+                    maps.emplace_back(kvpair.first, &kvpair.second);
+        }
+        std::sort(maps.begin(), maps.end(),
+                  [](const std::pair<EdgeId, const InnerMap*> &a, const std::pair<EdgeId, const InnerMap*> &b) {
+                      return a.first < b.first;
+                  });
+
+        size_t n = maps.size();
+        edges_.resize(n);
+        edge_offsets_.resize(n + 1);
+        std::vector<uint64_t> point_offsets(n + 1);
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < n; ++i) {
+            edges_[i] = maps[i].first;
+            edge_offsets_[i] = maps[i].second->size();
+            // Only owned histograms are stored, views refer to the conjugate ones
+            uint64_t points = 0;
+            for (const auto &entry : *maps[i].second)
+                if (entry.second.owning())
+                    points += entry.second->size();
+            point_offsets[i] = points;
+        }
+        edge_offsets_[n] = point_offsets[n] = 0;
+        PrefixSum(edge_offsets_);
+        PrefixSum(point_offsets);
+
+        size_t m = edge_offsets_[n];
+        neighbours_.resize(m);
+        ranges_.resize(m);
+        points_.resize(point_offsets[n]);
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < n; ++i) {
+            std::vector<std::pair<EdgeId, const HistPtr*>> entries;
+            entries.reserve(maps[i].second->size());
+            for (const auto &entry : *maps[i].second)
+                entries.emplace_back(entry.first, &entry.second);
+            std::sort(entries.begin(), entries.end(),
+                      [](const std::pair<EdgeId, const HistPtr*> &a, const std::pair<EdgeId, const HistPtr*> &b) {
+                          return a.first < b.first;
+                      });
+
+            uint64_t point_pos = point_offsets[i];
+            size_t pos = edge_offsets_[i];
+            for (const auto &entry : entries) {
+                const auto &hist = **entry.second;
+                VERIFY(hist.size() <= std::numeric_limits<uint32_t>::max());
+                neighbours_[pos] = entry.first;
+                ranges_[pos].size = uint32_t(hist.size());
+                if (entry.second->owning()) {
+                    ranges_[pos].offset = point_pos;
+                    point_pos = std::copy(hist.begin(), hist.end(), points_.begin() + point_pos) - points_.begin();
+                } else
+                    ranges_[pos].offset = NoOffset;
+                pos += 1;
+            }
+        }
+
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t pos = edge_offsets_[i]; pos < edge_offsets_[i + 1]; ++pos) {
+                if (ranges_[pos].offset != NoOffset)
+                    continue;
+                EdgePair conj = ConjugatePair(edges_[i], neighbours_[pos]);
+                size_t conj_pos = Find(conj.first, conj.second);
+                VERIFY_MSG(conj_pos != NoPos && ranges_[conj_pos].offset != NoOffset &&
+                           ranges_[conj_pos].size == ranges_[pos].size, "Index insertion inconsistency");
+                ranges_[pos].offset = ranges_[conj_pos].offset;
+            }
+        }
+
+        size_ = from.size();
+    }
+
+    /**
+     * @brief Replaces the contents with prepared histograms. Only the lesser pair of every
+     *        two conjugate edge pairs should be given, histogram of pairs[i] consists of points
+     *        from offsets[i] to offsets[i + 1], sorted by distance.
+     */
+    void Assign(const std::vector<EdgePair> &pairs, const std::vector<uint64_t> &offsets,
+                std::vector<InnerPoint> &&points) {
+        VERIFY(offsets.size() == pairs.size() + 1 && offsets.back() == points.size());
+        std::vector<std::pair<EdgePair, size_t>> entries;
+        entries.reserve(2 * pairs.size());
+        size_ = 0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            VERIFY(offsets[i + 1] - offsets[i] <= std::numeric_limits<uint32_t>::max());
+            EdgePair conj = ConjugatePair(pairs[i]);
+            VERIFY(pairs[i] <= conj);
+            entries.emplace_back(pairs[i], i);
+            size_ += offsets[i + 1] - offsets[i];
+            if (conj != pairs[i]) {
+                entries.emplace_back(conj, i);
+                size_ += offsets[i + 1] - offsets[i];
+            }
+        }
+        parallel::sort(entries.begin(), entries.end());
+
+        size_t m = entries.size();
+        edges_.clear();
+        edge_offsets_.clear();
+        neighbours_.resize(m);
+        ranges_.resize(m);
+        for (size_t pos = 0; pos < m; ++pos) {
+            const EdgePair &ep = entries[pos].first;
+            if (pos == 0 || ep.first != entries[pos - 1].first.first) {
+                edges_.push_back(ep.first);
+                edge_offsets_.push_back(pos);
+            }
+            size_t i = entries[pos].second;
+            neighbours_[pos] = ep.second;
+            ranges_[pos].offset = offsets[i];
+            ranges_[pos].size = uint32_t(offsets[i + 1] - offsets[i]);
+        }
+        edge_offsets_.push_back(m);
+        points_ = std::move(points);
+    }
+
+    /**
+     * @brief Clears the whole index and releases the memory.
+     */
+    void clear() {
+        std::vector<EdgeId>().swap(edges_);
+        std::vector<size_t>(1, 0).swap(edge_offsets_);
+        std::vector<EdgeId>().swap(neighbours_);
+        std::vector<HistRange>().swap(ranges_);
+        std::vector<InnerPoint>().swap(points_);
+        size_ = 0;
+    }
+
+    //---------------- Data accessing methods ----------------
+
+    /**
+     * @brief Returns a whole proxy map to the neighbourhood of some edge.
+     */
+    EdgeProxy Get(EdgeId e) const {
+        size_t i = FindEdge(e);
+        if (i == NoPos)
+            return EdgeProxy(*this, 0, 0, e);
+        return EdgeProxy(*this, edge_offsets_[i], edge_offsets_[i + 1], e);
+    }
+
+    /**
+     * @brief Returns a half proxy map to the neighbourhood of some edge.
+     */
+    EdgeProxy GetHalf(EdgeId e) const {
+        size_t i = FindEdge(e);
+        if (i == NoPos)
+            return EdgeProxy(*this, 0, 0, e, true);
+        return EdgeProxy(*this, edge_offsets_[i], edge_offsets_[i + 1], e, true);
+    }
+
+    EdgeProxy operator[](EdgeId e) const {
+        return Get(e);
+    }
+
+    /**
+     * @brief Returns a histogram proxy for all points between two edges.
+     */
+    HistProxy Get(EdgeId e1, EdgeId e2) const {
+        size_t pos = Find(e1, e2);
+        if (pos == NoPos)
+            return HistProxy();
+        return Hist(pos, e1);
+    }
+
+    HistProxy operator[](EdgePair p) const {
+        return Get(p.first, p.second);
+    }
+
+    /**
+     * @brief Checks if an edge (or its conjugated twin) is consisted in the index.
+     */
+    bool contains(EdgeId edge) const {
+        return FindEdge(edge) != NoPos || FindEdge(graph_.conjugate(edge)) != NoPos;
+    }
+
+    /**
+     * @brief Checks if there is a histogram for two edges.
+     */
+    bool contains(EdgeId e1, EdgeId e2) const {
+        return Find(e1, e2) != NoPos;
+    }
+
+    //---------------- Miscellaneous ----------------
+
+    const Graph &graph() const { return graph_; }
+
+    /**
+     * @brief Returns the physical index size (total count of all histograms).
+     */
+    size_t size() const { return size_; }
+
+    EdgePair ConjugatePair(EdgeId e1, EdgeId e2) const {
+        return std::make_pair(graph_.conjugate(e2), graph_.conjugate(e1));
+    }
+
+    EdgePair ConjugatePair(EdgePair ep) const {
+        return ConjugatePair(ep.first, ep.second);
+    }
+
+private:
+    static const size_t NoPos = std::numeric_limits<size_t>::max();
+
+    template<class T>
+    static void PrefixSum(std::vector<T> &offsets) {
+        T sum = 0;
+        for (T &x : offsets) {
+            T cnt = x;
+            x = sum;
+            sum += cnt;
+        }
+    }
+
+    size_t FindEdge(EdgeId e) const {
+        auto it = std::lower_bound(edges_.begin(), edges_.end(), e);
+        if (it == edges_.end() || *it != e)
+            return NoPos;
+        return it - edges_.begin();
+    }
+
+    size_t Find(EdgeId e1, EdgeId e2) const {
+        size_t i = FindEdge(e1);
+        if (i == NoPos)
+            return NoPos;
+        auto b = neighbours_.begin() + edge_offsets_[i], e = neighbours_.begin() + edge_offsets_[i + 1];
+        auto it = std::lower_bound(b, e, e2);
+        if (it == e || *it != e2)
+            return NoPos;
+        return it - neighbours_.begin();
+    }
+
+    HistProxy Hist(size_t pos, EdgeId e1) const {
+        const InnerPoint *begin = points_.data() + ranges_[pos].offset;
+        return HistProxy(begin, begin + ranges_[pos].size, DEDistance(graph_.length(e1)));
+    }
+
+    bool GreaterPair(EdgeId e1, EdgeId e2) const {
+        auto ep = std::make_pair(e1, e2);
+        return ep > ConjugatePair(ep);
+    }
+
+    const Graph &graph_;
+    size_t size_;
+
+    std::vector<EdgeId> edges_;
+    std::vector<size_t> edge_offsets_;
+    std::vector<EdgeId> neighbours_;
+    std::vector<HistRange> ranges_;
+    std::vector<InnerPoint> points_;
+};
+
+}
+
+}
@@ -12,6 +12,7 @@
 #include <btree/safe_btree_map.h>
 
 #include "paired_info_buffer.hpp"
+#include "frozen_paired_index.hpp"
 
 #include <type_traits>
 
@@ -617,6 +618,12 @@ using PairedInfoIndicesT = PairedIndices<PairedInfoIndexT<Graph>>;
 template<class Graph>
 using UnclusteredPairedInfoIndicesT = PairedIndices<UnclusteredPairedInfoIndexT<Graph>>;
 
+template<typename Graph>
+using FrozenPairedInfoIndexT = FrozenPairedIndex<Graph, RawPointTraits>;
+
+template<class Graph>
+using FrozenPairedInfoIndicesT = PairedIndices<FrozenPairedInfoIndexT<Graph>>;
+
 template<typename K, typename V>
 using unordered_map = NoLockingAdapter<std::unordered_map<K, V>>; //Two-parameters wrapper
 template<class Graph>
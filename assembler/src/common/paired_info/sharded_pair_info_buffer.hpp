@@ -0,0 +1,307 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "frozen_paired_index.hpp"
+#include "index_point.hpp"
+#include "utils/verify.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Accumulator of paired info filled from many threads without shared containers.
+ * @detail Every thread appends points to its own buffers, one per shard (shards are selected
+ *         by the first edge). Only the lesser of two conjugate edge pairs is recorded, edges are kept
+ *         by their 32-bit int ids.
+ *         Flush() sorts the buffers of a thread, sums up the weights of equal points and
+ *         hands them over to the shards as sorted runs; runs of similar size are merged, so a shard
+ *         keeps a logarithmic number of runs. Threads flush independently, only the shard being
+ *         updated is locked.
+ *         MoveTo() merges the shards in parallel and packs the result into a FrozenPairedIndex.
+ * @param G graph type
+ * @param Traits Policy-like structure with associated types of inner and resulting points
+ */
+template<typename G, typename Traits>
+class ShardedPairedBuffer {
+  public:
+    typedef G Graph;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+    typedef typename Traits::Expanded Point;
+    typedef typename Traits::Gapped InnerPoint;
+
+  private:
+    typedef uint32_t EdgeIdx;
+
+    struct Record {
+        EdgeIdx e1, e2;
+        InnerPoint p;
+
+        bool SamePair(const Record &other) const {
+            return e1 == other.e1 && e2 == other.e2;
+        }
+
+        bool operator<(const Record &other) const {
+            if (e1 != other.e1)
+                return e1 < other.e1;
+            if (e2 != other.e2)
+                return e2 < other.e2;
+            return p < other.p;
+        }
+    };
+    typedef std::vector<Record> Records;
+
+    struct Shard {
+        std::mutex lock;
+        std::vector<Records> runs;
+    };
+
+    struct ThreadBuffer {
+        std::vector<Records> shards;
+        size_t size;
+        // Keeps the sizes updated by different threads in different cache lines
+        char padding[64];
+
+        ThreadBuffer() : size(0) {}
+    };
+
+    static const size_t ShardNum = 128;
+    static const size_t MergeRatio = 2;
+
+    const Graph &graph_;
+    std::vector<ThreadBuffer> local_;
+    std::unique_ptr<Shard[]> shards_;
+
+    ShardedPairedBuffer(const ShardedPairedBuffer &) = delete;
+    void operator=(const ShardedPairedBuffer &) = delete;
+
+    // Sorts records and merges equal points
+    static void Compact(Records &records) {
+        std::sort(records.begin(), records.end());
+        size_t size = 0;
+        for (const Record &r : records) {
+            if (size && records[size - 1].SamePair(r) && records[size - 1].p == r.p)
+                records[size - 1].p.weight += r.p.weight;
+            else
+                records[size++] = r;
+        }
+        records.resize(size);
+    }
+
+    // Merges two sorted runs, equal points are summed up
+    static Records MergeTwo(Records &a, Records &b) {
+        Records res;
+        res.reserve(a.size() + b.size());
+        auto i = a.begin(), j = b.begin();
+        while (i != a.end() || j != b.end()) {
+            const Record &r = (j == b.end() || (i != a.end() && !(*j < *i))) ? *i++ : *j++;
+            if (!res.empty() && res.back().SamePair(r) && res.back().p == r.p)
+                res.back().p.weight += r.p.weight;
+            else
+                res.push_back(r);
+        }
+        Records().swap(a);
+        Records().swap(b);
+        return res;
+    }
+
+    // Merges the last runs while they are of similar size, so the sizes of the runs
+    // decrease geometrically and every record is merged O(log) times
+    static void MergeSimilarRuns(std::vector<Records> &runs) {
+        while (runs.size() > 1 &&
+               runs[runs.size() - 2].size() <= MergeRatio * runs.back().size()) {
+            Records merged = MergeTwo(runs[runs.size() - 2], runs.back());
+            runs.pop_back();
+            runs.back() = std::move(merged);
+        }
+    }
+
+    // Merges all runs of the shard into the single one, the smallest ones first
+    static Records MergeRuns(std::vector<Records> &runs) {
+        VERIFY(!runs.empty());
+        while (runs.size() > 1) {
+            Records merged = MergeTwo(runs[runs.size() - 2], runs.back());
+            runs.pop_back();
+            runs.back() = std::move(merged);
+        }
+        Records res = std::move(runs.front());
+        runs.clear();
+        return res;
+    }
+
+    EdgeIdx IdxOf(EdgeId e) const {
+        size_t id = graph_.int_id(e);
+        VERIFY_MSG(id <= std::numeric_limits<EdgeIdx>::max(), "Edge id " << id << " does not fit 32 bits");
+        return EdgeIdx(id);
+    }
+
+    // Edges of the graph by their int ids
+    std::vector<EdgeId> EdgesByIdx() const {
+        std::vector<EdgeId> edges;
+        for (auto it = graph_.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+            size_t id = graph_.int_id(*it);
+            if (id >= edges.size())
+                edges.resize(id + 1);
+            edges[id] = *it;
+        }
+        return edges;
+    }
+
+  public:
+    ShardedPairedBuffer(const Graph &g, size_t thread_num = 1)
+            : graph_(g), shards_(new Shard[ShardNum]) {
+        Init(thread_num);
+    }
+
+    /**
+     * @brief Prepares the buffers for the given number of threads.
+     *        Should not be called concurrently with Add or Flush.
+     */
+    void Init(size_t thread_num) {
+        local_.resize(std::max(thread_num, size_t(1)));
+        for (auto &buffer : local_)
+            buffer.shards.resize(ShardNum);
+    }
+
+    /**
+     * @brief Adds a point between two edges (and implicitly, the conjugate one) from the given thread.
+     */
+    void Add(size_t thread, EdgeId e1, EdgeId e2, Point p) {
+        VERIFY(thread < local_.size());
+        InnerPoint sp = Traits::Shrink(p, DEDistance(graph_.length(e1)));
+        EdgePair ep(e1, e2), conj(graph_.conjugate(e2), graph_.conjugate(e1));
+        if (conj < ep)
+            std::swap(ep, conj);
+        else if (conj == ep) // Weight of self-conjugate pairs is doubled, as in PairedBuffer
+            sp.weight += sp.weight;
+        EdgeIdx e1_idx = IdxOf(ep.first);
+        ThreadBuffer &buffer = local_[thread];
+        buffer.shards[e1_idx % ShardNum].push_back({ e1_idx, IdxOf(ep.second), sp });
+        buffer.size += 1;
+    }
+
+    /**
+     * @brief Number of points added by the thread since its last flush.
+     */
+    size_t size(size_t thread) const {
+        VERIFY(thread < local_.size());
+        return local_[thread].size;
+    }
+
+    /**
+     * @brief Moves everything accumulated by the thread to the shards.
+     *        Different threads may flush concurrently.
+     */
+    void Flush(size_t thread) {
+        VERIFY(thread < local_.size());
+        ThreadBuffer &buffer = local_[thread];
+        for (size_t i = 0; i < ShardNum; ++i) {
+            Records &records = buffer.shards[i];
+            if (records.empty())
+                continue;
+            Compact(records);
+            // The run is moved to the shard, do not keep much of the unused capacity there
+            if (records.capacity() > 2 * records.size())
+                records.shrink_to_fit();
+
+            Shard &shard = shards_[i];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.runs.push_back(std::move(records));
+            records = Records();
+            MergeSimilarRuns(shard.runs);
+        }
+        buffer.size = 0;
+    }
+
+    /**
+     * @brief Replaces the contents of the index with the accumulated info and clears the buffer.
+     */
+    void MoveTo(FrozenPairedIndex<G, Traits> &index) {
+        for (size_t thread = 0; thread < local_.size(); ++thread)
+            Flush(thread);
+
+        std::vector<Records> merged(ShardNum);
+        std::vector<uint64_t> pair_offsets(ShardNum + 1), point_offsets(ShardNum + 1);
+        # pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < ShardNum; ++i) {
+            if (!shards_[i].runs.empty())
+                merged[i] = MergeRuns(shards_[i].runs);
+            const Records &records = merged[i];
+            size_t pairs = 0;
+            for (size_t j = 0; j < records.size(); ++j)
+                if (j == 0 || !records[j - 1].SamePair(records[j]))
+                    pairs += 1;
+            pair_offsets[i] = pairs;
+            point_offsets[i] = records.size();
+        }
+        pair_offsets[ShardNum] = point_offsets[ShardNum] = 0;
+        uint64_t pair_sum = 0, point_sum = 0;
+        for (size_t i = 0; i <= ShardNum; ++i) {
+            uint64_t pair_cnt = pair_offsets[i], point_cnt = point_offsets[i];
+            pair_offsets[i] = pair_sum;
+            point_offsets[i] = point_sum;
+            pair_sum += pair_cnt;
+            point_sum += point_cnt;
+        }
+
+        const std::vector<EdgeId> edges = EdgesByIdx();
+        std::vector<EdgePair> pairs(pair_offsets[ShardNum]);
+        std::vector<uint64_t> offsets(pairs.size() + 1);
+        std::vector<InnerPoint> points(point_offsets[ShardNum]);
+        # pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < ShardNum; ++i) {
+            size_t pair = pair_offsets[i], point = point_offsets[i];
+            const Records &records = merged[i];
+            for (size_t j = 0; j < records.size(); ++j, ++point) {
+                if (j == 0 || !records[j - 1].SamePair(records[j])) {
+                    pairs[pair] = { edges[records[j].e1], edges[records[j].e2] };
+                    offsets[pair] = point;
+                    pair += 1;
+                }
+                points[point] = records[j].p;
+            }
+            Records().swap(merged[i]);
+        }
+        offsets.back() = points.size();
+
+        index.Assign(pairs, offsets, std::move(points));
+        clear();
+    }
+
+    /**
+     * @brief Clears the whole buffer and releases the memory.
+     */
+    void clear() {
+        for (auto &buffer : local_) {
+            for (auto &records : buffer.shards)
+                Records().swap(records);
+            buffer.size = 0;
+        }
+        for (size_t i = 0; i < ShardNum; ++i)
+            std::vector<Records>().swap(shards_[i].runs);
+    }
+
+    const Graph &graph() const { return graph_; }
+};
+
+template<class Graph>
+using ShardedPairedInfoBuffer = ShardedPairedBuffer<Graph, RawPointTraits>;
+
+}
+
+}
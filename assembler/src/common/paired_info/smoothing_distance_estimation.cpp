@@ -108,8 +108,10 @@ void SmoothingDistanceEstimator::ProcessEdge(EdgeId e1, const InPairedIndex &pi,
             ++gap_distances;
         } else if (forward.size() > 0 && (!only_scaffolding_)) {
             //TODO: remove THIS
+            UnclusteredPairedInfoIndexT<Graph> temp_buffer(this->graph());
+            temp_buffer.AddMany(e1, e2, hist);
             InPairedIndex temp_index(this->graph());
-            temp_index.AddMany(e1, e2, hist);
+            temp_index.Assign(temp_buffer);
             auto hist = temp_index.Get(e1, e2);
             estimated = this->base::EstimateEdgePairDistances(ep, hist, forward);
         }
@@ -680,6 +680,8 @@ void load_launch_info(debruijn_config &cfg, boost::property_tree::ptree const &p
     load(cfg.log_filename, pt, "log_filename");
 
     load(cfg.developer_mode, pt, "developer_mode");
+    cfg.text_graph_saves = pt.get("text_graph_saves", false);
+    cfg.cache_mapping_paths = pt.get("cache_mapping_paths", false);
     if (cfg.developer_mode) {
         load(cfg.output_pictures, pt, "output_pictures");
         load(cfg.output_nonfinal_contigs, pt, "output_nonfinal_contigs");
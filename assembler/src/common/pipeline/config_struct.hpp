@@ -198,6 +198,8 @@ struct debruijn_config {
     bool uneven_depth;
 
     bool developer_mode;
+    bool text_graph_saves;
+    bool cache_mapping_paths;
 
     bool preserve_raw_paired_index;
 
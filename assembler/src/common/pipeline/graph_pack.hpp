@@ -38,7 +38,7 @@ struct graph_pack: private boost::noncopyable {
     typedef EdgeIndex<graph_t> index_t;
     using PairedInfoIndicesT = omnigraph::de::PairedInfoIndicesT<Graph>;
     //typedef omnigraph::de::PairedInfoIndicesT<Graph> PairedInfoIndicesT;
-    typedef omnigraph::de::UnclusteredPairedInfoIndicesT<Graph> UnclusteredPairedInfoIndicesT;
+    typedef omnigraph::de::FrozenPairedInfoIndicesT<Graph> UnclusteredPairedInfoIndicesT;
     typedef LongReadContainer<Graph> LongReadContainerT;
 
     size_t k_value;
@@ -168,6 +168,6 @@ typedef conj_graph_pack::PairedInfoIndicesT PairedIndicesT;
 typedef conj_graph_pack::UnclusteredPairedInfoIndicesT UnclusteredPairedIndicesT;
 typedef conj_graph_pack::LongReadContainerT LongReadContainerT;
 typedef omnigraph::de::PairedInfoIndexT<ConjugateDeBruijnGraph> PairedIndexT;
-typedef omnigraph::de::UnclusteredPairedInfoIndexT<ConjugateDeBruijnGraph> UnclusteredPairedIndexT;
+typedef omnigraph::de::FrozenPairedInfoIndexT<ConjugateDeBruijnGraph> UnclusteredPairedIndexT;
 
 } // namespace debruijn_graph
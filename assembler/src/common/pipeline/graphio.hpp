@@ -14,12 +14,17 @@
 #include "assembly_graph/components/graph_component.hpp"
 
 #include "paired_info/paired_info.hpp"
+#include "paired_info/sharded_pair_info_buffer.hpp"
 
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/graph_support/detail_coverage.hpp"
 #include "modules/alignment/long_read_storage.hpp"
 
 #include "assembly_graph/core/order_and_law.hpp"
+#include "assembly_graph/core/construction_helper.hpp"
+#include "io/kmers/mmapped_reader.hpp"
+#include "io/kmers/buffered_writer.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <cmath>
 #include <set>
@@ -75,26 +80,57 @@ bool LoadKmerMapper(const string& file_name,
     return true;
 }
 
+// The perfect hash is saved separately (.kmmph) in the mmap-able layout, so
+// later stages and runs attach to it without rebuilding or reading it.
+// K-mer coverages go to .kmcnt.
 template<class EdgeIndex>
 void SaveEdgeIndex(const std::string& file_name,
                    const EdgeIndex& index) {
     std::ofstream file;
-    file.open((file_name + ".kmidx").c_str(),
+    file.open((file_name + ".kmcnt").c_str(),
               std::ios_base::binary | std::ios_base::out);
     DEBUG("Saving kmer index, " << file_name <<" created");
     VERIFY(file.is_open());
 
     uint32_t k_ = index.k();
     file.write((char *) &k_, sizeof(uint32_t));
-    index.BinWrite(file);
-
+    index.BinWriteCounts(file);
     file.close();
+
+    index.SaveMapped(file_name + ".kmmph");
     DEBUG("index saved ")
 }
 
+template<class EdgeIndex>
+bool LoadMappedEdgeIndex(const std::string& file_name,
+                         EdgeIndex& index) {
+    if (!fs::FileExists(file_name + ".kmmph"))
+        return false;
+
+    std::ifstream file;
+    file.open((file_name + ".kmcnt").c_str(),
+              std::ios_base::binary | std::ios_base::in);
+    if (!file.is_open())
+        return false;
+    INFO("Mapping kmer index, " << file_name << " started");
+
+    uint32_t k_;
+    file.read((char *) &k_, sizeof(uint32_t));
+    VERIFY_MSG(k_ == index.k(), "Cannot read edge index, different Ks:");
+
+    index.LoadMapped(file_name + ".kmmph");
+    index.BinReadCounts(file);
+
+    return true;
+}
+
 template<class EdgeIndex>
 bool LoadEdgeIndex(const std::string& file_name,
                    EdgeIndex& index) {
+    if (LoadMappedEdgeIndex(file_name, index))
+        return true;
+
+    //fallback to the old single-file format
     std::ifstream file;
     file.open((file_name + ".kmidx").c_str(),
               std::ios_base::binary | std::ios_base::in);
@@ -153,6 +189,161 @@ inline void DeserializePoint(FILE* file, size_t& e1, size_t& e2, Point &p) {
     VERIFY(read_count == 5);
 }
 
+//Binary graph checkpoint (.grb): header, vertex records, edge records and
+//2-bit packed edge sequences in one file, so that it can be mmapped as a whole.
+//Every record describes a pair of conjugate elements.
+namespace checkpoint {
+
+static const char kMagic[8] = {'S', 'P', 'A', 'D', 'E', 'S', 'G', 'B'};
+static const uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t k;
+    uint64_t max_id;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint64_t nucls_size; // in seq_element_type units
+};
+
+struct VertexRecord {
+    uint64_t id;
+    uint64_t conjugate;
+};
+
+struct EdgeRecord {
+    uint64_t id;
+    uint64_t conjugate;
+    uint64_t start;
+    uint64_t end;
+    uint64_t nucls_offset;
+    uint64_t nucls_size;
+    uint32_t coverage;
+    uint32_t conjugate_coverage;
+};
+
+inline std::string FileName(const std::string &file_name) {
+    return file_name + ".grb";
+}
+
+inline size_t FileSize(const Header &header) {
+    return sizeof(Header) +
+            header.vertex_count * sizeof(VertexRecord) +
+            header.edge_count * sizeof(EdgeRecord) +
+            header.nucls_size * sizeof(seq_element_type);
+}
+
+}
+
+//Checks whether graph saves (binary checkpoint or text export) are present
+inline bool GraphSavesExist(const std::string &file_name) {
+    return fs::FileExists(checkpoint::FileName(file_name)) ||
+            (fs::FileExists(file_name + ".grp") && fs::FileExists(file_name + ".sqn"));
+}
+
+//Binary sidecars of the text saves: paired info (.prdb), flanking coverage (.flcvrb)
+//and edge positions (.posb), raw coverage is a part of the graph checkpoint. Every file
+//is a header followed by packed records, written through a large buffer and mmapped
+//on load. Loaders prefer them to the text files when both are present.
+namespace sidecar {
+
+static const char kMagic[8] = {'S', 'P', 'A', 'D', 'E', 'S', 'S', 'B'};
+static const uint32_t kVersion = 1;
+
+enum Kind : uint32_t {
+    kPaired = 1,
+    kFlankingCoverage = 3,
+    kPositions = 4
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t count;
+};
+
+struct CoverageRecord {
+    uint64_t id;
+    uint32_t coverage;
+    uint32_t reserved;
+};
+
+//Points are stored as they are returned by GetHalf, var is zero for raw points
+struct PairedRecord {
+    uint64_t e1;
+    uint64_t e2;
+    float d;
+    float weight;
+    float var;
+    uint32_t reserved;
+};
+
+//Every edge record is followed by its positions, every position by contig name
+struct PositionsRecord {
+    uint64_t id;
+    uint64_t count;
+};
+
+struct PositionRecord {
+    uint64_t initial_start;
+    uint64_t initial_end;
+    uint64_t mapped_start;
+    uint64_t mapped_end;
+    uint64_t contig_size;
+};
+
+inline PairedRecord MakeRecord(size_t e1, size_t e2, const RawPoint &p) {
+    return { e1, e2, float(p.d), float(p.weight), 0.f, 0 };
+}
+
+inline PairedRecord MakeRecord(size_t e1, size_t e2, const Point &p) {
+    return { e1, e2, float(p.d), float(p.weight), float(p.var), 0 };
+}
+
+inline void ReadPoint(const PairedRecord &r, RawPoint &p) {
+    p = RawPoint(DEDistance(r.d), DEWeight(r.weight));
+}
+
+inline void ReadPoint(const PairedRecord &r, Point &p) {
+    p = Point(DEDistance(r.d), DEWeight(r.weight), DEVariance(r.var));
+}
+
+inline void WriteHeader(BufferedWriter &out, Kind kind, uint64_t count) {
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.kind = kind;
+    header.count = count;
+    out.write(&header, sizeof(header));
+}
+
+//Checks the header of mmapped sidecar and returns the pointer to the records
+inline const uint8_t *ReadHeader(const MMappedReader &reader, const std::string &file_name,
+                                 Kind kind, uint64_t &count) {
+    VERIFY_MSG(reader.size() >= sizeof(Header), file_name << " is truncated");
+    const uint8_t *data = (const uint8_t *) reader.data();
+    const Header &header = *(const Header *) data;
+    VERIFY_MSG(memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.kind == kind,
+               file_name << " is not a binary save of expected kind");
+    VERIFY_MSG(header.version == kVersion,
+               "Unsupported binary save version " << header.version << " in " << file_name);
+    count = header.count;
+    return data + sizeof(Header);
+}
+
+//Same for the files of fixed size records
+template<class Record>
+const Record *ReadRecords(const MMappedReader &reader, const std::string &file_name,
+                          Kind kind, uint64_t &count) {
+    const uint8_t *records = ReadHeader(reader, file_name, kind, count);
+    VERIFY_MSG(reader.size() == sizeof(Header) + count * sizeof(Record),
+               file_name << " is truncated");
+    return (const Record *) records;
+}
+
+}
 
 template<class Graph>
 class DataPrinter {
@@ -184,8 +375,77 @@ class DataPrinter {
         }
     }
 
+    template<class C>
+    void SaveBinaryEdgeAssociatedInfo(const C& c, const string& file_name, sidecar::Kind kind) const {
+        using namespace sidecar;
+        BufferedWriter out(file_name);
+        WriteHeader(out, kind, component_.e_size());
+        for (auto iter = component_.e_begin(); iter != component_.e_end(); ++iter) {
+            EdgeId e = *iter;
+            CoverageRecord record = { e.int_id(), c.RawCoverage(e), 0 };
+            out.write(&record, sizeof(record));
+        }
+    }
+
   public:
 
+    void SaveGraphCheckpoint(const string& file_name) const {
+        using namespace checkpoint;
+        const Graph &g = component_.g();
+        DEBUG("Graph checkpoint saving to " << FileName(file_name) << " started");
+
+        std::vector<VertexRecord> vertices;
+        for (auto iter = component_.v_begin(); iter != component_.v_end(); ++iter) {
+            VertexId v = *iter, conj = g.conjugate(v);
+            if (conj < v && component_.contains(conj))
+                continue;
+            vertices.push_back({ v.int_id(), conj.int_id() });
+        }
+
+        std::vector<EdgeId> edges;
+        std::vector<EdgeRecord> edge_records;
+        size_t nucls_size = 0;
+        for (auto iter = component_.e_begin(); iter != component_.e_end(); ++iter) {
+            EdgeId e = *iter, conj = g.conjugate(e);
+            if (conj < e && component_.contains(conj))
+                continue;
+            size_t length = g.EdgeNucls(e).size();
+            edges.push_back(e);
+            edge_records.push_back({ e.int_id(), conj.int_id(),
+                                     g.EdgeStart(e).int_id(), g.EdgeEnd(e).int_id(),
+                                     nucls_size, length,
+                                     g.coverage_index().RawCoverage(e),
+                                     g.coverage_index().RawCoverage(conj) });
+            nucls_size += Sequence::PackedSize(length);
+        }
+
+        std::vector<seq_element_type> nucls(nucls_size);
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i)
+            g.EdgeNucls(edges[i]).CopyPackedData(nucls.data() + edge_records[i].nucls_offset);
+
+        Header header;
+        memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.k = (uint32_t) g.k();
+        header.max_id = g.GetGraphIdDistributor().GetMax();
+        header.vertex_count = vertices.size();
+        header.edge_count = edge_records.size();
+        header.nucls_size = nucls_size;
+
+        FILE* file = fopen(FileName(file_name).c_str(), "wb");
+        VERIFY_MSG(file != NULL,
+                   "Couldn't open file " << FileName(file_name) << " on write");
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(vertices.data(), sizeof(VertexRecord), vertices.size(), file);
+        fwrite(edge_records.data(), sizeof(EdgeRecord), edge_records.size(), file);
+        fwrite(nucls.data(), sizeof(seq_element_type), nucls.size(), file);
+        VERIFY_MSG(!ferror(file), "Failed to write graph checkpoint " << FileName(file_name));
+        fclose(file);
+
+        DEBUG("Graph checkpoint saving to " << FileName(file_name) << " finished");
+    }
+
     void SaveGraph(const string& file_name) const {
         FILE* gid_file = fopen((file_name + ".gid").c_str(), "w");
         size_t max_id = this->component().g().GetGraphIdDistributor().GetMax();
@@ -271,6 +531,60 @@ class DataPrinter {
         fclose(file);
     }
 
+    void SaveBinaryFlankingCoverage(const string& file_name, const FlankingCoverage<Graph>& flanking_cov) const {
+        DEBUG("Saving binary flanking coverage, " << file_name << " created");
+        SaveBinaryEdgeAssociatedInfo(flanking_cov, file_name + ".flcvrb", sidecar::kFlankingCoverage);
+    }
+
+    //Unlike the text save, points are not ordered by the second edge
+    template<class Index>
+    void SaveBinaryPaired(const string& file_name,
+                          Index const& paired_index) const {
+        using namespace sidecar;
+        DEBUG("Saving binary paired info, " << file_name << " created");
+        size_t comp_size = 0;
+        for (auto I = component_.e_begin(), E = component_.e_end(); I != E; ++I) {
+            for (auto entry : paired_index.GetHalf(*I))
+                if (component_.contains(entry.first))
+                    comp_size += entry.second.size();
+        }
+
+        BufferedWriter out(file_name + ".prdb");
+        WriteHeader(out, kPaired, comp_size);
+        for (auto I = component_.e_begin(), E = component_.e_end(); I != E; ++I) {
+            EdgeId e1 = *I;
+            for (auto entry : paired_index.GetHalf(e1)) {
+                EdgeId e2 = entry.first;
+                if (!component_.contains(e2))
+                    continue;
+                for (auto point : entry.second) {
+                    PairedRecord record = MakeRecord(e1.int_id(), e2.int_id(), point);
+                    out.write(&record, sizeof(record));
+                }
+            }
+        }
+    }
+
+    void SaveBinaryPositions(const string& file_name,
+                             EdgesPositionHandler<Graph> const& ref_pos) const {
+        using namespace sidecar;
+        DEBUG("Saving binary edges positions, " << file_name << " created");
+        BufferedWriter out(file_name + ".posb");
+        WriteHeader(out, kPositions, component_.e_size());
+        for (auto it = component_.e_begin(); it != component_.e_end(); ++it) {
+            vector<omnigraph::EdgePosition> positions = ref_pos.GetEdgePositions(*it);
+            PositionsRecord record = { it->int_id(), positions.size() };
+            out.write(&record, sizeof(record));
+            for (const auto &pos : positions) {
+                PositionRecord pos_record = { pos.mr.initial_range.start_pos, pos.mr.initial_range.end_pos,
+                                              pos.mr.mapped_range.start_pos, pos.mr.mapped_range.end_pos,
+                                              pos.contigId.size() };
+                out.write(&pos_record, sizeof(pos_record));
+                out.write(pos.contigId.data(), pos.contigId.size());
+            }
+        }
+    }
+
     void SavePositions(const string& file_name,
                        EdgesPositionHandler<Graph> const& ref_pos) const {
         ofstream file((file_name + ".pos").c_str());
@@ -405,9 +719,52 @@ class DataScanner {
         }
     }
 
+    //Returns false if there is no binary save
+    template<class C>
+    bool LoadBinaryEdgeAssociatedInfo(C& c, const string& file_name, sidecar::Kind kind) const {
+        using namespace sidecar;
+        if (!fs::FileExists(file_name))
+            return false;
+        MMappedReader reader(file_name, /* unlink */ false, -1ULL);
+        uint64_t count;
+        const CoverageRecord *records = ReadRecords<CoverageRecord>(reader, file_name, kind, count);
+#       pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < count; ++i)
+            c.SetRawCoverage(FindEdge(records[i].id), records[i].coverage);
+        return true;
+    }
+
+    //Thread safe, the map is only read
+    EdgeId FindEdge(size_t id) const {
+        auto it = this->edge_id_map().find(id);
+        VERIFY(it != this->edge_id_map().end());
+        return it->second;
+    }
+
+    //Returns null edge if the edge was not loaded
+    EdgeId FindEdgeOrNull(size_t id) const {
+        auto it = this->edge_id_map().find(id);
+        return it != this->edge_id_map().end() ? it->second : EdgeId(0);
+    }
+
+    template<typename Point>
+    void ReadPairedRecord(const sidecar::PairedRecord &record,
+                          EdgeId &e1, EdgeId &e2, Point &point) const {
+        e1 = FindEdge(record.e1);
+        e2 = FindEdgeOrNull(record.e2);
+        sidecar::ReadPoint(record, point);
+        //Need to prevent doubling of self-conjugate edge pairs, the weight is stored exactly
+        if (e2 != EdgeId(0) && e1 == g_.conjugate(e2))
+            point.weight *= 0.5;
+    }
+
   public:
     virtual void LoadGraph(const string& file_name) = 0;
 
+    //Returns false if there is no binary checkpoint with given name.
+    //Raw edge coverage is restored together with the graph.
+    virtual bool LoadGraphCheckpoint(const string& file_name) = 0;
+
     void LoadCoverage(const string& file_name) {
         INFO("Reading coverage from " << file_name);
         ifstream in(file_name + ".cvr");
@@ -415,6 +772,10 @@ class DataScanner {
     }
 
     bool LoadFlankingCoverage(const string& file_name, FlankingCoverage<Graph>& flanking_cov) {
+        if (LoadBinaryEdgeAssociatedInfo(flanking_cov, file_name + ".flcvrb", sidecar::kFlankingCoverage)) {
+            INFO("Read binary flanking coverage from " << file_name);
+            return true;
+        }
         if (!fs::FileExists(file_name + ".flcvr")) {
             INFO("Flanking coverage saves are absent");
             return false;
@@ -425,11 +786,76 @@ class DataScanner {
         return true;
     }
 
+    //Returns false if there is no binary save
+    template<typename Index>
+    bool LoadBinaryPaired(const string& file_name,
+                          Index& paired_index) {
+        using namespace sidecar;
+        if (!fs::FileExists(file_name + ".prdb"))
+            return false;
+        INFO("Reading binary paired info from " << file_name << " started");
+        MMappedReader reader(file_name + ".prdb", /* unlink */ false, -1ULL);
+        uint64_t count;
+        const PairedRecord *records = ReadRecords<PairedRecord>(reader, file_name + ".prdb", kPaired, count);
+        for (size_t i = 0; i < count; ++i) {
+            EdgeId e1, e2;
+            typename Index::Point point;
+            ReadPairedRecord(records[i], e1, e2, point);
+            if (e2 != EdgeId(0))
+                paired_index.Add(e1, e2, point);
+        }
+        DEBUG("PII SIZE " << paired_index.size());
+        return true;
+    }
+
+    //Raw paired info is collected from all threads via sharded buffer
+    bool LoadBinaryPaired(const string& file_name,
+                          FrozenPairedInfoIndexT<Graph>& paired_index) {
+        using namespace sidecar;
+        if (!fs::FileExists(file_name + ".prdb"))
+            return false;
+        INFO("Reading binary paired info from " << file_name << " started");
+        MMappedReader reader(file_name + ".prdb", /* unlink */ false, -1ULL);
+        uint64_t count;
+        const PairedRecord *records = ReadRecords<PairedRecord>(reader, file_name + ".prdb", kPaired, count);
+
+        const size_t chunk_size = 1 << 20;
+        size_t chunks = (count + chunk_size - 1) / chunk_size;
+        ShardedPairedInfoBuffer<Graph> buffer(paired_index.graph(), omp_get_max_threads());
+#       pragma omp parallel for schedule(dynamic)
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            size_t thread = omp_get_thread_num();
+            for (size_t i = chunk * chunk_size; i < std::min<size_t>(count, (chunk + 1) * chunk_size); ++i) {
+                EdgeId e1, e2;
+                RawPoint point;
+                ReadPairedRecord(records[i], e1, e2, point);
+                if (e2 != EdgeId(0))
+                    buffer.Add(thread, e1, e2, point);
+            }
+            buffer.Flush(thread);
+        }
+        buffer.MoveTo(paired_index);
+        DEBUG("PII SIZE " << paired_index.size());
+        return true;
+    }
+
+    void LoadPaired(const string& file_name,
+                    FrozenPairedInfoIndexT<Graph>& paired_index,
+                    bool force_exists = true) {
+        if (LoadBinaryPaired(file_name, paired_index))
+            return;
+        UnclusteredPairedInfoIndexT<Graph> loaded(paired_index.graph());
+        LoadPaired(file_name, loaded, force_exists);
+        paired_index.Assign(loaded);
+    }
+
     template<typename Index>
     void LoadPaired(const string& file_name,
                     Index& paired_index,
                     bool force_exists = true) {
         typedef typename Graph::EdgeId EdgeId;
+        if (LoadBinaryPaired(file_name, paired_index))
+            return;
         FILE* file = fopen((file_name + ".prd").c_str(), "r");
         INFO((file_name + ".prd"));
         if (force_exists) {
@@ -467,8 +893,46 @@ class DataScanner {
         fclose(file);
     }
 
+    //Returns false if there is no binary save
+    bool LoadBinaryPositions(const string& file_name,
+                             EdgesPositionHandler<Graph>& edge_pos) {
+        using namespace sidecar;
+        if (!fs::FileExists(file_name + ".posb"))
+            return false;
+        VERIFY(!edge_pos.IsAttached());
+        edge_pos.Attach();
+        INFO("Reading binary edges positions, " << file_name << " started");
+        MMappedReader reader(file_name + ".posb", /* unlink */ false, -1ULL);
+        uint64_t count;
+        const uint8_t *pos = ReadHeader(reader, file_name + ".posb", kPositions, count);
+        const uint8_t *end = (const uint8_t *) reader.data() + reader.size();
+        //Records are not aligned because of contig names
+        auto take = [&](void *dst, size_t size) {
+            VERIFY_MSG(size_t(end - pos) >= size, file_name << ".posb is truncated");
+            memcpy(dst, pos, size);
+            pos += size;
+        };
+        for (size_t i = 0; i < count; ++i) {
+            PositionsRecord record;
+            take(&record, sizeof(record));
+            EdgeId eid = FindEdge(record.id);
+            for (size_t j = 0; j < record.count; ++j) {
+                PositionRecord pos_record;
+                take(&pos_record, sizeof(pos_record));
+                string contig_id(pos_record.contig_size, '\0');
+                take(&contig_id[0], contig_id.size());
+                edge_pos.AddEdgePosition(eid, contig_id,
+                                         MappingRange(pos_record.initial_start, pos_record.initial_end,
+                                                      pos_record.mapped_start, pos_record.mapped_end));
+            }
+        }
+        return true;
+    }
+
     bool LoadPositions(const string& file_name,
                        EdgesPositionHandler<Graph>& edge_pos) {
+        if (LoadBinaryPositions(file_name, edge_pos))
+            return true;
         FILE* file = fopen((file_name + ".pos").c_str(), "r");
         if (file == NULL) {
             INFO("No positions were saved");
@@ -640,6 +1104,96 @@ private:
         fclose(file);
         fclose(sequence_file);
     }
+
+    bool LoadGraphCheckpoint(const string& file_name) {
+        using namespace checkpoint;
+        if (!fs::FileExists(FileName(file_name)))
+            return false;
+
+        INFO("Reading conjugate de bruijn graph checkpoint from " << FileName(file_name) << " started");
+        MMappedReader reader(FileName(file_name), /* unlink */ false, -1ULL);
+        VERIFY_MSG(reader.size() >= sizeof(Header),
+                   "Graph checkpoint " << FileName(file_name) << " is truncated");
+        const uint8_t *data = (const uint8_t *) reader.data();
+        const Header &header = *(const Header *) data;
+        VERIFY_MSG(memcmp(header.magic, kMagic, sizeof(kMagic)) == 0,
+                   FileName(file_name) << " is not a graph checkpoint");
+        VERIFY_MSG(header.version == kVersion,
+                   "Unsupported graph checkpoint version " << header.version);
+        VERIFY_MSG(header.k == this->g().k(), "Cannot read graph checkpoint, different Ks");
+        VERIFY_MSG(reader.size() == FileSize(header),
+                   "Graph checkpoint " << FileName(file_name) << " is truncated");
+
+        const VertexRecord *vertex_records = (const VertexRecord *) (data + sizeof(Header));
+        const EdgeRecord *edge_records = (const EdgeRecord *) (vertex_records + header.vertex_count);
+        const seq_element_type *nucls = (const seq_element_type *) (edge_records + header.edge_count);
+
+        restricted::IdSegmentStorage id_storage = this->g().GetGraphIdDistributor().ReserveUpTo(header.max_id);
+        typename Graph::HelperT helper = this->g().GetConstructionHelper();
+
+        std::vector<VertexId> vertices(header.vertex_count);
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            size_t ids[2] = {vertex_records[i].id, vertex_records[i].conjugate};
+            auto id_distributor = id_storage.GetSegmentIdDistributor(ids, ids + 2);
+            vertices[i] = helper.CreateVertex(typename Graph::VertexData(), id_distributor);
+        }
+        helper.AddVerticesToGraph(vertices.begin(), vertices.end());
+        for (VertexId v : vertices) {
+            this->vertex_id_map()[v.int_id()] = v;
+            this->vertex_id_map()[this->g().conjugate(v).int_id()] = this->g().conjugate(v);
+            this->g().FireAddVertex(v);
+        }
+
+        //Edges whose self-conjugacy cannot be derived from the sequence alone
+        //are left for the sequential pass below
+        std::vector<EdgeId> edges(header.edge_count, EdgeId(0));
+        bool parallel = this->g().AllHandlersThreadSafe();
+#       pragma omp parallel for schedule(guided) if(parallel)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            const EdgeRecord &record = edge_records[i];
+            typename Graph::EdgeData edge_data(Sequence(nucls + record.nucls_offset, record.nucls_size));
+            if ((record.id == record.conjugate) != this->g().master().isSelfConjugate(edge_data))
+                continue;
+            size_t ids[2] = {record.id, record.conjugate};
+            auto id_distributor = id_storage.GetSegmentIdDistributor(ids, ids + 2);
+            edges[i] = helper.AddEdge(edge_data, id_distributor);
+        }
+
+        for (size_t i = 0; i < edges.size(); ++i) {
+            const EdgeRecord &record = edge_records[i];
+            VERIFY(this->vertex_id_map().count(record.start) && this->vertex_id_map().count(record.end));
+            VertexId start = this->vertex_id_map()[record.start];
+            VertexId end = this->vertex_id_map()[record.end];
+            if (edges[i] == EdgeId(0)) {
+                size_t ids[2] = {record.id, record.conjugate};
+                auto id_distributor = id_storage.GetSegmentIdDistributor(ids, ids + 2);
+                edges[i] = this->g().AddEdge(start, end,
+                                             Sequence(nucls + record.nucls_offset, record.nucls_size),
+                                             id_distributor);
+            } else {
+                EdgeId e = edges[i];
+                helper.LinkOutgoingEdge(start, e);
+                if (this->g().conjugate(e) != e)
+                    helper.LinkIncomingEdge(end, e);
+            }
+            this->edge_id_map()[record.id] = edges[i];
+            this->edge_id_map()[record.conjugate] = this->g().conjugate(edges[i]);
+        }
+
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId e = edges[i];
+            this->g().coverage_index().SetRawCoverage(e, edge_records[i].coverage);
+            if (this->g().conjugate(e) != e)
+                this->g().coverage_index().SetRawCoverage(this->g().conjugate(e),
+                                                          edge_records[i].conjugate_coverage);
+        }
+
+        INFO("Reading conjugate de bruijn graph checkpoint from " << FileName(file_name) << " finished");
+        return true;
+    }
+
   public:
     ConjugateDataScanner(Graph& g) :
             base(g) {
@@ -654,57 +1208,80 @@ inline std::string MakeSingleReadsFileName(const std::string& file_name,
 //helper methods
 // todo think how to organize them in the most natural way
 
+//Graph is saved as a binary checkpoint, text .grp/.sqn/.cvr files are written only on request.
+//Raw coverage is a part of the checkpoint.
 template<class Graph>
-void PrintBasicGraph(const string& file_name, DataPrinter<Graph>& printer) {
-    printer.SaveGraph(file_name);
-    printer.SaveEdgeSequences(file_name);
-    printer.SaveCoverage(file_name);
+void PrintBasicGraph(const string& file_name, DataPrinter<Graph>& printer,
+                     bool text_export = false) {
+    printer.SaveGraphCheckpoint(file_name);
+    if (text_export) {
+        printer.SaveGraph(file_name);
+        printer.SaveEdgeSequences(file_name);
+        printer.SaveCoverage(file_name);
+    }
 }
 
 template<class graph_pack>
 void PrintGraphPack(const string& file_name,
                     DataPrinter<typename graph_pack::graph_t>& printer,
-                    const graph_pack& gp) {
-    PrintBasicGraph(file_name, printer);
+                    const graph_pack& gp,
+                    bool text_export = false) {
+    PrintBasicGraph(file_name, printer, text_export);
     //  printer.SavePaired(file_name + "_et", gp.etalon_paired_index);
-    if (gp.edge_pos.IsAttached())
-        printer.SavePositions(file_name, gp.edge_pos);
+    if (gp.edge_pos.IsAttached()) {
+        printer.SaveBinaryPositions(file_name, gp.edge_pos);
+        if (text_export)
+            printer.SavePositions(file_name, gp.edge_pos);
+    }
     if (gp.index.IsAttached())
         SaveEdgeIndex(file_name, gp.index.inner_index());
     if (gp.kmer_mapper.IsAttached())
         SaveKmerMapper(file_name, gp.kmer_mapper);
-    if (gp.flanking_cov.IsAttached())
-        printer.SaveFlankingCoverage(file_name, gp.flanking_cov);
+    if (gp.flanking_cov.IsAttached()) {
+        printer.SaveBinaryFlankingCoverage(file_name, gp.flanking_cov);
+        if (text_export)
+            printer.SaveFlankingCoverage(file_name, gp.flanking_cov);
+    }
 }
 
 template<class graph_pack>
-void PrintGraphPack(const string& file_name, const graph_pack& gp) {
+void PrintGraphPack(const string& file_name, const graph_pack& gp,
+                    bool text_export = false) {
     ConjugateDataPrinter<typename graph_pack::graph_t> printer(gp.g);
-    PrintGraphPack(file_name, printer, gp);
+    PrintGraphPack(file_name, printer, gp, text_export);
 }
 
+//Paired info is saved in binary .prdb, text .prd files are written only on request
 template<class Graph>
 void PrintPairedIndex(const string& file_name, DataPrinter<Graph>& printer,
-                      const PairedInfoIndexT<Graph>& paired_index) {
-    printer.SavePaired(file_name, paired_index);
+                      const PairedInfoIndexT<Graph>& paired_index,
+                      bool text_export = false) {
+    printer.SaveBinaryPaired(file_name, paired_index);
+    if (text_export)
+        printer.SavePaired(file_name, paired_index);
 }
 
 template<class Graph>
 void PrintUnclusteredIndex(const string& file_name, DataPrinter<Graph>& printer,
-                           const UnclusteredPairedInfoIndexT<Graph>& paired_index) {
-    printer.SavePaired(file_name, paired_index);
+                           const FrozenPairedInfoIndexT<Graph>& paired_index,
+                           bool text_export = false) {
+    printer.SaveBinaryPaired(file_name, paired_index);
+    if (text_export)
+        printer.SavePaired(file_name, paired_index);
 }
 
 template<class Graph>
 void PrintClusteredIndex(const string& file_name, DataPrinter<Graph>& printer,
-                         const PairedInfoIndexT<Graph>& clustered_index) {
-    PrintPairedIndex(file_name + "_cl", printer, clustered_index);
+                         const PairedInfoIndexT<Graph>& clustered_index,
+                         bool text_export = false) {
+    PrintPairedIndex(file_name + "_cl", printer, clustered_index, text_export);
 }
 
 template<class Graph>
 void PrintScaffoldingIndex(const string& file_name, DataPrinter<Graph>& printer,
-                         const PairedInfoIndexT<Graph>& clustered_index) {
-    PrintPairedIndex(file_name + "_scf", printer, clustered_index);
+                           const PairedInfoIndexT<Graph>& clustered_index,
+                           bool text_export = false) {
+    PrintPairedIndex(file_name + "_scf", printer, clustered_index, text_export);
 }
 
 template<class Graph>
@@ -715,23 +1292,26 @@ void PrintScaffoldIndex(const string& file_name, DataPrinter<Graph>& printer,
 
 template<class Graph>
 void PrintUnclusteredIndices(const string& file_name, DataPrinter<Graph>& printer,
-                             const UnclusteredPairedInfoIndicesT<Graph>& paired_indices) {
+                             const FrozenPairedInfoIndicesT<Graph>& paired_indices,
+                             bool text_export = false) {
     for (size_t i = 0; i < paired_indices.size(); ++i)
-        PrintUnclusteredIndex(file_name + "_" + std::to_string(i), printer, paired_indices[i]);
+        PrintUnclusteredIndex(file_name + "_" + std::to_string(i), printer, paired_indices[i], text_export);
 }
 
 template<class Graph>
 void PrintClusteredIndices(const string& file_name, DataPrinter<Graph>& printer,
-                           const PairedInfoIndicesT<Graph>& paired_indices) {
+                           const PairedInfoIndicesT<Graph>& paired_indices,
+                           bool text_export = false) {
     for (size_t i = 0; i < paired_indices.size(); ++i)
-        PrintClusteredIndex(file_name  + "_" + std::to_string(i), printer, paired_indices[i]);
+        PrintClusteredIndex(file_name  + "_" + std::to_string(i), printer, paired_indices[i], text_export);
 }
 
 template<class Graph>
 void PrintScaffoldingIndices(const string& file_name, DataPrinter<Graph>& printer,
-                           const PairedInfoIndicesT<Graph>& paired_indices) {
+                             const PairedInfoIndicesT<Graph>& paired_indices,
+                             bool text_export = false) {
     for (size_t i = 0; i < paired_indices.size(); ++i)
-        PrintScaffoldingIndex(file_name  + "_" + std::to_string(i), printer, paired_indices[i]);
+        PrintScaffoldingIndex(file_name  + "_" + std::to_string(i), printer, paired_indices[i], text_export);
 }
 
 template<class graph_pack>
@@ -786,12 +1366,13 @@ void PrintSingleLongReads(const string& file_name, const LongReadContainer<Graph
 }
 
 template<class graph_pack>
-void PrintAll(const string& file_name, const graph_pack& gp) {
+void PrintAll(const string& file_name, const graph_pack& gp,
+              bool text_export = false) {
     ConjugateDataPrinter<typename graph_pack::graph_t> printer(gp.g, gp.g.begin(), gp.g.end());
-    PrintGraphPack(file_name, printer, gp);
-    PrintUnclusteredIndices(file_name, printer, gp.paired_indices);
-    PrintClusteredIndices(file_name, printer, gp.clustered_indices);
-    PrintScaffoldingIndices(file_name, printer, gp.scaffolding_indices);
+    PrintGraphPack(file_name, printer, gp, text_export);
+    PrintUnclusteredIndices(file_name, printer, gp.paired_indices, text_export);
+    PrintClusteredIndices(file_name, printer, gp.clustered_indices, text_export);
+    PrintScaffoldingIndices(file_name, printer, gp.scaffolding_indices, text_export);
     PrintSingleLongReads(file_name, gp.single_long_reads);
     gp.ginfo.Save(file_name + ".ginfo");
 }
@@ -855,6 +1436,8 @@ void PrintWithClusteredIndices(const string& file_name, const graph_pack& gp,
 
 template<class Graph>
 void ScanBasicGraph(const string& file_name, DataScanner<Graph>& scanner) {
+    if (scanner.LoadGraphCheckpoint(file_name))
+        return;
     scanner.LoadGraph(file_name);
     scanner.LoadCoverage(file_name);
 }
@@ -885,7 +1468,7 @@ void ScanGraphPack(const string& file_name,
 
 template<class Graph>
 void ScanPairedIndex(const string& file_name, DataScanner<Graph>& scanner,
-                     UnclusteredPairedInfoIndexT<Graph>& paired_index,
+                     FrozenPairedInfoIndexT<Graph>& paired_index,
                      bool force_exists = true) {
     scanner.LoadPaired(file_name, paired_index, force_exists);
 }
@@ -906,7 +1489,7 @@ void ScanScaffoldingIndex(const string& file_name, DataScanner<Graph>& scanner,
 
 template<class Graph>
 void ScanPairedIndices(const std::string& file_name, DataScanner<Graph>& scanner,
-                       UnclusteredPairedInfoIndicesT<Graph>& paired_indices,
+                       FrozenPairedInfoIndicesT<Graph>& paired_indices,
                        bool force_exists = true) {
     for (size_t i = 0; i < paired_indices.size(); ++i)
         ScanPairedIndex(file_name  + "_" + std::to_string(i), scanner, paired_indices[i], force_exists);
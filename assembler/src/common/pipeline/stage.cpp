@@ -31,7 +31,7 @@ void AssemblyStage::save(const debruijn_graph::conj_graph_pack& gp,
     std::string p = fs::append_path(save_to, prefix == NULL ? id_ : prefix);
     INFO("Saving current state to " << p);
 
-    debruijn_graph::graphio::PrintAll(p, gp);
+    debruijn_graph::graphio::PrintAll(p, gp, cfg::get().text_graph_saves);
     debruijn_graph::config::write_lib_data(p);
 }
 
@@ -125,6 +125,7 @@ void StageManager::run(debruijn_graph::conj_graph_pack& g,
 
         INFO("STAGE == " << stage->name());
         stage->run(g, start_from);
+        g.g.FireFlush();
         if (saves_policy_.make_saves_)
             stage->save(g, saves_policy_.save_to_);
     }
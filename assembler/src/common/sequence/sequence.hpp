@@ -35,7 +35,7 @@ class Sequence {
 
         ManagedNuclBuffer() {}
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
+        ManagedNuclBuffer(size_t nucls, const ST *buf) {
             std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
         }
 
@@ -45,7 +45,7 @@ class Sequence {
             return new (mem) ManagedNuclBuffer();
         }
 
-        static ManagedNuclBuffer *create(size_t nucls, ST *data) {
+        static ManagedNuclBuffer *create(size_t nucls, const ST *data) {
             void *mem = ::operator new(totalSizeToAlloc<ST>(Sequence::DataSize(nucls)));
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
@@ -160,6 +160,12 @@ public:
         kmer.copy_data(data_->data());
     }
 
+    /**
+     * Sequence initialization from 2-bit packed data (see CopyPackedData)
+     */
+    Sequence(const ST *packed, size_t size)
+            : from_(0), size_(size), rtl_(false), data_(ManagedNuclBuffer::create(size_, packed)) {}
+
     Sequence(const Sequence &seq, size_t from, size_t size, bool rtl)
             : from_(from), size_(size), rtl_(rtl), data_(seq.data_) {}
 
@@ -283,6 +289,15 @@ public:
         return size_;
     }
 
+    /**
+     * Number of ST elements occupied by 2-bit packed sequence of given size
+     */
+    static size_t PackedSize(size_t size) {
+        return DataSize(size);
+    }
+
+    inline void CopyPackedData(ST *dst) const;
+
     template<class Seq>
     bool contains(const Seq& s, size_t offset = 0) const {
         VERIFY(offset + s.size() <= size());
@@ -482,6 +497,17 @@ std::ostream &operator<<(std::ostream &os, const Sequence &s) {
     return os;
 }
 
+void Sequence::CopyPackedData(ST *dst) const {
+    if (from_ == 0 && !rtl_) {
+        memcpy(dst, data_->data(), DataSize(size_) * sizeof(ST));
+        return;
+    }
+
+    memset(dst, 0, DataSize(size_) * sizeof(ST));
+    for (size_t i = 0; i < size_; ++i)
+        dst[i >> STNBits] |= ST(operator[](i)) << ((i & (STN - 1)) << 1);
+}
+
 bool Sequence::ReadHeader(std::istream &file) {
     file.read((char *) &size_, sizeof(size_));
 
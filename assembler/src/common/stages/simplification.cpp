@@ -355,6 +355,7 @@ class GraphSimplifier {
     bool RunAlgo(const AlgoPtr<Graph>& algo, const string &comment, bool force_primary_launch = false) {
         INFO("Running " << comment);
         size_t triggered = algo->Run(force_primary_launch);
+        gp_.g.FireFlush();
         INFO("Triggered " << triggered << " times");
         cnt_callback_.Report();
         return (triggered > 0);
@@ -525,10 +526,14 @@ void Simplification::run(conj_graph_pack &gp, const char*) {
                                preliminary_ ? *cfg::get().preliminary_simp : cfg::get().simp,
                                nullptr/*removal_handler_f*/,
                                printer);
+
+    // Glues are passed to k-mer mapper in batches after every simplification algorithm
+    gp.kmer_mapper.SetBatched(true);
     if (cfg::get().mode == pipeline_type::rna)
         simplifier.SimplifyRNAGraph();
     else
         simplifier.SimplifyGraph();
+    gp.kmer_mapper.SetBatched(false);
 
 }
 
@@ -601,14 +606,12 @@ void corrected_and_save_reads(const conj_graph_pack& gp) {
         INFO("Correcting paired reads");
 
         io::BinaryWriter paired_converter(
-            cfg::get().paired_read_prefix + "_cor", cfg::get().max_threads,
-            cfg::get().buffer_size);
+            cfg::get().paired_read_prefix + "_cor");
         paired_converter.ToBinary(refined_paired_stream);
 
         INFO("Correcting single reads");
         io::BinaryWriter single_converter(
-            cfg::get().single_read_prefix + "_cor", cfg::get().max_threads,
-            cfg::get().buffer_size);
+            cfg::get().single_read_prefix + "_cor");
         single_converter.ToBinary(refined_single_stream);
     } else {
         //save in fasta
@@ -79,7 +79,7 @@ public:
                           index.k() + 1, Index::storing_type::IsInvertable(), read_buffer_size);
         for (unsigned i = 0; i < nthreads; ++i)
             splitter2.AddKMers(counter.GetMergedKMersFname(i));
-        KMerDiskCounter<RtSeq> counter2(index.workdir(), splitter2);
+        KMerMemoryCounter<RtSeq> counter2(index.workdir(), splitter2);
 
         BuildIndex(index, counter2, 16, nthreads);
 
@@ -11,7 +11,9 @@
 #include <boomphf/BooPHF.h>
 #include <city/city.h>
 
+#include <algorithm>
 #include <vector>
+#include <memory>
 #include <cmath>
 
 namespace utils {
@@ -55,6 +57,7 @@ public:
 
     delete[] index_;
     index_ = NULL;
+    mapped_.reset();
   }
 
   size_t mem_size() {
@@ -89,6 +92,24 @@ public:
     return bucket_starts_[bucket] + index_[bucket].lookup(data);
   }
 
+  // Batched seq_idx(). K-mers are hashed and their mphf bits are prefetched
+  // in groups before being resolved, so the cache misses of the lookups overlap.
+  void seq_idx(const KMerSeq *kmers, size_t n, size_t *idx) const {
+    const size_t BatchSize = 16;
+    size_t buckets[BatchSize];
+    boomphf::hash_pair_t hashes[BatchSize];
+
+    for (size_t start = 0; start < n; start += BatchSize) {
+      size_t cnt = std::min(BatchSize, n - start);
+      for (size_t i = 0; i < cnt; ++i) {
+        buckets[i] = seq_bucket(kmers[start + i]);
+        hashes[i] = index_[buckets[i]].prefetch(kmers[start + i]);
+      }
+      for (size_t i = 0; i < cnt; ++i)
+        idx[start + i] = bucket_starts_[buckets[i]] + index_[buckets[i]].lookup_hash(hashes[i]);
+    }
+  }
+
   template<class Writer>
   void serialize(Writer &os) const {
     os.write((char*)&num_buckets_, sizeof(num_buckets_));
@@ -112,15 +133,63 @@ public:
     count_size();
   }
 
+  // Layout suitable for map(): header, bucket starts and then all the mphfs,
+  // every field is 64-bit wide
+  template<class Writer>
+  void serialize_mapped(Writer &os) const {
+    uint64_t magic = MappedMagic, num_buckets = num_buckets_;
+    os.write((char*)&magic, sizeof(magic));
+    os.write((char*)&num_buckets, sizeof(num_buckets));
+    for (size_t i = 0; i <= num_buckets_; ++i) {
+      uint64_t start = bucket_starts_[i];
+      os.write((char*)&start, sizeof(start));
+    }
+    for (size_t i = 0; i < num_buckets_; ++i)
+      index_[i].save_mapped(os);
+  }
+
+  // Attaches the index to the file written by serialize_mapped(). Level bitsets
+  // are used directly from the read-only mapping, so the index is ready without
+  // reading the whole file; pages are shared between processes via page cache.
+  void map(const std::string &FileName) {
+    clear();
+
+    mapped_ = std::make_shared<MMappedReader>(FileName, false, -1ULL);
+    VERIFY_MSG(mapped_->size() >= 2 * sizeof(uint64_t), "Truncated k-mer index file " << FileName);
+    const uint64_t *data = (const uint64_t*)mapped_->data();
+    const uint64_t *end = data + mapped_->size() / sizeof(uint64_t);
+    VERIFY_MSG(*data++ == MappedMagic, "Invalid k-mer index file " << FileName);
+
+    num_buckets_ = *data++;
+    bucket_starts_.assign(data, data + num_buckets_ + 1);
+    data += num_buckets_ + 1;
+
+    index_ = new KMerDataIndex[num_buckets_];
+    for (size_t i = 0; i < num_buckets_; ++i)
+      data = index_[i].map(data);
+    VERIFY_MSG(data == end, "Corrupted k-mer index file " << FileName);
+
+    count_size();
+  }
+
+  bool mapped() const {
+    return mapped_ != nullptr;
+  }
+
   void swap(KMerIndex<traits> &other) {
     std::swap(index_, other.index_);
     std::swap(num_buckets_, other.num_buckets_);
     std::swap(size_, other.size_);
     std::swap(bucket_starts_, other.bucket_starts_);
+    std::swap(mapped_, other.mapped_);
   }
 
  private:
+  static const uint64_t MappedMagic = 0x3148504d52454d4bULL; // "KMERMPH1"
+
   KMerDataIndex *index_;
+  // Backing storage of the mphf bitsets, when attached via map()
+  std::shared_ptr<MMappedReader> mapped_;
 
   size_t num_buckets_;
   std::vector<size_t> bucket_starts_;
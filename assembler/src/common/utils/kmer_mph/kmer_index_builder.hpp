@@ -10,6 +10,7 @@
 
 #include "io/kmers/mmapped_reader.hpp"
 #include "io/kmers/mmapped_writer.hpp"
+#include "io/kmers/buffered_writer.hpp"
 #include "common/adt/kmer_vector.hpp"
 
 #include "utils/parallel/openmp_wrapper.h"
@@ -76,7 +77,7 @@ class KMerDiskCounter : public KMerCounter<Seq> {
   typedef typename traits::RawKMerStorage BucketStorage;
 public:
   KMerDiskCounter(const std::string &work_dir, KMerSplitter<Seq> &splitter)
-      : work_dir_(work_dir), splitter_(splitter) {
+      : splitter_(splitter), work_dir_(work_dir) {
     std::string prefix = fs::append_path(work_dir, "kmers_XXXXXX");
     char *tempprefix = strcpy(new char[prefix.length() + 1], prefix.c_str());
     VERIFY_MSG(-1 != (fd_ = ::mkstemp(tempprefix)), "Cannot create temporary file");
@@ -99,51 +100,24 @@ public:
   }
 
   size_t Count(unsigned num_buckets, unsigned num_threads) override {
-    unsigned K = splitter_.K();
     unsigned num_files = num_buckets * num_threads;
 
     // Split k-mers into buckets.
     INFO("Splitting kmer instances into " << num_files << " buckets using " << num_threads << " threads. This might take a while.");
     fs::files_t raw_kmers = splitter_.Split(num_files, num_threads);
 
-    INFO("Starting k-mer counting.");
-    size_t kmers = 0;
-#   pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
-    for (unsigned iFile = 0; iFile < raw_kmers.size(); ++iFile) {
-      kmers += MergeKMers(raw_kmers[iFile], GetUniqueKMersFname(iFile), K);
-    }
-    INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
-    if (!kmers) {
-      FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
-      exit(-1);
-    }
-
-    INFO("Merging temporary buckets.");
-    for (unsigned i = 0; i < num_buckets; ++i) {
-      std::string ofname = GetMergedKMersFname(i);
-      std::ofstream ofs(ofname.c_str(), std::ios::out | std::ios::binary);
-      for (unsigned j = 0; j < num_threads; ++j) {
-        BucketStorage ins(GetUniqueKMersFname(i + j * num_buckets), Seq::GetDataSize(K), /* unlink */ true);
-        ofs.write((const char*)ins.data(), ins.data_size());
-      }
-    }
-
-    return kmers;
+    return MergeRawKMers(raw_kmers, num_buckets, num_threads);
   }
 
   void MergeBuckets(unsigned num_buckets) override {
-    unsigned K = splitter_.K();
-
     INFO("Merging final buckets.");
 
-    MMappedRecordArrayWriter<typename Seq::DataType> os(GetFinalKMersFname(), Seq::GetDataSize(K));
-    std::string ofname = GetFinalKMersFname();
-    std::ofstream ofs(ofname.c_str(), std::ios::out | std::ios::binary);
+    BufferedWriter os(GetFinalKMersFname(), BufferedWriter::DefaultBufferSize, /* async */ true);
     for (unsigned j = 0; j < num_buckets; ++j) {
       auto bucket = GetBucket(j, /* unlink */ true);
-      ofs.write((const char*)bucket->data(), bucket->data_size());
+      os.write(bucket->data(), bucket->data_size());
     }
-    ofs.close();
+    os.close();
   }
 
   size_t CountAll(unsigned num_buckets, unsigned num_threads, bool merge = true) override {
@@ -167,9 +141,38 @@ public:
     return kmer_prefix_ + ".final";
   }
 
+protected:
+  KMerSplitter<Seq> &splitter_;
+
+  size_t MergeRawKMers(const fs::files_t &raw_kmers, unsigned num_buckets, unsigned num_threads) {
+    unsigned K = splitter_.K();
+
+    INFO("Starting k-mer counting.");
+    size_t kmers = 0;
+#   pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
+    for (unsigned iFile = 0; iFile < raw_kmers.size(); ++iFile) {
+      kmers += MergeKMers(raw_kmers[iFile], GetUniqueKMersFname(iFile), K);
+    }
+    INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
+    if (!kmers) {
+      FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
+      exit(-1);
+    }
+
+    INFO("Merging temporary buckets.");
+    for (unsigned i = 0; i < num_buckets; ++i) {
+      BufferedWriter os(GetMergedKMersFname(i), BufferedWriter::DefaultBufferSize, /* async */ true);
+      for (unsigned j = 0; j < num_threads; ++j) {
+        BucketStorage ins(GetUniqueKMersFname(i + j * num_buckets), Seq::GetDataSize(K), /* unlink */ true);
+        os.write(ins.data(), ins.data_size());
+      }
+    }
+
+    return kmers;
+  }
+
 private:
   std::string work_dir_;
-  KMerSplitter<Seq> &splitter_;
   int fd_;
   std::string kmer_prefix_;
 
@@ -202,44 +205,26 @@ private:
       adt::loser_tree<decltype(beg),
               adt::array_less<typename Seq::DataType>> tree(ranges);
 
-      if (tree.empty()) {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        VERIFY_MSG(g, "Cannot open temporary file to write");
-        fclose(g);
+      BufferedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(K));
+      if (tree.empty())
         return 0;
-      }
 
       // Write it down!
-      adt::KMerVector<Seq> buf(K, 1024*1024);
       auto pval = tree.pop();
       size_t total = 0;
       while (!tree.empty()) {
-          buf.clear();
-          for (size_t cnt = 0; cnt < buf.capacity() && !tree.empty(); ) {
-              auto cval = tree.pop();
-              if (!adt::array_equal_to<typename Seq::DataType>()(pval, cval)) {
-                  buf.push_back(pval);
-                  pval = cval;
-                  cnt += 1;
-              }
+          auto cval = tree.pop();
+          if (!adt::array_equal_to<typename Seq::DataType>()(pval, cval)) {
+              os.write(pval.data(), 1);
+              pval = cval;
+              total += 1;
           }
-          total += buf.size();
-
-          FILE *g = fopen(ofname.c_str(), "ab");
-          VERIFY_MSG(g, "Cannot open temporary file to write");
-          fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
-          fclose(g);
       }
 
       // Handle very last value
-      {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        VERIFY_MSG(g, "Cannot open temporary file to write");
-        fwrite(pval.data(), pval.data_size(), 1, g);
-        fclose(g);
-        total += 1;
-      }
-      
+      os.write(pval.data(), 1);
+      total += 1;
+
       return total;
     } else {
       // Sort the stuff
@@ -249,13 +234,92 @@ private:
       // resizing.
       auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
 
-      MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(K));
-      os.resize(it - ins.begin());
-      std::copy(ins.begin(), it, os.begin());
+      size_t total = it - ins.begin();
+      BufferedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(K));
+      os.write(ins.data(), total);
+
+      return total;
+    }
+  }
+};
+
+// Keeps split k-mers in memory and sorts them there, falling back to disk
+// counting when they do not fit into the memory limit (by default, a third of free memory)
+template<class Seq, class traits = kmer_index_traits<Seq> >
+class KMerMemoryCounter : public KMerDiskCounter<Seq, traits> {
+  typedef KMerDiskCounter<Seq, traits> __super;
+  typedef typename traits::RawKMerStorage BucketStorage;
+  typedef typename Seq::DataType ElTy;
+public:
+  KMerMemoryCounter(const std::string &work_dir, KMerSplitter<Seq> &splitter, size_t memory_limit = 0)
+      : __super(work_dir, splitter), memory_limit_(memory_limit) {}
+
+  std::unique_ptr<BucketStorage> GetBucket(size_t idx, bool unlink = true) override {
+    if (buckets_.empty())
+      return __super::GetBucket(idx, unlink);
+
+    VERIFY_MSG(buckets_[idx], "Bucket " << idx << " was already released");
+    if (unlink)
+      return std::move(buckets_[idx]);
+
+    const BucketStorage &bucket = *buckets_[idx];
+    std::unique_ptr<BucketStorage> res(new BucketStorage(bucket.elcnt(), bucket.data_size()));
+    std::copy(bucket.data(), bucket.data() + bucket.data_size() / sizeof(ElTy), res->data());
+    return res;
+  }
+
+  size_t Count(unsigned num_buckets, unsigned num_threads) override {
+    unsigned K = this->splitter_.K();
+    unsigned num_files = num_buckets * num_threads;
+    size_t memory_limit = memory_limit_ ? memory_limit_ : utils::get_free_memory() / 3;
+
+    KMerMemoryBuckets<Seq> raw_kmers(K, num_files, memory_limit);
+    if (!this->splitter_.SetMemoryBuckets(&raw_kmers))
+      return __super::Count(num_buckets, num_threads);
+
+    INFO("Splitting kmer instances into " << num_files << " in-memory buckets using " << num_threads << " threads. "
+         "Memory limit is " << (double)memory_limit / 1024.0 / 1024.0 / 1024.0 << " Gb");
+    fs::files_t raw_files = this->splitter_.Split(num_files, num_threads);
+    this->splitter_.SetMemoryBuckets(nullptr);
+
+    if (raw_kmers.spilled())
+      return this->MergeRawKMers(raw_files, num_buckets, num_threads);
 
-      return it - ins.begin();
+    INFO("Starting in-memory k-mer counting.");
+    size_t kmers = 0;
+#   pragma omp parallel for num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
+    for (unsigned iFile = 0; iFile < num_files; ++iFile)
+      kmers += raw_kmers.SortUnique(iFile);
+
+    INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
+    if (!kmers) {
+      FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
+      exit(-1);
     }
+
+    INFO("Merging temporary buckets.");
+    buckets_.resize(num_buckets);
+#   pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+    for (unsigned i = 0; i < num_buckets; ++i) {
+      size_t sz = 0;
+      for (unsigned j = 0; j < num_threads; ++j)
+        sz += raw_kmers[i + j * num_buckets].size();
+
+      buckets_[i].reset(new BucketStorage(Seq::GetDataSize(K), sz * sizeof(ElTy)));
+      ElTy *out = buckets_[i]->data();
+      for (unsigned j = 0; j < num_threads; ++j) {
+        const auto &raw = raw_kmers[i + j * num_buckets];
+        out = std::copy(raw.begin(), raw.end(), out);
+        raw_kmers.Release(i + j * num_buckets);
+      }
+    }
+
+    return kmers;
   }
+
+private:
+  size_t memory_limit_;
+  std::vector<std::unique_ptr<BucketStorage>> buckets_;
 };
 
 template<class Index>
@@ -10,8 +10,86 @@
 #include "io/reads/io_helper.hpp"
 #include "utils/filesystem/file_limit.hpp"
 
+#include <deque>
+
 namespace utils {
 
+// Sorted runs of split k-mers kept in memory instead of temporary files, see KMerMemoryCounter
+template<class Seq>
+class KMerMemoryBuckets {
+    typedef typename Seq::DataType ElTy;
+
+public:
+    KMerMemoryBuckets(unsigned K, size_t num_files, size_t memory_limit)
+            : el_sz_(Seq::GetDataSize(K)), buckets_(num_files), runs_(num_files),
+              memory_limit_(memory_limit), spilled_(false) {}
+
+    // Not thread-safe for the same bucket
+    void AddRun(size_t idx, const ElTy *data, size_t cnt) {
+        buckets_[idx].insert(buckets_[idx].end(), data, data + cnt * el_sz_);
+        runs_[idx].push_back(cnt);
+    }
+
+    size_t SortUnique(size_t idx) {
+        auto &bucket = buckets_[idx];
+        adt::array_vector<ElTy> kmers(bucket.data(), bucket.size() / el_sz_, el_sz_);
+        libcxx::sort(kmers.begin(), kmers.end(), adt::array_less<ElTy>());
+        auto it = std::unique(kmers.begin(), kmers.end(), adt::array_equal_to<ElTy>());
+
+        size_t cnt = it - kmers.begin();
+        bucket.resize(cnt * el_sz_);
+        runs_[idx].assign(1, cnt);
+        return cnt;
+    }
+
+    // Writes stored runs to files in the same format as KMerSortingSplitter::DumpBuffers does
+    void Spill(const fs::files_t &ostreams) {
+        VERIFY(ostreams.size() == buckets_.size());
+#       pragma omp parallel for
+        for (size_t k = 0; k < buckets_.size(); ++k) {
+            FILE *f = fopen(ostreams[k].c_str(), "ab");
+            VERIFY_MSG(f, "Cannot open temporary file to write");
+            fwrite(buckets_[k].data(), sizeof(ElTy), buckets_[k].size(), f);
+            fclose(f);
+
+            f = fopen((ostreams[k] + ".idx").c_str(), "ab");
+            VERIFY_MSG(f, "Cannot open temporary file to write");
+            fwrite(runs_[k].data(), sizeof(size_t), runs_[k].size(), f);
+            fclose(f);
+
+            Release(k);
+        }
+        spilled_ = true;
+    }
+
+    void Release(size_t idx) {
+        std::vector<ElTy>().swap(buckets_[idx]);
+        std::vector<size_t>().swap(runs_[idx]);
+    }
+
+    size_t mem_size() const {
+        size_t res = 0;
+        for (const auto &bucket : buckets_)
+            res += bucket.capacity() * sizeof(ElTy);
+        return res;
+    }
+
+    bool full() const { return mem_size() > memory_limit_; }
+
+    bool spilled() const { return spilled_; }
+
+    size_t size() const { return buckets_.size(); }
+
+    const std::vector<ElTy> &operator[](size_t idx) const { return buckets_[idx]; }
+
+private:
+    size_t el_sz_;
+    std::vector<std::vector<ElTy>> buckets_;
+    std::vector<std::vector<size_t>> runs_;
+    size_t memory_limit_;
+    bool spilled_;
+};
+
 template<class Seq>
 class KMerSplitter {
 public:
@@ -24,6 +102,9 @@ public:
 
     virtual fs::files_t Split(size_t num_files, unsigned nthreads) = 0;
 
+    // Returns false if splitter is unable to keep k-mers in memory
+    virtual bool SetMemoryBuckets(KMerMemoryBuckets<Seq> *) { return false; }
+
     size_t kmer_size() const {
         return Seq::GetDataSize(K_) * sizeof(typename Seq::DataType);
     }
@@ -43,7 +124,12 @@ template<class Seq>
 class KMerSortingSplitter : public KMerSplitter<Seq> {
 public:
     KMerSortingSplitter(const std::string &work_dir, unsigned K, uint32_t seed = 0)
-            : KMerSplitter<Seq>(work_dir, K, seed), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K, seed), cell_size_(0), num_files_(0), memory_buckets_(nullptr) {}
+
+    bool SetMemoryBuckets(KMerMemoryBuckets<Seq> *buckets) override {
+        memory_buckets_ = buckets;
+        return true;
+    }
 
 protected:
     using SeqKMerVector = adt::KMerVector<Seq>;
@@ -52,6 +138,18 @@ protected:
     std::vector<KMerBuffer> kmer_buffers_;
     size_t cell_size_;
     size_t num_files_;
+    KMerMemoryBuckets<Seq> *memory_buckets_;
+
+    // Memory for the buffers of a single thread, 0 means to choose it by free memory
+    size_t BufferSize(unsigned nthreads, size_t reads_buffer_size) const {
+        if (reads_buffer_size)
+            return reads_buffer_size;
+
+        reads_buffer_size = 536870912ull;
+        size_t mem_limit =  (size_t)((double)(utils::get_free_memory()) / (nthreads * 3));
+        INFO("Memory available for splitting buffers: " << (double)mem_limit / 1024.0 / 1024.0 / 1024.0 << " Gb");
+        return std::min(reads_buffer_size, mem_limit);
+    }
 
     fs::files_t PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
         num_files_ = num_files;
@@ -68,12 +166,7 @@ protected:
             WARN("Do 'ulimit -n " << file_limit << "' in the console to overcome the limit");
         }
 
-        if (reads_buffer_size == 0) {
-            reads_buffer_size = 536870912ull;
-            size_t mem_limit =  (size_t)((double)(utils::get_free_memory()) / (nthreads * 3));
-            INFO("Memory available for splitting buffers: " << (double)mem_limit / 1024.0 / 1024.0 / 1024.0 << " Gb");
-            reads_buffer_size = std::min(reads_buffer_size, mem_limit);
-        }
+        reads_buffer_size = BufferSize(nthreads, reads_buffer_size);
         cell_size_ = reads_buffer_size / (num_files_ * this->kmer_size());
         // Set sane minimum cell size
         if (cell_size_ < 16384)
@@ -117,6 +210,11 @@ protected:
             libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
             auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
 
+            if (memory_buckets_) {
+                memory_buckets_->AddRun(k, SortBuffer.data(), it - SortBuffer.begin());
+                continue;
+            }
+
 #     pragma omp critical
             {
                 size_t cnt =  it - SortBuffer.begin();
@@ -138,6 +236,12 @@ protected:
         for (auto & entry : kmer_buffers_)
             for (auto & eentry : entry)
                 eentry.clear();
+
+        if (memory_buckets_ && memory_buckets_->full()) {
+            INFO("K-mers do not fit into memory, moving them to temporary files");
+            memory_buckets_->Spill(ostreams);
+            memory_buckets_ = nullptr;
+        }
     }
 
     void ClearBuffers() {
@@ -160,18 +264,277 @@ protected:
 
 using RtSeqKMerSplitter = KMerSortingSplitter<RtSeq>;
 
+// Sequential reader of super-k-mer bins, bin files are removed once read
+class SuperKMerReader {
+  std::vector<std::string> files_;
+  size_t current_;
+  FILE *f_;
+
+ public:
+  SuperKMerReader() : current_(0), f_(NULL) {}
+
+  ~SuperKMerReader() {
+    if (f_)
+      fclose(f_);
+  }
+
+  void AddBin(const std::string &fname) {
+    files_.push_back(fname);
+  }
+
+  bool good() const { return current_ < files_.size(); }
+
+  bool read(std::vector<uint8_t> &packed, uint32_t &len) {
+    while (good()) {
+      if (!f_) {
+        // Bin might have got no super-k-mers at all
+        if (!(f_ = fopen(files_[current_].c_str(), "rb"))) {
+          current_ += 1;
+          continue;
+        }
+      }
+
+      if (fread(&len, sizeof(len), 1, f_) == 1) {
+        packed.resize((len + 3) / 4);
+        VERIFY_MSG(fread(packed.data(), 1, packed.size(), f_) == packed.size(),
+                   "Truncated super-k-mer bin " << files_[current_]);
+        return true;
+      }
+
+      fclose(f_);
+      f_ = NULL;
+      ::unlink(files_[current_].c_str());
+      current_ += 1;
+    }
+
+    return false;
+  }
+};
+
+// In super-k-mer mode consecutive k-mers of a sequence sharing the same minimizer
+// are stored once as a super-k-mer (32-bit length followed by nucleotides packed 4
+// per byte) in a bin chosen by the minimizer. Bins are expanded back into k-mers
+// after all the input is processed, so duplicate k-mers meet in the same sorting
+// buffers and only unique ones get into the raw k-mer files. Minimizers are taken
+// over canonical m-mers, so a k-mer and its reverse complement share a bin.
+// The mode is used for K of at least twice the minimizer length unless it is
+// turned off in the constructor.
 template<class KmerFilter>
 class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
  private:
   KmerFilter kmer_filter_;
+
+  static const unsigned MinimizerLength = 15;
+
+  struct MinimizerCandidate {
+    uint64_t hash;
+    uint64_t code;
+    size_t pos;
+  };
+
+  bool use_superkmers_;
+  std::vector<std::vector<std::vector<uint8_t>>> superkmer_buffers_;
+  std::vector<size_t> superkmer_buffer_sizes_;
+  size_t superkmer_buffer_limit_;
+  size_t superkmer_bytes_;
+
+  static uint64_t MinimizerHash(uint64_t x) {
+    // MurmurHash3 finalizer, bijective on 64-bit values
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  std::string GetSuperKMersFname(unsigned suffix) const {
+    return fs::append_path(this->work_dir_, "superkmers." + std::to_string(suffix));
+  }
+
+  bool PushSuperKMer(const Sequence &seq, size_t from, size_t to,
+                     uint64_t minimizer, unsigned thread_id) {
+    auto &bins = superkmer_buffers_[thread_id];
+    auto &buffer = bins[MinimizerHash(minimizer + 1) % bins.size()];
+
+    uint32_t len = uint32_t(to - from);
+    size_t sz = sizeof(len) + (len + 3) / 4, pos = buffer.size();
+    buffer.resize(pos + sz, 0);
+    memcpy(&buffer[pos], &len, sizeof(len));
+    uint8_t *packed = &buffer[pos + sizeof(len)];
+    for (size_t i = 0; i < len; ++i)
+      packed[i / 4] |= uint8_t(seq[from + i] << (2 * (i % 4)));
+
+    superkmer_buffer_sizes_[thread_id] += sz;
+    return superkmer_buffer_sizes_[thread_id] > superkmer_buffer_limit_;
+  }
+
+  bool FillSuperKMersFromSequence(const Sequence &seq,
+                                  unsigned thread_id) {
+      const unsigned m = MinimizerLength;
+      const uint64_t mask = (1ULL << (2 * m)) - 1;
+
+      // Candidates of the current k-mer window with increasing hashes
+      std::deque<MinimizerCandidate> window;
+      uint64_t fwd = 0, rev = 0, minimizer = 0;
+      size_t start = 0;
+      bool stop = false;
+      for (size_t j = 0; j < seq.size(); ++j) {
+        uint64_t c = seq[j];
+        fwd = ((fwd << 2) | c) & mask;
+        rev = (rev >> 2) | ((3 - c) << (2 * (m - 1)));
+        if (j + 1 < m)
+          continue;
+
+        uint64_t code = std::min(fwd, rev), hash = MinimizerHash(code);
+        while (!window.empty() && window.back().hash > hash)
+          window.pop_back();
+        window.push_back({ hash, code, j + 1 - m });
+        if (j + 1 < this->K_)
+          continue;
+
+        size_t kmer_start = j + 1 - this->K_;
+        while (window.front().pos < kmer_start)
+          window.pop_front();
+
+        if (kmer_start == 0) {
+          minimizer = window.front().code;
+        } else if (window.front().code != minimizer) {
+          stop |= PushSuperKMer(seq, start, kmer_start - 1 + this->K_, minimizer, thread_id);
+          start = kmer_start;
+          minimizer = window.front().code;
+        }
+      }
+
+      if (seq.size() >= this->K_)
+        stop |= PushSuperKMer(seq, start, seq.size(), minimizer, thread_id);
+
+      return stop;
+  }
+
+  bool FillBufferFromSuperKMers(SuperKMerReader &reader,
+                                unsigned thread_id) {
+      size_t chunk = this->cell_size_ * this->num_files_ / 2;
+      adt::KMerVector<RtSeq> kmers(this->K_, chunk);
+      std::vector<uint8_t> packed;
+      uint32_t len;
+
+      bool stop = false;
+      while (!stop && reader.good()) {
+        kmers.clear();
+        while (kmers.size() < chunk && reader.read(packed, len)) {
+          RtSeq kmer(this->K_);
+          for (uint32_t i = 0; i < len; ++i) {
+            kmer <<= char((packed[i / 4] >> (2 * (i % 4))) & 3);
+            if (i + 1 < this->K_ || !kmer_filter_.filter(kmer))
+              continue;
+
+            kmers.push_back(kmer);
+          }
+        }
+
+        // Get rid of duplicates before they occupy sorting buffers
+        libcxx::sort(kmers.begin(), kmers.end(), adt::KMerVector<RtSeq>::less2_fast());
+        auto it = std::unique(kmers.begin(), kmers.end(), adt::KMerVector<RtSeq>::equal_to());
+        for (auto kit = kmers.begin(); kit != it; ++kit)
+          stop |= this->push_back_internal(RtSeq(this->K_, (*kit).data()), thread_id);
+      }
+
+      return stop;
+  }
+
+  void DumpSuperKMers() {
+      size_t bytes = 0;
+#     pragma omp parallel for reduction(+ : bytes)
+      for (unsigned k = 0; k < this->num_files_; ++k) {
+        FILE *f = NULL;
+        for (auto &entry : superkmer_buffers_) {
+          auto &buffer = entry[k];
+          if (buffer.empty())
+            continue;
+
+          if (!f) {
+            f = fopen(GetSuperKMersFname(k).c_str(), "ab");
+            VERIFY_MSG(f, "Cannot open temporary file to write");
+          }
+          fwrite(buffer.data(), 1, buffer.size(), f);
+          bytes += buffer.size();
+          buffer.clear();
+        }
+        if (f)
+          fclose(f);
+      }
+
+      superkmer_bytes_ += bytes;
+      std::fill(superkmer_buffer_sizes_.begin(), superkmer_buffer_sizes_.end(), 0);
+  }
+
  protected:
   size_t read_buffer_size_;
- protected:
+
+  fs::files_t PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
+      if (!use_superkmers_)
+        return RtSeqKMerSplitter::PrepareBuffers(num_files, nthreads, reads_buffer_size);
+
+      // Super-k-mer and k-mer sorting buffers split the memory of a thread in halves
+      reads_buffer_size = this->BufferSize(nthreads, reads_buffer_size) / 2;
+      fs::files_t out = RtSeqKMerSplitter::PrepareBuffers(num_files, nthreads, reads_buffer_size);
+      superkmer_buffers_.assign(nthreads, std::vector<std::vector<uint8_t>>(num_files));
+      superkmer_buffer_sizes_.assign(nthreads, 0);
+      superkmer_buffer_limit_ = reads_buffer_size;
+      superkmer_bytes_ = 0;
+      INFO("Using super-k-mers with minimizers of length " << MinimizerLength);
+
+      return out;
+  }
+
+  void DumpBuffers(const fs::files_t &ostreams) {
+      if (use_superkmers_)
+        DumpSuperKMers();
+
+      // In super-k-mer mode sorting buffers get k-mers only from RtSeq sources
+      bool empty = std::all_of(this->kmer_buffers_.begin(), this->kmer_buffers_.end(),
+                               [](const KMerBuffer &entry) {
+                                 return std::all_of(entry.begin(), entry.end(),
+                                                    [](const SeqKMerVector &v) { return v.size() == 0; });
+                               });
+      if (!empty)
+        RtSeqKMerSplitter::DumpBuffers(ostreams);
+  }
+
+  // Turns stored super-k-mers into k-mers in the output files, must be called
+  // once all the input was processed
+  void ExpandSuperKMers(const fs::files_t &ostreams) {
+      if (!use_superkmers_)
+        return;
+
+      DumpSuperKMers();
+      std::vector<std::vector<std::vector<uint8_t>>>().swap(superkmer_buffers_);
+
+      unsigned nthreads = (unsigned) this->kmer_buffers_.size();
+      INFO("Expanding super-k-mers, " << (double)superkmer_bytes_ / 1024.0 / 1024.0 << " Mb in total");
+      std::vector<SuperKMerReader> readers(nthreads);
+      for (unsigned k = 0; k < this->num_files_; ++k)
+        readers[k % nthreads].AddBin(GetSuperKMersFname(k));
+
+      while (std::any_of(readers.begin(), readers.end(),
+                         [](const SuperKMerReader &r) { return r.good(); })) {
+#       pragma omp parallel for num_threads(nthreads)
+        for (unsigned i = 0; i < nthreads; ++i)
+          FillBufferFromSuperKMers(readers[i], i);
+
+        RtSeqKMerSplitter::DumpBuffers(ostreams);
+      }
+  }
+
   bool FillBufferFromSequence(const Sequence &seq,
                               unsigned thread_id) {
       if (seq.size() < this->K_)
         return false;
 
+      if (use_superkmers_)
+        return FillSuperKMersFromSequence(seq, thread_id);
+
       RtSeq kmer = seq.start<RtSeq>(this->K_) >> 'A';
       bool stop = false;
       for (size_t j = this->K_ - 1; j < seq.size(); ++j) {
@@ -205,8 +568,11 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
 
  public:
   DeBruijnKMerSplitter(const std::string &work_dir,
-                       unsigned K, KmerFilter kmer_filter, size_t read_buffer_size = 0, uint32_t seed = 0)
-      : RtSeqKMerSplitter(work_dir, K, seed), kmer_filter_(kmer_filter), read_buffer_size_(read_buffer_size) {
+                       unsigned K, KmerFilter kmer_filter, size_t read_buffer_size = 0, uint32_t seed = 0,
+                       bool use_superkmers = true)
+      : RtSeqKMerSplitter(work_dir, K, seed), kmer_filter_(kmer_filter),
+        use_superkmers_(use_superkmers && K >= 2 * MinimizerLength), superkmer_buffer_limit_(0), superkmer_bytes_(0),
+        read_buffer_size_(read_buffer_size) {
   }
  protected:
   DECL_LOGGER("DeBruijnKMerSplitter");
@@ -234,8 +600,9 @@ class DeBruijnReadKMerSplitter : public DeBruijnKMerSplitter<KmerFilter> {
                            unsigned K, uint32_t seed,
                            io::ReadStreamList<Read>& streams,
                            io::SingleStream* contigs_stream = 0,
-                           size_t read_buffer_size = 0)
-      : DeBruijnKMerSplitter<KmerFilter>(work_dir, K, KmerFilter(), read_buffer_size, seed),
+                           size_t read_buffer_size = 0,
+                           bool use_superkmers = true)
+      : DeBruijnKMerSplitter<KmerFilter>(work_dir, K, KmerFilter(), read_buffer_size, seed, use_superkmers),
       streams_(streams), contigs_(contigs_stream), rs_({0 ,0 ,0}) {}
 
   fs::files_t Split(size_t num_files, unsigned nthreads) override;
@@ -305,6 +672,7 @@ fs::files_t DeBruijnReadKMerSplitter<Read, KmerFilter>::Split(size_t num_files,
     }
   }
 
+  this->ExpandSuperKMers(out);
   this->ClearBuffers();
 
   INFO("Used " << counter << " reads. Maximum read length " << rl);
@@ -47,6 +47,16 @@ public:
         return idx_;
     }
 
+    //key to be looked up in index and setter for the result, used for batched lookups
+    const Key &hashed_key() const {
+        return key_;
+    }
+
+    void set_idx(IdxType idx) const {
+        idx_ = idx;
+        ready_ = true;
+    }
+
     SimpleKeyWithHash &operator=(const SimpleKeyWithHash &that) {
         VERIFY(&this->hash_ == &that.hash_);
         this->key_= that.key_;
@@ -144,6 +154,17 @@ private:
         return idx_;
     }
 
+    //key to be looked up in index and setter for the result, used for batched lookups
+    Key hashed_key() const {
+        return key_.IsMinimal() ? key_ : !key_;
+    }
+
+    void set_idx(IdxType idx) const {
+        is_minimal_ = key_.IsMinimal();
+        idx_ = idx;
+        ready_ = true;
+    }
+
     bool is_minimal() const {
         if(!ready_) {
             return key_.IsMinimal();
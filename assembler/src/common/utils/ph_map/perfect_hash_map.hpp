@@ -17,6 +17,8 @@
 #include "storing_traits.hpp"
 
 #include <vector>
+#include <fstream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstdint>
 
@@ -80,6 +82,27 @@ public:
         index_ptr_->deserialize(reader);
     }
 
+    // Saves the index alone in the format which could be attached via LoadMapped.
+    // The file is replaced atomically, since it might be mapped by this very index.
+    void SaveMapped(const std::string &FileName) const {
+        std::string tmp = FileName + ".tmp";
+        {
+            std::ofstream os(tmp, std::ios::binary | std::ios::out);
+            VERIFY_MSG(os.is_open(), "Cannot open " << tmp << " for writing");
+            index_ptr_->serialize_mapped(os);
+            VERIFY_MSG(os.good(), "Failed to write index to " << tmp);
+        }
+        VERIFY_MSG(std::rename(tmp.c_str(), FileName.c_str()) == 0,
+                   "Cannot rename " << tmp << " to " << FileName);
+    }
+
+    // Memory-maps the index saved by SaveMapped, the file should not be changed
+    // while the index is in use
+    void LoadMapped(const std::string &FileName) {
+        clear();
+        index_ptr_->map(FileName);
+    }
+
     const std::string &workdir() const {
         return workdir_;
     }
@@ -104,6 +127,29 @@ public:
         return KeyBase::valid(kwh.idx());
     }
 
+    //Computes indices of several keys at once. Index lookups are interleaved
+    //and value slots are prefetched, so that memory accesses of different keys overlap.
+    template<class KWHIt>
+    void ResolveKWHs(KWHIt begin, KWHIt end) const {
+        const size_t BatchSize = 16;
+        KeyType keys[BatchSize];
+        IdxType idx[BatchSize];
+
+        while (begin != end) {
+            KWHIt batch = begin;
+            size_t cnt = 0;
+            for (; cnt < BatchSize && begin != end; ++cnt, ++begin)
+                keys[cnt] = begin->hashed_key();
+
+            index_ptr_->seq_idx(keys, cnt, idx);
+            for (size_t i = 0; i < cnt; ++i, ++batch) {
+                if (KeyBase::valid(idx[i]))
+                    __builtin_prefetch(&ValueBase::operator[](idx[i]));
+                batch->set_idx(idx[i]);
+            }
+        }
+    }
+
     PerfectHashMap(size_t k, const std::string &workdir) : KeyBase(k, workdir) {
     }
 
@@ -85,7 +85,7 @@ size_t BuildIndexFromStream(Index &index,
     DeBruijnReadKMerSplitter<typename Streams::ReadT,
                              StoringTypeFilter<typename Index::storing_type>>
             splitter(index.workdir(), index.k(), 0, streams, contigs_stream);
-    KMerDiskCounter<RtSeq> counter(index.workdir(), splitter);
+    KMerMemoryCounter<RtSeq> counter(index.workdir(), splitter);
     BuildIndex(index, counter, 16, streams.size());
     return 0;
 }
@@ -17,12 +17,10 @@
 #include <vector>
 #include <cstring>
 
-bool Expander::operator()(std::unique_ptr<Read> r) {
+bool Expander::operator()(Read &r) {
   uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-  // FIXME: Get rid of this
-  Read cr = *r;
-  size_t sz = cr.trimNsAndBadQuality(trim_quality);
+  size_t sz = r.trimNsAndBadQuality(trim_quality);
 
   if (sz < hammer::K)
     return false;
@@ -30,7 +28,7 @@ bool Expander::operator()(std::unique_ptr<Read> r) {
   std::vector<unsigned> covered_by_solid(sz, false);
   std::vector<size_t> kmer_indices(sz, -1ull);
 
-  ValidKMerGenerator<hammer::K> gen(cr);
+  ValidKMerGenerator<hammer::K> gen(r);
   while (gen.HasMore()) {
     hammer::KMer kmer = gen.kmer();
     size_t idx = data_.checking_seq_idx(kmer);
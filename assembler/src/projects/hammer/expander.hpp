@@ -24,7 +24,7 @@ class Expander {
 
   size_t changed() const { return changed_; }
 
-  bool operator()(std::unique_ptr<Read> r);
+  bool operator()(Read &r);
 };
 
 #endif
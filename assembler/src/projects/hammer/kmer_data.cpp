@@ -60,17 +60,16 @@ class BufferFiller {
   BufferFiller(HammerFilteringKMerSplitter &splitter)
       : splitter_(splitter) {}
 
-  bool operator()(std::unique_ptr<Read> r) {
+  bool operator()(Read &r) {
     int trim_quality = cfg::get().input_trim_quality;
 
-    Read cr = *r;
-    size_t sz = cr.trimNsAndBadQuality(trim_quality);
+    size_t sz = r.trimNsAndBadQuality(trim_quality);
   
     if (sz < hammer::K)
       return false;
     
     unsigned thread_id = omp_get_thread_num();
-    ValidKMerGenerator<hammer::K> gen(cr);
+    ValidKMerGenerator<hammer::K> gen(r);
     bool stop = false;
     for (; gen.HasMore(); gen.Next()) {
       KMer seq = gen.kmer();
@@ -96,7 +95,8 @@ fs::files_t HammerFilteringKMerSplitter::Split(size_t num_files, unsigned nthrea
     INFO("Processing " << reads);
     ireadstream irs(reads, cfg::get().input_qvoffset);
     while (!irs.eof()) {
-      hammer::ReadProcessor rp(nthreads);
+      // Small batches, so few reads are processed after the buffers are full
+      hammer::ReadProcessor rp(nthreads, 32);
       rp.Run(irs, filler);
       DumpBuffers(out);
       VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
@@ -122,8 +122,7 @@ static inline void Merge(KMerStat &lhs, const KMerStat &rhs) {
 }
 
 static void PushKMer(KMerData &data,
-                     KMer kmer, const unsigned char *q, double prob) {
-  size_t idx = data.checking_seq_idx(kmer);
+                     size_t idx, const unsigned char *q, double prob) {
   if (idx == -1ULL)
       return;
   KMerStat &kmc = data[idx];
@@ -134,53 +133,57 @@ static void PushKMer(KMerData &data,
 }
 
 static void PushKMerRC(KMerData &data,
-                       KMer kmer, const unsigned char *q, double prob) {
+                       size_t idx, const unsigned char *q, double prob) {
   unsigned char rcq[K];
 
-  // Prepare RC kmer with quality.
-  kmer = !kmer;
+  // Prepare RC quality.
   for (unsigned i = 0; i < K; ++i)
     rcq[K - i - 1] = q[i];
 
-  size_t idx = data.checking_seq_idx(kmer);
-  if (idx == -1ULL)
-      return;
-  KMerStat &kmc = data[idx];
-  kmc.lock();
-  Merge(kmc,
-        KMerStat(1, (float)prob, rcq));
-  kmc.unlock();
+  PushKMer(data, idx, rcq, prob);
 }
 
 class KMerDataFiller {
   KMerData &data_;
 
+  struct KMerInstance {
+    const unsigned char *q;
+    double prob;
+  };
+
  public:
   KMerDataFiller(KMerData &data)
       : data_(data) {}
 
-  bool operator()(std::unique_ptr<Read> r) {
+  bool operator()(Read &r) {
     uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-    // FIXME: Get rid of this
-    Read cr = *r;
-    size_t sz = cr.trimNsAndBadQuality(trim_quality);
+    size_t sz = r.trimNsAndBadQuality(trim_quality);
 
     if (sz < hammer::K)
       return false;
 
-    ValidKMerGenerator<hammer::K> gen(cr);
-    const char *q = cr.getQualityString().data();
+    // Collect all the k-mers of the read first, so their lookups could be batched
+    std::vector<KMer> kmers;
+    std::vector<KMerInstance> instances;
+    ValidKMerGenerator<hammer::K> gen(r);
+    const char *q = r.getQualityString().data();
     while (gen.HasMore()) {
       KMer kmer = gen.kmer();
-      const unsigned char *kq = (const unsigned char*)(q + gen.pos() - 1);
-
-      PushKMer(data_, kmer, kq, 1 - gen.correct_probability());
-      PushKMerRC(data_, kmer, kq, 1 - gen.correct_probability());
+      kmers.push_back(kmer);
+      kmers.push_back(!kmer);
+      instances.push_back({ (const unsigned char*)(q + gen.pos() - 1), 1 - gen.correct_probability() });
 
       gen.Next();
     }
 
+    std::vector<size_t> idx(kmers.size());
+    data_.checking_seq_idx(kmers.data(), kmers.size(), idx.data());
+    for (size_t i = 0; i < instances.size(); ++i) {
+      PushKMer(data_, idx[2 * i], instances[i].q, instances[i].prob);
+      PushKMerRC(data_, idx[2 * i + 1], instances[i].q, instances[i].prob);
+    }
+
     return false;
   }
 };
@@ -195,17 +198,15 @@ class KMerMultiplicityCounter {
 
   ~KMerMultiplicityCounter() {}
 
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(Read &r) {
       uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-      // FIXME: Get rid of this
-      Read cr = *r;
-      size_t sz = cr.trimNsAndBadQuality(trim_quality);
+      size_t sz = r.trimNsAndBadQuality(trim_quality);
 
       if (sz < hammer::K)
         return false;
 
-      ValidKMerGenerator<hammer::K> gen(cr);
+      ValidKMerGenerator<hammer::K> gen(r);
       for (; gen.HasMore(); gen.Next()) {
           KMer kmer = gen.kmer();
 
@@ -233,17 +234,15 @@ class KMerCountEstimator {
 
   ~KMerCountEstimator() {}
 
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(Read &r) {
       uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-      // FIXME: Get rid of this
-      Read cr = *r;
-      size_t sz = cr.trimNsAndBadQuality(trim_quality);
+      size_t sz = r.trimNsAndBadQuality(trim_quality);
 
       if (sz < hammer::K)
         return false;
 
-      ValidKMerGenerator<hammer::K> gen(cr);
+      ValidKMerGenerator<hammer::K> gen(r);
       for (; gen.HasMore(); gen.Next()) {
           KMer kmer = gen.kmer();
           auto &hll = hll_[omp_get_thread_num()];
@@ -267,6 +266,24 @@ class KMerCountEstimator {
   }
 };
 
+// Runs the operation over all the input reads. The operation should never
+// request a stop, the files are read concurrently by several threads.
+template<class Op>
+static void ProcessAllReads(Op &op, unsigned nthreads) {
+  std::vector<std::unique_ptr<ireadstream>> streams;
+  std::vector<ireadstream*> readers;
+  for (const auto &reads : cfg::get().dataset.reads()) {
+    INFO("Processing " << reads);
+    streams.emplace_back(new ireadstream(reads, cfg::get().input_qvoffset));
+    readers.push_back(streams.back().get());
+  }
+
+  hammer::ReadProcessor rp(nthreads);
+  rp.RunMultiple(readers, op);
+  VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+  INFO("Total " << rp.processed() << " reads processed");
+}
+
 void KMerDataCounter::BuildKMerIndex(KMerData &data) {
   // Build the index
   std::string workdir = cfg::get().input_working_dir;
@@ -279,24 +296,8 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
       {
           INFO("Estimating k-mer count");
 
-          size_t n = 15, processed = 0;
           KMerCountEstimator mcounter(omp_get_max_threads());
-          for (const auto &reads : cfg::get().dataset.reads()) {
-              INFO("Processing " << reads);
-              ireadstream irs(reads, cfg::get().input_qvoffset);
-              while (!irs.eof()) {
-                  hammer::ReadProcessor rp(omp_get_max_threads());
-                  rp.Run(irs, mcounter);
-                  VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
-                  processed += rp.processed();
-
-                  if (processed >> n) {
-                      INFO("Processed " << processed << " reads");
-                      n += 1;
-                  }
-              }
-          }
-          INFO("Total " << processed << " reads processed");
+          ProcessAllReads(mcounter, omp_get_max_threads());
           mcounter.merge();
           std::pair<double, bool> res = mcounter.cardinality();
           if (res.second == false) {
@@ -311,24 +312,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
       INFO("Filtering singleton k-mers");
 
       KMerMultiplicityCounter mcounter(buffer_size);
-
-      size_t n = 15, processed = 0;
-      for (const auto &reads : cfg::get().dataset.reads()) {
-          INFO("Processing " << reads);
-          ireadstream irs(reads, cfg::get().input_qvoffset);
-          while (!irs.eof()) {
-              hammer::ReadProcessor rp(omp_get_max_threads());
-              rp.Run(irs, mcounter);
-              VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
-              processed += rp.processed();
-
-              if (processed >> n) {
-                  INFO("Processed " << processed << " reads");
-                  n += 1;
-              }
-          }
-      }
-      INFO("Total " << processed << " reads processed");
+      ProcessAllReads(mcounter, omp_get_max_threads());
 
       // FIXME: Reduce code duplication
       HammerFilteringKMerSplitter splitter(workdir,
@@ -380,14 +364,7 @@ void KMerDataCounter::FillKMerData(KMerData &data) {
   data.data_.resize(data.kmers_.size());
 
   KMerDataFiller filler(data);
-  const auto& dataset = cfg::get().dataset;
-  for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
-    INFO("Processing " << *I);
-    ireadstream irs(*I, cfg::get().input_qvoffset);
-    hammer::ReadProcessor rp(omp_get_max_threads());
-    rp.Run(irs, filler);
-    VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
-  }
+  ProcessAllReads(filler, omp_get_max_threads());
 
   INFO("Collection done, postprocessing.");
 
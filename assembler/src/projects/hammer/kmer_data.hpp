@@ -73,6 +73,21 @@ class KMerData {
     return (s == kmer(idx) ? idx : -1ULL);
   }
 
+  // Batched checking_seq_idx(): index lookups are interleaved and the stored
+  // k-mers and stats are prefetched before being accessed
+  void checking_seq_idx(const hammer::KMer *s, size_t n, size_t *idx) const {
+    index_.seq_idx(s, n, idx);
+    for (size_t i = 0; i < n; ++i) {
+      if (idx[i] < kmers_.size())
+        __builtin_prefetch(kmers_.data() + idx[i] * hammer::KMer::GetDataSize(hammer::K));
+      if (idx[i] < data_.size())
+        __builtin_prefetch(&data_[idx[i]]);
+    }
+    for (size_t i = 0; i < n; ++i)
+      if (idx[i] >= size() || s[i] != kmer(idx[i]))
+        idx[i] = -1ULL;
+  }
+
   KMerStat& operator[](hammer::KMer s) { return operator[](seq_idx(s)); }
   const KMerStat& operator[](hammer::KMer s) const { return operator[](seq_idx(s)); }
   size_t seq_idx(hammer::KMer s) const { return index_.seq_idx(s); }
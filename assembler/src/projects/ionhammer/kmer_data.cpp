@@ -41,8 +41,8 @@ class BufferFiller {
 
   size_t processed() const { return processed_; }
 
-  bool operator()(std::unique_ptr<io::SingleRead> r) {
-    ValidHKMerGenerator<hammer::K> gen(*r);
+  bool operator()(const io::SingleRead &r) {
+    ValidHKMerGenerator<hammer::K> gen(r);
     unsigned thread_id = omp_get_thread_num();
 
 #pragma omp atomic
@@ -72,7 +72,8 @@ fs::files_t HammerKMerSplitter::Split(size_t num_files, unsigned nthreads) {
   for (const auto &reads : cfg::get().dataset.reads()) {
     INFO("Processing " << reads);
     io::FileReadStream irs(reads, io::PhredOffset);
-    hammer::ReadProcessor rp(nthreads);
+    // Small batches, so few reads are processed after the buffers are full
+    hammer::ReadProcessor rp(nthreads, 32);
     while (!irs.eof()) {
       rp.Run(irs, filler);
       DumpBuffers(out);
@@ -98,17 +99,13 @@ static inline void Merge(KMerStat &lhs, const KMerStat &rhs) {
   lhs.qual += rhs.qual;
 }
 
-static void PushKMer(KMerData &data, HKMer kmer, double qual) {
-  KMerStat &kmc = data[kmer];
+static void PushKMer(KMerData &data, size_t idx, HKMer kmer, double qual) {
+  KMerStat &kmc = data[idx];
   kmc.lock();
   Merge(kmc, KMerStat(1, kmer, (float)qual));
   kmc.unlock();
 }
 
-static void PushKMerRC(KMerData &data, HKMer kmer, double qual) {
-  PushKMer(data, !kmer, qual);
-}
-
 class KMerDataFiller {
   KMerData &Data;
   mutable std::default_random_engine RandomEngine;
@@ -128,8 +125,8 @@ class KMerDataFiller {
     return UniformRandGenerator(RandomEngine);
   }
 
-  bool operator()(std::unique_ptr<io::SingleRead> &&r) const {
-    ValidHKMerGenerator<hammer::K> gen(*r);
+  bool operator()(const io::SingleRead &r) const {
+    ValidHKMerGenerator<hammer::K> gen(r);
 
     // tiny quality regularization
     const double decay = 0.9999;
@@ -141,6 +138,9 @@ class KMerDataFiller {
       return false;
     }
 
+    // Collect all the k-mers of the read first, so their lookups could be batched
+    std::vector<HKMer> kmers;
+    std::vector<double> quals;
     while (gen.HasMore()) {
       const HKMer kmer = gen.kmer();
       const double p = gen.correct_probability();
@@ -151,12 +151,15 @@ class KMerDataFiller {
       const double correct = p * prior;
 
       prior *= decay;
-      {
-        PushKMer(Data, kmer, log(1 - correct));
-
-        PushKMerRC(Data, kmer, log(1 - correct));
-      }
+      kmers.push_back(kmer);
+      kmers.push_back(!kmer);
+      quals.push_back(log(1 - correct));
     }
+
+    std::vector<size_t> idx(kmers.size());
+    Data.seq_idx(kmers.data(), kmers.size(), idx.data());
+    for (size_t i = 0; i < kmers.size(); ++i)
+      PushKMer(Data, idx[i], kmers[i], quals[i / 2]);
     // Do not stop
     return false;
   }
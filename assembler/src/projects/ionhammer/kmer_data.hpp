@@ -99,6 +99,14 @@ class KMerData {
     return (s == operator[](idx).kmer ? idx : -1ULL);
   }
 
+  // Batched seq_idx(): index lookups are interleaved and stats are prefetched
+  void seq_idx(const hammer::HKMer *s, size_t n, size_t *idx) const {
+    index_.seq_idx(s, n, idx);
+    for (size_t i = 0; i < n; ++i)
+      if (idx[i] < data_.size())
+        __builtin_prefetch(&data_[idx[i]]);
+  }
+
   template <class Writer>
   void binary_write(Writer& os) {
     size_t sz = data_.size();
@@ -54,11 +54,11 @@ class ParallelSortingSplitter : public utils::KMerSortingSplitter<RtSeq> {
 
       size_t processed() const { return processed_; }
 
-      bool operator()(std::unique_ptr<io::SingleRead> r) {
+      bool operator()(const io::SingleRead &r) {
 #         pragma omp atomic
           processed_ += 1;
 
-          const Sequence &seq = r->sequence();
+          const Sequence &seq = r.sequence();
 
           if (seq.size() < this->K_)
               return false;
@@ -93,7 +93,8 @@ class ParallelSortingSplitter : public utils::KMerSortingSplitter<RtSeq> {
             INFO("Processing " << file);
             auto irs = io::EasyStream(file, true, true);
             while (!irs->eof()) {
-                hammer::ReadProcessor rp(nthreads);
+                // Small batches, so few reads are processed after the buffers are full
+                hammer::ReadProcessor rp(nthreads, 32);
                 rp.Run(*irs, filler);
                 DumpBuffers(out);
                 VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
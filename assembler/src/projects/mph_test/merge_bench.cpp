@@ -0,0 +1,124 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Bucket merge throughput benchmark: generates sorted runs of random k-mers
+// in the same layout as KMerSortingSplitter does and times their merging.
+
+#include "utils/logger/log_writers.hpp"
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+#include "io/kmers/buffered_writer.hpp"
+
+#include <cxxopts/cxxopts.hpp>
+
+#include <random>
+#include <string>
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+class SyntheticRunsSplitter : public utils::KMerSplitter<RtSeq> {
+    size_t kmers_per_file_;
+    size_t runs_per_file_;
+    double split_time_;
+
+public:
+    SyntheticRunsSplitter(const std::string &workdir, unsigned K,
+                          size_t kmers_per_file, size_t runs_per_file)
+            : utils::KMerSplitter<RtSeq>(workdir, K),
+              kmers_per_file_(kmers_per_file), runs_per_file_(runs_per_file), split_time_(0) {}
+
+    fs::files_t Split(size_t num_files, unsigned nthreads) override {
+        utils::perf_counter pc;
+
+        fs::files_t out;
+        for (unsigned i = 0; i < num_files; ++i)
+            out.push_back(fs::append_path(this->work_dir_, "kmers.raw." + std::to_string(i)));
+
+        size_t run_size = kmers_per_file_ / runs_per_file_;
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (unsigned i = 0; i < num_files; ++i) {
+            std::mt19937_64 rng(i);
+            BufferedRecordArrayWriter<RtSeq::DataType> os(out[i], RtSeq::GetDataSize(K()));
+            BufferedRecordArrayWriter<size_t> idx(out[i] + ".idx");
+
+            adt::KMerVector<RtSeq> run(K(), run_size);
+            for (size_t r = 0; r < runs_per_file_; ++r) {
+                run.clear();
+                for (size_t j = 0; j < run_size; ++j) {
+                    RtSeq kmer(K());
+                    for (unsigned pos = 0; pos < K(); ++pos)
+                        kmer <<= char(rng() % 4);
+                    run.push_back(kmer);
+                }
+                libcxx::sort(run.begin(), run.end(), adt::KMerVector<RtSeq>::less2_fast());
+                size_t cnt = std::unique(run.begin(), run.end(), adt::KMerVector<RtSeq>::equal_to()) - run.begin();
+
+                os.write(run.data(), cnt);
+                idx.write(&cnt, 1);
+            }
+        }
+
+        split_time_ = pc.time();
+        return out;
+    }
+
+    double split_time() const { return split_time_; }
+};
+
+int main(int argc, char* argv[]) {
+    try {
+        unsigned nthreads, K, num_buckets;
+        size_t kmers_per_file, runs_per_file;
+        std::string workdir;
+
+        cxxopts::Options options(argv[0], " - SPAdes k-mer bucket merge benchmark");
+        options.add_options()
+                ("k,kmer", "K-mer length", cxxopts::value<unsigned>(K)->default_value("21"), "K")
+                ("t,threads", "# of threads to use", cxxopts::value<unsigned>(nthreads)->default_value(std::to_string(omp_get_max_threads())), "num")
+                ("w,workdir", "Working directory to use", cxxopts::value<std::string>(workdir)->default_value("."), "dir")
+                ("b,buckets", "# of buckets", cxxopts::value<unsigned>(num_buckets)->default_value("16"), "num")
+                ("n,kmers", "# of k-mers per raw file", cxxopts::value<size_t>(kmers_per_file)->default_value("4194304"), "num")
+                ("r,runs", "# of sorted runs per raw file", cxxopts::value<size_t>(runs_per_file)->default_value("16"), "num")
+                ("h,help", "Print help");
+
+        options.parse(argc, argv);
+        if (options.count("help")) {
+            std::cout << options.help() << std::endl;
+            exit(0);
+        }
+
+        create_console_logger();
+
+        SyntheticRunsSplitter splitter(workdir, K, kmers_per_file, runs_per_file);
+        utils::KMerDiskCounter<RtSeq> counter(workdir, splitter);
+
+        utils::perf_counter pc;
+        size_t kmers = counter.Count(num_buckets, nthreads);
+        double merge_time = pc.time() - splitter.split_time();
+
+        size_t bytes = kmers * counter.kmer_size();
+        INFO("Runs generated in " << splitter.split_time() << " s");
+        INFO("Merged " << kmers << " unique k-mers in " << merge_time << " s, "
+             << (double)bytes / 1024.0 / 1024.0 / merge_time << " Mb/s");
+
+        pc.reset();
+        counter.MergeBuckets(num_buckets);
+        INFO("Final buckets merged in " << pc.time() << " s, "
+             << (double)bytes / 1024.0 / 1024.0 / pc.time() << " Mb/s");
+        // Final k-mers file is unlinked on storage destruction
+        counter.GetFinalKMers();
+    } catch (const cxxopts::OptionException &e) {
+        std::cerr << "error parsing options: " << e.what() << std::endl;
+        exit(1);
+    }
+
+    return 0;
+}
@@ -158,7 +158,7 @@ namespace online_visualization {
             " For example:\n" +
             "> load GraphSimplified data/saves/simplification\n" +
             " would load a new environment with the name `GraphSimplified` from the files\n" +
-            " in the folder `data/saves/` with the basename `simplification` (simplification.grp, simplification.sqn, e.t.c).";
+            " in the folder `data/saves/` with the basename `simplification` (simplification.grb, simplification.kmmph, e.t.c).";
           return answer;
         }
 
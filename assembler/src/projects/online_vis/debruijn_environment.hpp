@@ -60,9 +60,7 @@ class DebruijnEnvironment : public Environment {
         }
 
         inline bool IsCorrect() const {
-            if (!CheckFileExists(path_ + ".grp"))
-                return false;
-            if (!CheckFileExists(path_ + ".sqn"))
+            if (!debruijn_graph::graphio::GraphSavesExist(path_))
                 return false;
 
             size_t K = gp_.k_value;
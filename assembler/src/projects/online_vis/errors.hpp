@@ -8,6 +8,7 @@
 #pragma once
 
 #include "vis_utils.hpp"
+#include "pipeline/graphio.hpp"
 
 namespace online_visualization {
 
@@ -80,9 +81,7 @@ namespace online_visualization {
   }
 
   bool CheckEnvIsCorrect(string path, size_t K) {
-    if (!CheckFileExists(path + ".grp"))
-      return false;
-    if (!CheckFileExists(path + ".sqn"))
+    if (!debruijn_graph::graphio::GraphSavesExist(path))
       return false;
 
     if (!(K >= runtime_k::MIN_K && cfg::get().K < runtime_k::MAX_K)) {
@@ -98,6 +98,7 @@ void RefinePairedInfo(const Graph& graph, PairedInfoIndexT<Graph>& clustered_ind
 }
 
 void estimate_distance(conj_graph_pack& gp,
+                       const GraphDistanceFinder::FrozenGraphT &frozen_graph,
                        const io::SequencingLibrary<config::DataSetData> &lib,
                        const UnclusteredPairedIndexT& paired_index,
                        PairedIndexT& clustered_index,
@@ -107,7 +108,7 @@ void estimate_distance(conj_graph_pack& gp,
     const config::debruijn_config& config = cfg::get();
     size_t delta = size_t(lib.data().insert_size_deviation);
     size_t linkage_distance = size_t(config.de.linkage_distance_coeff * lib.data().insert_size_deviation);
-    GraphDistanceFinder dist_finder(gp.g,  (size_t)math::round(lib.data().mean_insert_size), lib.data().read_length, delta);
+    GraphDistanceFinder dist_finder(frozen_graph, (size_t)math::round(lib.data().mean_insert_size), lib.data().read_length, delta);
     size_t max_distance = size_t(config.de.max_distance_coeff * lib.data().insert_size_deviation);
 
     std::function<double(int)> weight_function;
@@ -185,7 +186,7 @@ void estimate_distance(conj_graph_pack& gp,
         double is_var = lib.data().insert_size_deviation;
         size_t delta = size_t(is_var);
         size_t linkage_distance = size_t(cfg::get().de.linkage_distance_coeff * is_var);
-        GraphDistanceFinder dist_finder(gp.g, (size_t) math::round(lib.data().mean_insert_size),
+        GraphDistanceFinder dist_finder(frozen_graph, (size_t) math::round(lib.data().mean_insert_size),
                                                lib.data().read_length, delta);
         size_t max_distance = size_t(cfg::get().de.max_distance_coeff_scaff * is_var);
         std::function<double(int)> weight_function;
@@ -218,11 +219,13 @@ void estimate_distance(conj_graph_pack& gp,
 }
 
 void DistanceEstimation::run(conj_graph_pack &gp, const char*) {
+    // The graph is not modified here, so the path searches could use the frozen snapshot
+    GraphDistanceFinder::FrozenGraphT frozen_graph(gp.g);
     for (size_t i = 0; i < cfg::get().ds.reads.lib_count(); ++i)
         if (cfg::get().ds.reads[i].type() == io::LibraryType::PairedEnd) {
             if (cfg::get().ds.reads[i].data().mean_insert_size != 0.0) {
                 INFO("Processing library #" << i);
-                estimate_distance(gp, cfg::get().ds.reads[i], gp.paired_indices[i], gp.clustered_indices[i], gp.scaffolding_indices[i]);
+                estimate_distance(gp, frozen_graph, cfg::get().ds.reads[i], gp.paired_indices[i], gp.clustered_indices[i], gp.scaffolding_indices[i]);
             }
             if (!cfg::get().preserve_raw_paired_index) {
                 INFO("Clearing raw paired index");
@@ -408,7 +408,10 @@ void CloseGaps(conj_graph_pack &gp, Streams &streams) {
     gcpif.FillIndex(tips_paired_idx, streams);
     GapCloser gap_closer(gp.g, tips_paired_idx,
                          cfg::get().gc.minimal_intersection, cfg::get().gc.weight_threshold);
+    // The index is not queried while the gaps are closed
+    gp.index.SetBatched(true);
     gap_closer.CloseShortGaps();
+    gp.index.SetBatched(false);
 }
 
 void GapClosing::run(conj_graph_pack &gp, const char *) {
@@ -23,6 +23,7 @@
 namespace debruijn_graph {
 
 typedef io::SequencingLibrary<config::DataSetData> SequencingLib;
+typedef SequenceMapperNotifier::MappingPathCacheT MappingPathCacheT;
 using PairedInfoFilter = bf::counting_bloom_filter<std::pair<EdgeId, EdgeId>, 2>;
 using EdgePairCounter = hll::hll<std::pair<EdgeId, EdgeId>>;
 
@@ -172,7 +173,8 @@ static bool ShouldObtainSingleReadsPaths(size_t ilib) {
 
 static bool CollectLibInformation(const conj_graph_pack &gp,
                                   size_t &edgepairs,
-                                  size_t ilib, size_t edge_length_threshold) {
+                                  size_t ilib, size_t edge_length_threshold,
+                                  MappingPathCacheT *cache) {
     INFO("Estimating insert size (takes a while)");
     InsertSizeCounter hist_counter(gp, edge_length_threshold);
     EdgePairCounterFiller pcounter(cfg::get().max_threads);
@@ -180,6 +182,7 @@ static bool CollectLibInformation(const conj_graph_pack &gp,
     SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
     notifier.Subscribe(ilib, &hist_counter);
     notifier.Subscribe(ilib, &pcounter);
+    notifier.UseCache(ilib, cache);
 
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     auto &data = reads.data();
@@ -256,7 +259,7 @@ static void ProcessSingleReads(conj_graph_pack &gp,
 
 static void ProcessPairedReads(conj_graph_pack &gp,
                                std::unique_ptr<PairedInfoFilter> filter, unsigned filter_threshold,
-                               size_t ilib) {
+                               size_t ilib, MappingPathCacheT *cache) {
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     const auto &data = reads.data();
 
@@ -302,6 +305,7 @@ static void ProcessPairedReads(conj_graph_pack &gp,
                               weight, round_thr,
                               gp.paired_indices[ilib]);
     notifier.Subscribe(ilib, &pif);
+    notifier.UseCache(ilib, cache);
 
     auto paired_streams = paired_binary_readers(reads, false, (size_t) data.mean_insert_size);
     notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads, cfg::get().bwa.bwa_enable));
@@ -330,8 +334,13 @@ void PairInfoCount::run(conj_graph_pack &gp, const char *) {
                 size_t rl = lib_data.read_length;
                 size_t k = cfg::get().K;
 
+                //Paired reads are mapped up to three times below, record paths once and replay them later
+                std::unique_ptr<MappingPathCacheT> cache;
+                if (cfg::get().cache_mapping_paths)
+                    cache.reset(new MappingPathCacheT(gp.g, cfg::get().tmp_dir));
+
                 size_t edgepairs = 0;
-                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold)) {
+                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold, cache.get())) {
                     cfg::get_writable().ds.reads[i].data().mean_insert_size = 0.0;
                     WARN("Unable to estimate insert size for paired library #" << i);
                     if (rl > 0 && rl <= k) {
@@ -370,6 +379,7 @@ void PairInfoCount::run(conj_graph_pack &gp, const char *) {
                         SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
                         DEFilter filter_counter(*filter, gp.g);
                         notifier.Subscribe(i, &filter_counter);
+                        notifier.UseCache(i, cache.get());
 
                         auto reads = paired_binary_readers(lib, false);
                         VERIFY(lib.data().read_length != 0);
@@ -380,7 +390,7 @@ void PairInfoCount::run(conj_graph_pack &gp, const char *) {
                 INFO("Mapping library #" << i);
                 if (lib.data().mean_insert_size != 0.0) {
                     INFO("Mapping paired reads (takes a while) ");
-                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i);
+                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i, cache.get());
                 }
             }
 
@@ -0,0 +1,120 @@
+//***************************************************************************
+//* Copyright (c) 2016 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+#include <boost/test/unit_test.hpp>
+#include "io/reads/binary_converter.hpp"
+#include "io/reads/binary_streams.hpp"
+#include "io/reads/vector_reader.hpp"
+
+#include <random>
+
+namespace debruijn_graph {
+
+BOOST_FIXTURE_TEST_SUITE(binary_reads_tests, fs::TmpFolderFixture)
+
+std::string RandomNucls(std::mt19937 &rand, size_t len) {
+    std::string s(len, 'A');
+    for (auto &c : s)
+        c = nucl(char(rand() % 4));
+    return s;
+}
+
+io::SingleRead RandomRead(std::mt19937 &rand, size_t id) {
+    // Both short reads and reads spanning several blocks
+    size_t len = (id % 50 == 0) ? 600 + rand() % 200 : 1 + rand() % 150;
+    return io::SingleRead("r" + std::to_string(id), RandomNucls(rand, len),
+                          io::SequenceOffsetT(rand() % 10), io::SequenceOffsetT(rand() % 10));
+}
+
+// Reads all parts concurrently, concatenating them in part order gives the original stream
+template<class Stream, class ReadT, class... Args>
+std::vector<ReadT> ReadInParts(size_t part_num, io::ReadStreamStat &stat, Args... args) {
+    std::vector<std::vector<ReadT>> parts(part_num);
+    std::vector<io::ReadStreamStat> stats(part_num);
+#   pragma omp parallel for num_threads(4) schedule(dynamic, 1)
+    for (size_t i = 0; i < part_num; ++i) {
+        Stream stream(args..., i, part_num);
+        VERIFY(stream.is_open());
+        stats[i] = stream.get_stat();
+        ReadT r;
+        while (!stream.eof()) {
+            stream >> r;
+            parts[i].push_back(r);
+        }
+        VERIFY(parts[i].size() == stream.size());
+    }
+
+    std::vector<ReadT> res;
+    for (size_t i = 0; i < part_num; ++i) {
+        stat.merge(stats[i]);
+        res.insert(res.end(), parts[i].begin(), parts[i].end());
+    }
+    return res;
+}
+
+void CheckRead(const io::SingleRead &expected, const io::SingleReadSeq &r, bool rc = false) {
+    BOOST_CHECK_EQUAL(r.sequence(), rc ? !expected.sequence() : expected.sequence());
+    BOOST_CHECK_EQUAL(r.GetLeftOffset(), rc ? expected.GetRightOffset() : expected.GetLeftOffset());
+    BOOST_CHECK_EQUAL(r.GetRightOffset(), rc ? expected.GetLeftOffset() : expected.GetRightOffset());
+}
+
+BOOST_AUTO_TEST_CASE( BinarySingleReadsInParts ) {
+    std::mt19937 rand(42);
+    std::vector<io::SingleRead> reads;
+    size_t total_len = 0, max_len = 0;
+    for (size_t i = 0; i < 3000; ++i) {
+        reads.push_back(RandomRead(rand, i));
+        total_len += reads.back().size();
+        max_len = std::max(max_len, reads.back().size());
+    }
+
+    io::VectorReadStream<io::SingleRead> stream(reads);
+    // Small blocks, so that there are many of them
+    io::ReadStreamStat written = io::BinaryWriter("tmp/single", 1 << 10).ToBinary(stream);
+    BOOST_CHECK_EQUAL(written.read_count_, reads.size());
+
+    for (size_t part_num : { 1, 3, 8, 1000 }) {
+        io::ReadStreamStat stat;
+        auto result = ReadInParts<io::BinaryFileSingleStream, io::SingleReadSeq>(part_num, stat, std::string("tmp/single"));
+        BOOST_REQUIRE_EQUAL(result.size(), reads.size());
+        for (size_t i = 0; i < reads.size(); ++i)
+            CheckRead(reads[i], result[i]);
+        BOOST_CHECK_EQUAL(stat.read_count_, reads.size());
+        BOOST_CHECK_EQUAL(stat.total_len_, total_len);
+        BOOST_CHECK_EQUAL(stat.max_len_, max_len);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( BinaryPairedReadsInParts ) {
+    std::mt19937 rand(239);
+    const size_t insert_size = 1000;
+    std::vector<io::PairedRead> reads;
+    for (size_t i = 0; i < 2000; ++i)
+        reads.emplace_back(RandomRead(rand, 2 * i), RandomRead(rand, 2 * i + 1), insert_size);
+
+    io::VectorReadStream<io::PairedRead> stream(reads);
+    io::BinaryWriter("tmp/paired", 1 << 10).ToBinary(stream, io::LibraryOrientation::FR);
+
+    for (size_t part_num : { 1, 5, 16 }) {
+        io::ReadStreamStat stat;
+        auto result = ReadInParts<io::BinaryFilePairedStream, io::PairedReadSeq>(part_num, stat,
+                                                                                 std::string("tmp/paired"), insert_size);
+        BOOST_REQUIRE_EQUAL(result.size(), reads.size());
+        for (size_t i = 0; i < reads.size(); ++i) {
+            // FR libraries are stored with the second read reverse complemented
+            CheckRead(reads[i].first(), result[i].first());
+            CheckRead(reads[i].second(), result[i].second(), true);
+            BOOST_CHECK_EQUAL(result[i].insert_size(),
+                              insert_size - reads[i].first().GetLeftOffset() - reads[i].second().GetLeftOffset());
+        }
+        BOOST_CHECK_EQUAL(stat.read_count_, 2 * reads.size());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
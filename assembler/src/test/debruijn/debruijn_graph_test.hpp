@@ -10,6 +10,11 @@
 #include <boost/test/unit_test.hpp>
 
 #include "test_utils.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+#include "utils/ph_map/storing_traits.hpp"
+
+#include <random>
 
 namespace debruijn_graph {
 
@@ -170,6 +175,54 @@ BOOST_AUTO_TEST_CASE( TestKmerFreeIndex ) {
     CheckIndex<conj_graph_pack>(reads, 5);
 }
 
+std::vector<std::string> SplitKMers(const vector<string>& reads, unsigned K, bool use_superkmers) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(make_shared<RawStream>(MakeReads(reads))));
+    // The splitter keeps a reference to the working directory
+    const std::string work_dir = "tmp";
+    // Small buffers, so that they are dumped several times
+    utils::DeBruijnReadKMerSplitter<io::SingleRead, utils::StoringTypeFilter<utils::SimpleStoring>>
+            splitter(work_dir, K, 0, streams, nullptr, 1 << 16, use_superkmers);
+    utils::KMerDiskCounter<RtSeq> counter(work_dir, splitter);
+    size_t cnt = counter.CountAll(4, 2);
+
+    std::vector<std::string> kmers;
+    auto storage = counter.GetFinalKMers();
+    for (auto it = storage->begin(); it != storage->end(); ++it)
+        kmers.push_back(utils::kmer_index_traits<RtSeq>::raw_create()(K, *it).str());
+    BOOST_CHECK_EQUAL(cnt, kmers.size());
+    std::sort(kmers.begin(), kmers.end());
+    return kmers;
+}
+
+BOOST_AUTO_TEST_CASE( TestSuperKMerSplitting ) {
+    const unsigned K = 56;
+    std::mt19937 rand(11);
+    vector<string> reads;
+    for (size_t i = 0; i < 2000; ++i) {
+        string read(40 + rand() % 110, 'A');
+        for (auto &c : read)
+            c = nucl(char(rand() % 4));
+        reads.push_back(read);
+        // Duplicated k-mers
+        if (i % 3 == 0)
+            reads.push_back(read.substr(read.size() / 3));
+    }
+
+    std::set<std::string> expected;
+    for (const string &read : reads) {
+        string rc = ReverseComplement(read);
+        for (size_t i = 0; i + K <= read.size(); ++i) {
+            expected.insert(read.substr(i, K));
+            expected.insert(rc.substr(i, K));
+        }
+    }
+
+    auto plain = SplitKMers(reads, K, false);
+    BOOST_CHECK(plain == std::vector<std::string>(expected.begin(), expected.end()));
+    BOOST_CHECK(SplitKMers(reads, K, true) == plain);
+}
+
 //BOOST_AUTO_TEST_CASE( TestStrange ) {
 //    vector<string> reads = {"TTCTGCATGGTTATGCATAACCATGCAGAA", "ACACACACTGGGGGTCCCTTTTGGGGGGGGTTTTTTTTG"};
 //    typedef VectorStream<SingleRead> RawStream;
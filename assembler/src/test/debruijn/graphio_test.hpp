@@ -0,0 +1,197 @@
+//***************************************************************************
+//* Copyright (c) 2015 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+#include <boost/test/unit_test.hpp>
+#include "test_utils.hpp"
+#include "pipeline/graphio.hpp"
+
+#include <random>
+#include <set>
+#include <tuple>
+
+namespace debruijn_graph {
+
+BOOST_FIXTURE_TEST_SUITE(graphio_tests, fs::TmpFolderFixture)
+
+void CheckGraphsEqual(const Graph &g1, const Graph &g2) {
+    BOOST_CHECK_EQUAL(g1.size(), g2.size());
+    std::map<size_t, EdgeId> edges2;
+    for (auto it = g2.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges2[g2.int_id(*it)] = *it;
+
+    size_t edge_cnt = 0;
+    for (auto it = g1.ConstEdgeBegin(); !it.IsEnd(); ++it, ++edge_cnt) {
+        EdgeId e1 = *it;
+        auto e2_it = edges2.find(g1.int_id(e1));
+        BOOST_REQUIRE(e2_it != edges2.end());
+        EdgeId e2 = e2_it->second;
+        BOOST_CHECK_EQUAL(g1.EdgeNucls(e1), g2.EdgeNucls(e2));
+        BOOST_CHECK_EQUAL(g1.int_id(g1.EdgeStart(e1)), g2.int_id(g2.EdgeStart(e2)));
+        BOOST_CHECK_EQUAL(g1.int_id(g1.EdgeEnd(e1)), g2.int_id(g2.EdgeEnd(e2)));
+        BOOST_CHECK_EQUAL(g1.int_id(g1.conjugate(e1)), g2.int_id(g2.conjugate(e2)));
+        BOOST_CHECK_EQUAL(g1.coverage_index().RawCoverage(e1), g2.coverage_index().RawCoverage(e2));
+    }
+    BOOST_CHECK_EQUAL(edge_cnt, edges2.size());
+}
+
+BOOST_AUTO_TEST_CASE( CheckpointRoundTrip ) {
+    for (const char *path : { "./src/test/debruijn/graph_fragments/topology_ec/self_comp",
+                              "./src/test/debruijn/graph_fragments/complex_bulge/complex_bulge" }) {
+        Graph g(55);
+        graphio::ScanBasicGraph(path, g);
+        graphio::ConjugateDataPrinter<Graph> printer(g);
+        graphio::PrintBasicGraph("tmp/checkpoint", printer);
+        BOOST_CHECK(!fs::FileExists("tmp/checkpoint.grp"));
+
+        Graph loaded(55);
+        graphio::ScanBasicGraph("tmp/checkpoint", loaded);
+        CheckGraphsEqual(g, loaded);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( CheckpointAgreesWithTextSaves ) {
+    conj_graph_pack gp(55, "tmp", 0);
+    graphio::ScanGraphPack("./src/test/debruijn/graph_fragments/complex_bulge/complex_bulge", gp);
+
+    graphio::PrintAll("tmp/binary", gp);
+    graphio::PrintAll("tmp/text", gp, /*text_export*/ true);
+    //Force the text saves to be read back
+    for (const char *ext : { ".grb", ".flcvrb", ".posb" })
+        std::remove(("tmp/text" + std::string(ext)).c_str());
+
+    conj_graph_pack binary_gp(55, "tmp", 0), text_gp(55, "tmp", 0);
+    graphio::ScanAll("tmp/binary", binary_gp);
+    graphio::ScanAll("tmp/text", text_gp);
+    CheckGraphsEqual(gp.g, binary_gp.g);
+    CheckGraphsEqual(text_gp.g, binary_gp.g);
+
+    std::map<size_t, EdgeId> text_edges;
+    for (auto it = text_gp.g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        text_edges[text_gp.g.int_id(*it)] = *it;
+    for (auto it = binary_gp.g.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        EdgeId e = *it, text_e = text_edges[binary_gp.g.int_id(e)];
+        BOOST_CHECK_EQUAL(binary_gp.flanking_cov.RawCoverage(e), text_gp.flanking_cov.RawCoverage(text_e));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( MappedEdgeIndexAgreesWithInMemory ) {
+    const std::string graph_path = "./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation";
+    conj_graph_pack gp(55, "tmp", 0);
+    graphio::ScanBasicGraph(graph_path, gp.g);
+    gp.index.Refill();
+    gp.index.Attach();
+    graphio::SaveEdgeIndex("tmp/index", gp.index.inner_index());
+    BOOST_CHECK(fs::FileExists("tmp/index.kmmph"));
+
+    conj_graph_pack mapped_gp(55, "tmp", 0);
+    graphio::ScanBasicGraph(graph_path, mapped_gp.g);
+    BOOST_REQUIRE(graphio::LoadMappedEdgeIndex("tmp/index", mapped_gp.index.inner_index()));
+    mapped_gp.index.Update();
+    mapped_gp.index.Attach();
+    BOOST_CHECK_EQUAL(mapped_gp.index.inner_index().size(), gp.index.inner_index().size());
+
+    std::map<size_t, EdgeId> mapped_edges;
+    for (auto it = mapped_gp.g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        mapped_edges[mapped_gp.g.int_id(*it)] = *it;
+
+    std::mt19937 rand(17);
+    std::vector<RtSeq> kmers;
+    size_t found = 0;
+    for (auto it = gp.g.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        const Sequence &nucls = gp.g.EdgeNucls(*it);
+        RtSeq kmer(gp.index.k(), nucls);
+        for (size_t i = gp.index.k(); ; ++i) {
+            kmers.push_back(kmer);
+            //Random k-mers are most likely absent in both
+            RtSeq other = kmer;
+            other <<= char(rand() % 4);
+            kmers.push_back(other);
+            if (i == nucls.size())
+                break;
+            kmer <<= nucls[i];
+        }
+    }
+
+    std::vector<std::pair<EdgeId, size_t>> mapped_positions;
+    mapped_gp.index.get(kmers, mapped_positions);
+    BOOST_REQUIRE_EQUAL(mapped_positions.size(), kmers.size());
+    for (size_t i = 0; i < kmers.size(); ++i) {
+        bool contains = gp.index.contains(kmers[i]);
+        BOOST_REQUIRE_EQUAL(mapped_gp.index.contains(kmers[i]), contains);
+        if (!contains)
+            continue;
+        ++found;
+        auto pos = gp.index.get(kmers[i]), mapped_pos = mapped_gp.index.get(kmers[i]);
+        BOOST_CHECK_EQUAL(mapped_gp.g.int_id(mapped_pos.first), gp.g.int_id(pos.first));
+        BOOST_CHECK_EQUAL(mapped_pos.second, pos.second);
+        BOOST_CHECK(mapped_edges[gp.g.int_id(pos.first)] == mapped_pos.first);
+        BOOST_CHECK(mapped_positions[i] == mapped_pos);
+    }
+    BOOST_CHECK(found > kmers.size() / 3);
+}
+
+//The text format rounds the weights between conjugate edges, they could be skipped
+template<class Index>
+std::set<std::tuple<size_t, size_t, float, float>> PairedInfoByIds(const Graph &g, const Index &index,
+                                                                   bool skip_conjugate = false) {
+    std::set<std::tuple<size_t, size_t, float, float>> res;
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        for (auto entry : index.GetHalf(*it)) {
+            if (skip_conjugate && entry.first == g.conjugate(*it))
+                continue;
+            for (auto point : entry.second)
+                res.insert(std::make_tuple(g.int_id(*it), g.int_id(entry.first), float(point.d), float(point.weight)));
+        }
+    return res;
+}
+
+BOOST_AUTO_TEST_CASE( BinaryPairedInfoAgreesWithText ) {
+    conj_graph_pack gp(55, "tmp", 1);
+    graphio::ScanGraphPack("./src/test/debruijn/graph_fragments/complex_bulge/complex_bulge", gp);
+
+    std::vector<EdgeId> edges;
+    for (auto it = gp.g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+    std::mt19937 rand(57);
+    omnigraph::de::UnclusteredPairedInfoIndexT<Graph> raw(gp.g);
+    for (size_t i = 0; i < 500; ++i) {
+        EdgeId e1 = edges[rand() % edges.size()];
+        //Pairs of conjugate edges get odd and fractional weights as well
+        EdgeId e2 = (i % 5 == 0) ? gp.g.conjugate(e1) : edges[rand() % edges.size()];
+        //Values are exact in the two digits of the text format
+        float d = float(rand() % 2000) - 500, w = float(1 + rand() % 20) / 4;
+        raw.Add(e1, e2, omnigraph::de::RawPoint(d, w));
+        gp.clustered_indices[0].Add(e1, e2, omnigraph::de::Point(d, w, float(rand() % 8) / 2));
+    }
+    gp.paired_indices[0].Assign(raw);
+    BOOST_REQUIRE(gp.paired_indices[0].size() > 0);
+
+    graphio::PrintAll("tmp/binary", gp);
+    graphio::PrintAll("tmp/text", gp, /*text_export*/ true);
+    for (const char *ext : { "_0.prdb", "_0_cl.prdb", "_0_scf.prdb" })
+        std::remove(("tmp/text" + std::string(ext)).c_str());
+    BOOST_CHECK(!fs::FileExists("tmp/binary_0.prd"));
+
+    conj_graph_pack binary_gp(55, "tmp", 1), text_gp(55, "tmp", 1);
+    graphio::ScanAll("tmp/binary", binary_gp);
+    graphio::ScanAll("tmp/text", text_gp);
+
+    //Binary saves are exact
+    BOOST_CHECK(PairedInfoByIds(binary_gp.g, binary_gp.paired_indices[0]) ==
+                PairedInfoByIds(gp.g, gp.paired_indices[0]));
+    BOOST_CHECK(PairedInfoByIds(binary_gp.g, binary_gp.clustered_indices[0]) ==
+                PairedInfoByIds(gp.g, gp.clustered_indices[0]));
+
+    BOOST_CHECK(PairedInfoByIds(text_gp.g, text_gp.paired_indices[0], /*skip_conjugate*/true) ==
+                PairedInfoByIds(gp.g, gp.paired_indices[0], /*skip_conjugate*/true));
+    BOOST_CHECK(PairedInfoByIds(text_gp.g, text_gp.clustered_indices[0], /*skip_conjugate*/true) ==
+                PairedInfoByIds(gp.g, gp.clustered_indices[0], /*skip_conjugate*/true));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
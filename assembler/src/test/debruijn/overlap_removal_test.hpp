@@ -652,6 +652,95 @@ BOOST_AUTO_TEST_CASE( TestOverlapWithMiddle ) {
                result_ids);
 }
 
+//Overlaps and covering paths are found in parallel, results should not depend on the thread number
+class ThreadNumGuard {
+    const int old_thread_num_;
+public:
+    explicit ThreadNumGuard(int thread_num) : old_thread_num_(omp_get_max_threads()) {
+        omp_set_num_threads(thread_num);
+    }
+
+    ~ThreadNumGuard() {
+        omp_set_num_threads(old_thread_num_);
+    }
+};
+
+BOOST_AUTO_TEST_CASE( TestParallelDeduplicationCoveringRemoved ) {
+    ThreadNumGuard guard(4);
+    Graph g(55);
+    GraphElementFinder<Graph> finder(g);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    //The first {1565} is covered by the second one and is removed,
+    //then the second one is covered by the removed path and has to be checked again
+    PathsInit path_ids = {
+            {17572, 1565},
+            {1565}, {1565}};
+
+    GraphCoverageMap cov_map(g);
+    PathContainer container;
+    FormPaths(g, finder, cov_map, container, path_ids);
+    Deduplicate(g, container, cov_map, /*min_edge_len*/0, /*max_diff*/0);
+
+    CheckPaths(g, finder, container, {{17572, 1565}});
+}
+
+BOOST_AUTO_TEST_CASE( TestParallelDeduplicationLastCopyKept ) {
+    ThreadNumGuard guard(4);
+    Graph g(55);
+    GraphElementFinder<Graph> finder(g);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    //All copies but the last are removed by the last one, which itself is covered
+    //only by removed copies and has to survive the recheck
+    PathsInit path_ids = {
+            {1565, 19391},
+            {1565, 19391},
+            {1565, 19391},
+            {1565, 19391}};
+
+    GraphCoverageMap cov_map(g);
+    PathContainer container;
+    FormPaths(g, finder, cov_map, container, path_ids);
+    Deduplicate(g, container, cov_map, /*min_edge_len*/0, /*max_diff*/0, /*equal_only*/true);
+
+    CheckPaths(g, finder, container, {{1565, 19391}});
+}
+
+BOOST_AUTO_TEST_CASE( TestParallelRepeatRetain ) {
+    ThreadNumGuard guard(4);
+    Graph g(55);
+    GraphElementFinder<Graph> finder(g);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    PathsInit path_ids = {
+            {17572, 1565},
+            {18066, 1565},
+            {18953, 20449, 20129},
+            {20385, 20449},
+            {20449, 2142}};
+
+    //The overlap of the second path is skipped, since its region on the first path is already marked,
+    //so one copy of 1565 is retained
+    PathsInit result_ids = {{18066, 1565}, {17572}, {1565},
+                            {18953, 20449, 20129}, {20385}, {20449}, {20449}, {2142}};
+
+    CheckPaths(g, finder,
+               RemoveOverlaps(g, finder, path_ids,
+                              /*min_edge_len*/0, /*max_diff*/0,
+                              /*end_start_only*/ false, /*retain one*/ true),
+               result_ids);
+
+    PathsInit cut_all_ids = {{17572}, {18066}, {1565}, {1565},
+                             {18953, 20449, 20129}, {20385}, {20449}, {20449}, {2142}};
+
+    CheckPaths(g, finder,
+               RemoveOverlaps(g, finder, path_ids,
+                              /*min_edge_len*/0, /*max_diff*/0,
+                              /*end_start_only*/ false, /*retain one*/ false),
+               cut_all_ids);
+}
+
 //TODO add more tricky tests on whole the process
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include "paired_info/paired_info_helpers.hpp"
+#include "paired_info/sharded_pair_info_buffer.hpp"
 
 namespace debruijn_graph {
 
@@ -44,6 +45,21 @@ public:
         return id;
     }
 
+    class EdgeIterator {
+        std::map<EdgeId, EdgeId>::const_iterator it_, end_;
+    public:
+        EdgeIterator(std::map<EdgeId, EdgeId>::const_iterator it, std::map<EdgeId, EdgeId>::const_iterator end)
+                : it_(it), end_(end) {}
+
+        bool IsEnd() const { return it_ == end_; }
+        EdgeId operator*() const { return it_->first; }
+        EdgeIterator &operator++() { ++it_; return *this; }
+    };
+
+    EdgeIterator ConstEdgeBegin() const {
+        return EdgeIterator(conjs_.begin(), conjs_.end());
+    }
+
 private:
     std::map<EdgeId, EdgeId> conjs_;
     std::map<EdgeId, int> lengths_;
@@ -435,6 +451,128 @@ BOOST_AUTO_TEST_CASE(PairedInfoPairTraverse) {
     BOOST_CHECK_EQUAL(GetEdgePairInfo(pi), test1);
 }
 
+BOOST_AUTO_TEST_CASE(PairedInfoFrozen) {
+    MockGraph graph;
+    MockIndex pi(graph);
+    pi.Add(1, 3, {10, 1});
+    pi.Add(1, 3, {11, 2});
+    pi.Add(1, 9, {20, 1});
+    pi.Add(1, 1, {0, 1});
+    pi.Add(2, 4, {10, 1});
+    pi.Add(3, 13, {5, 3});
+    FrozenPairedInfoIndexT<MockGraph> fpi(graph);
+    fpi.Assign(pi);
+    BOOST_CHECK_EQUAL(fpi.size(), pi.size());
+    for (MockGraph::EdgeId e : {1, 2, 3, 4, 5, 7, 8, 9, 13, 14}) {
+        BOOST_CHECK_EQUAL(GetNeighbours(fpi, e), GetNeighbours(pi, e));
+        EdgeSet half;
+        for (auto i : fpi.GetHalf(e))
+            half.insert(i.first);
+        BOOST_CHECK_EQUAL(half, GetHalfNeighbours(pi, e));
+        for (auto i : pi.Get(e)) {
+            auto hist = fpi.Get(e, i.first);
+            BOOST_CHECK(std::equal(hist.begin(), hist.end(), i.second.begin()));
+            BOOST_CHECK_EQUAL(hist.size(), i.second.size());
+        }
+    }
+    BOOST_CHECK(fpi.contains(14));
+    BOOST_CHECK(fpi.contains(4, 2));
+    BOOST_CHECK(!fpi.contains(1, 4));
+    BOOST_CHECK(fpi.Get(5, 7).empty());
+    fpi.clear();
+    BOOST_CHECK_EQUAL(fpi.size(), 0);
+    BOOST_CHECK(fpi.Get(1).empty());
+}
+
+BOOST_AUTO_TEST_CASE(PairedInfoSharded) {
+    MockGraph graph;
+    MockIndex pi(graph);
+    ShardedPairedInfoBuffer<MockGraph> buffer(graph, 2);
+    EdgeData data[] = {{1, 3, 10}, {1, 3, 10}, {1, 3, 11}, {4, 2, 12}, {1, 9, 20},
+                       {1, 1, 0}, {1, 2, 5}, {3, 13, 5}, {14, 4, 7}};
+    size_t thread = 0;
+    for (const auto &d : data) {
+        pi.Add(d.f, d.s, {d.d, 1});
+        buffer.Add(thread, d.f, d.s, {d.d, 1});
+        thread = 1 - thread;
+        buffer.Flush(thread);
+    }
+    FrozenPairedInfoIndexT<MockGraph> fpi(graph);
+    buffer.MoveTo(fpi);
+    BOOST_CHECK_EQUAL(fpi.size(), pi.size());
+    for (MockGraph::EdgeId e : {1, 2, 3, 4, 5, 7, 8, 9, 13, 14}) {
+        BOOST_CHECK_EQUAL(GetNeighbours(fpi, e), GetNeighbours(pi, e));
+        for (auto i : pi.Get(e)) {
+            auto hist = fpi.Get(e, i.first);
+            BOOST_CHECK_EQUAL(hist.size(), i.second.size());
+            BOOST_CHECK(std::equal(hist.begin(), hist.end(), i.second.begin(),
+                                   [](RawPoint a, RawPoint b) { return a == b && math::eq(a.weight, b.weight); }));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PairedInfoShardedManyRuns) {
+    MockGraph graph;
+    MockIndex pi(graph);
+    ShardedPairedInfoBuffer<MockGraph> buffer(graph, 2);
+    EdgeData data[] = {{1, 3, 10}, {1, 3, 11}, {4, 2, 12}, {1, 9, 20}, {3, 13, 5}};
+    //every flush adds a run of its own size to the shards, so runs of different sizes are merged
+    for (size_t round = 0; round < 100; ++round) {
+        for (size_t i = 0; i <= round % 5; ++i) {
+            const auto &d = data[(round + i) % 5];
+            float d_shift = float(round % 7);
+            pi.Add(d.f, d.s, {d.d + d_shift, 1});
+            buffer.Add(round % 2, d.f, d.s, {d.d + d_shift, 1});
+        }
+        buffer.Flush(round % 2);
+    }
+    FrozenPairedInfoIndexT<MockGraph> fpi(graph);
+    buffer.MoveTo(fpi);
+    BOOST_CHECK_EQUAL(fpi.size(), pi.size());
+    for (MockGraph::EdgeId e : {1, 2, 3, 4, 5, 7, 8, 9, 13, 14}) {
+        BOOST_CHECK_EQUAL(GetNeighbours(fpi, e), GetNeighbours(pi, e));
+        for (auto i : pi.Get(e)) {
+            auto hist = fpi.Get(e, i.first);
+            BOOST_CHECK_EQUAL(hist.size(), i.second.size());
+            BOOST_CHECK(std::equal(hist.begin(), hist.end(), i.second.begin(),
+                                   [](RawPoint a, RawPoint b) { return a == b && math::eq(a.weight, b.weight); }));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PairedInfoShardedConcurrentFlushes) {
+    MockGraph graph;
+    MockIndex pi(graph);
+    EdgeData data[] = {{1, 3, 10}, {1, 3, 11}, {4, 2, 12}, {1, 9, 20}, {3, 13, 5}, {1, 1, 0}, {14, 4, 7}};
+    for (size_t i = 0; i < 4000; ++i) {
+        const auto &d = data[i % 7];
+        pi.Add(d.f, d.s, {d.d + float(i % 13), 1});
+    }
+
+    //threads add and flush at the same time
+    ShardedPairedInfoBuffer<MockGraph> buffer(graph, 4);
+    #pragma omp parallel for num_threads(4) schedule(static, 1)
+    for (size_t i = 0; i < 4000; ++i) {
+        const auto &d = data[i % 7];
+        size_t thread = omp_get_thread_num();
+        buffer.Add(thread, d.f, d.s, {d.d + float(i % 13), 1});
+        if (buffer.size(thread) >= 10)
+            buffer.Flush(thread);
+    }
+    FrozenPairedInfoIndexT<MockGraph> fpi(graph);
+    buffer.MoveTo(fpi);
+    BOOST_CHECK_EQUAL(fpi.size(), pi.size());
+    for (MockGraph::EdgeId e : {1, 2, 3, 4, 5, 7, 8, 9, 13, 14}) {
+        BOOST_CHECK_EQUAL(GetNeighbours(fpi, e), GetNeighbours(pi, e));
+        for (auto i : pi.Get(e)) {
+            auto hist = fpi.Get(e, i.first);
+            BOOST_CHECK_EQUAL(hist.size(), i.second.size());
+            BOOST_CHECK(std::equal(hist.begin(), hist.end(), i.second.begin(),
+                                   [](RawPoint a, RawPoint b) { return a == b && math::eq(a.weight, b.weight); }));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -20,6 +20,10 @@
 #include "test_utils.hpp"
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "modules/path_extend/pe_resolver.hpp"
+#include "modules/path_extend/weight_counter.hpp"
+
+#include <random>
 namespace path_extend {
 
 BOOST_FIXTURE_TEST_SUITE(path_extend_basic, fs::TmpFolderFixture)
@@ -764,6 +768,274 @@ BOOST_AUTO_TEST_CASE( BidirectionalPathLoopDetector ) {
     BOOST_CHECK_EQUAL(path1.Back(), e7);
 }
 
+void CheckCoveringPaths(const CoveringPaths &paths, const BidirectionalPathMultiset &expected) {
+    BOOST_REQUIRE_EQUAL(paths.size(), expected.size());
+    BOOST_CHECK_EQUAL(paths.empty(), expected.empty());
+    BOOST_CHECK(std::equal(paths.begin(), paths.end(), expected.begin()));
+    for (auto path : expected)
+        BOOST_CHECK_EQUAL(paths.count(path), expected.count(path));
+}
+
+BOOST_AUTO_TEST_CASE( CoveringPathsAgreesWithMultiset ) {
+    Graph g(13);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g);
+    EdgeId e = *g.ConstEdgeBegin();
+    std::vector<std::unique_ptr<BidirectionalPath>> storage;
+    for (size_t i = 0; i < 6; ++i)
+        storage.emplace_back(new BidirectionalPath(g, e));
+
+    std::mt19937 rand(7);
+    CoveringPaths paths;
+    BidirectionalPathMultiset expected;
+    //Grows past the inline storage and shrinks back several times
+    for (size_t round = 0; round < 20; ++round) {
+        size_t target = rand() % 10;
+        while (expected.size() < target) {
+            BidirectionalPath *path = storage[rand() % storage.size()].get();
+            paths.insert(path);
+            expected.insert(path);
+            CheckCoveringPaths(paths, expected);
+        }
+        while (expected.size() > target) {
+            BidirectionalPath *path = storage[rand() % storage.size()].get();
+            auto it = expected.find(path);
+            BOOST_CHECK_EQUAL(paths.erase(path), it != expected.end());
+            if (it != expected.end())
+                expected.erase(it);
+            CheckCoveringPaths(paths, expected);
+        }
+    }
+
+    CoveringPaths moved(std::move(paths));
+    CheckCoveringPaths(moved, expected);
+    CheckCoveringPaths(paths, BidirectionalPathMultiset());
+}
+
+BOOST_AUTO_TEST_CASE( ConcurrentCoverageMapUpdates ) {
+    Graph g(55);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+    std::vector<EdgeId> edges;
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+
+    //Random walks, so that edges are covered by many paths, some of them several times
+    std::mt19937 rand(11);
+    std::vector<std::unique_ptr<BidirectionalPath>> paths;
+    for (size_t i = 0; i < 400; ++i) {
+        paths.emplace_back(new BidirectionalPath(g, edges[rand() % edges.size()]));
+        BidirectionalPath &path = *paths.back();
+        for (size_t len = rand() % 20; len > 0; --len) {
+            std::vector<EdgeId> out;
+            utils::push_back_all(out, g.OutgoingEdges(g.EdgeEnd(path.Back())));
+            if (out.empty())
+                break;
+            path.PushBack(out[rand() % out.size()]);
+        }
+    }
+    std::vector<size_t> pop_counts;
+    for (const auto &path : paths)
+        pop_counts.push_back(rand() % (path->Size() + 1));
+
+    GraphCoverageMap concurrent_map(g, /*concurrent*/true);
+    #pragma omp parallel for num_threads(4) schedule(dynamic, 1)
+    for (size_t i = 0; i < paths.size(); ++i) {
+        concurrent_map.Subscribe(paths[i].get());
+        paths[i]->PopBack(pop_counts[i]);
+    }
+
+    GraphCoverageMap sequential_map(g);
+    for (const auto &path : paths)
+        sequential_map.Subscribe(path.get());
+
+    for (EdgeId e : edges) {
+        auto concurrent_paths = concurrent_map.GetEdgePaths(e), sequential_paths = sequential_map.GetEdgePaths(e);
+        BOOST_REQUIRE_EQUAL(concurrent_paths->size(), sequential_paths->size());
+        BOOST_CHECK(std::equal(concurrent_paths->begin(), concurrent_paths->end(), sequential_paths->begin()));
+    }
+}
+
+typedef omnigraph::de::PairedInfoIndexT<Graph> ClusteredIndex;
+
+//Counters with both basic and coverage aware ideal info, the latter shares the provider as extenders do
+std::vector<shared_ptr<WeightCounter>> MakeWeightCounters(const Graph &g, const shared_ptr<PairedInfoLibrary> &lib) {
+    auto provider = make_shared<CoverageAwareIdealInfoProvider>(g, lib, /*read_length*/100);
+    return {make_shared<ReadCountWeightCounter>(g, lib),
+            make_shared<ReadCountWeightCounter>(g, lib, /*normalize_weight*/true, provider),
+            make_shared<PathCoverWeightCounter>(g, lib, /*normalize_weight*/true, /*single_threshold*/0.3),
+            make_shared<PathCoverWeightCounter>(g, lib, /*normalize_weight*/true, /*single_threshold*/0.3, provider)};
+}
+
+//Cached counters are asked twice, so that the second answer comes from the cache;
+//counters without caching are created anew, so that nothing is reused between path states
+size_t CheckCachedPairedInfo(const Graph &g, const shared_ptr<PairedInfoLibrary> &lib,
+                             const std::vector<shared_ptr<WeightCounter>> &cached,
+                             const BidirectionalPath &path, const std::vector<EdgeId> &candidates) {
+    auto uncached = MakeWeightCounters(g, lib);
+    size_t positive = 0;
+    for (size_t i = 0; i < cached.size(); ++i) {
+        for (EdgeId e : candidates) {
+            for (int gap : {0, 150}) {
+                double weight = uncached[i]->CountWeight(path, e, std::set<size_t>(), gap);
+                std::set<size_t> exist = uncached[i]->PairInfoExist(path, e, gap);
+                for (size_t repeat = 0; repeat < 2; ++repeat) {
+                    BOOST_CHECK_EQUAL(cached[i]->CountWeight(path, e, std::set<size_t>(), gap), weight);
+                    BOOST_CHECK(cached[i]->PairInfoExist(path, e, gap) == exist);
+                }
+                if (math::gr(weight, 0.))
+                    ++positive;
+            }
+        }
+    }
+    return positive;
+}
+
+BOOST_AUTO_TEST_CASE( CachedPairedInfoFollowsPathChanges ) {
+    Graph g(55);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+    std::vector<EdgeId> edges;
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+
+    //The longest random walk out of several, paired info is put between its edges at their true distances
+    std::mt19937 rand(17);
+    std::vector<EdgeId> walk;
+    for (size_t attempt = 0; attempt < 100; ++attempt) {
+        std::vector<EdgeId> current(1, edges[rand() % edges.size()]);
+        while (current.size() < 16) {
+            std::vector<EdgeId> out;
+            utils::push_back_all(out, g.OutgoingEdges(g.EdgeEnd(current.back())));
+            if (out.empty())
+                break;
+            current.push_back(out[rand() % out.size()]);
+        }
+        if (current.size() > walk.size())
+            walk = current;
+    }
+    BOOST_REQUIRE(walk.size() >= 8);
+
+    ClusteredIndex index(g);
+    for (size_t i = 0; i < walk.size(); ++i) {
+        size_t dist = 0;
+        for (size_t j = i + 1; j < walk.size() && dist < 500; ++j) {
+            dist += g.length(walk[j - 1]);
+            if (walk[i] != walk[j])
+                index.Add(walk[i], walk[j], omnigraph::de::Point((float) dist, float(1 + rand() % 50), 10.));
+        }
+    }
+    BOOST_REQUIRE(index.size() > 0);
+    std::map<int, size_t> is_distribution = {{200, 1}, {250, 2}, {300, 4}, {350, 2}, {400, 1}};
+    auto lib = make_shared<PairedInfoLibraryWithIndex<ClusteredIndex>>(g.k(), g, /*read_size*/100, /*is*/300,
+                                                                      /*is_min*/200, /*is_max*/400, /*is_var*/50.,
+                                                                      index, /*is_mp*/false, is_distribution);
+    auto cached = MakeWeightCounters(g, lib);
+    for (const auto &counter : cached)
+        counter->CachePairedInfo();
+
+    size_t positive = 0;
+    //The same path object is changed at both ends, so only its version tells the states apart;
+    //its front grows as the back of the conjugate path does
+    size_t start = walk.size() / 2;
+    BidirectionalPath path(g), conjugate_path(g);
+    path.Subscribe(&conjugate_path);
+    conjugate_path.Subscribe(&path);
+    path.PushBack(walk[start]);
+    auto check = [&]() {
+        std::vector<EdgeId> candidates(walk.begin(), walk.end());
+        utils::push_back_all(candidates, g.OutgoingEdges(g.EdgeEnd(path.Back())));
+        positive += CheckCachedPairedInfo(g, lib, cached, path, candidates);
+    };
+    check();
+    for (size_t i = start + 1; i < walk.size(); ++i) {
+        path.PushBack(walk[i]);
+        check();
+    }
+    for (size_t i = 0; i < 3 && path.Size() > 1; ++i) {
+        path.PopBack();
+        check();
+    }
+    for (size_t i = start; i > 0; --i) {
+        conjugate_path.PushBack(g.conjugate(walk[i - 1]));
+        check();
+    }
+    for (size_t i = 1; i < path.Size(); i += 2) {
+        path.SetGapAt(i, Gap(100));
+        check();
+    }
+    path.PushBack(walk[path.Size()]);
+    check();
+    BOOST_CHECK(positive > 0);
+}
+
+//Greedily takes the longest candidate, so that grown paths overlap a lot
+class LongestEdgeExtensionChooser: public ExtensionChooser {
+public:
+    LongestEdgeExtensionChooser(const Graph& g): ExtensionChooser(g) {
+    }
+
+    EdgeContainer Filter(const BidirectionalPath& /*path*/, const EdgeContainer& edges) const override {
+        if (edges.empty())
+            return edges;
+        auto best = std::max_element(edges.begin(), edges.end(),
+                                     [this](const EdgeWithDistance& a, const EdgeWithDistance& b) {
+            return std::make_pair(g_.length(a.e_), g_.int_id(a.e_)) <
+                   std::make_pair(g_.length(b.e_), g_.int_id(b.e_));
+        });
+        return EdgeContainer(1, *best);
+    }
+};
+
+PathContainer GrowSeeds(const conj_graph_pack &gp, const ScaffoldingUniqueEdgeStorage &unique_storage,
+                        size_t thread_num, size_t &committed, size_t &regrown) {
+    auto make_extenders = [&gp](const GraphCoverageMap &cover_map, UsedUniqueStorage &used_storage) {
+        return CompositeExtender::Extenders{make_shared<SimpleExtender>(gp, cover_map, used_storage,
+                                                                        make_shared<LongestEdgeExtensionChooser>(gp.g),
+                                                                        /*is*/500, false, false)};
+    };
+
+    PathExtendResolver resolver(gp.g);
+    auto seeds = resolver.MakeSimpleSeeds();
+    seeds.SortByLength();
+    GraphCoverageMap cover_map(gp.g);
+    UsedUniqueStorage used_storage(unique_storage);
+    CompositeExtender composite_extender(gp.g, cover_map, used_storage,
+                                         make_extenders(cover_map, used_storage), /*max_diff_len*/0);
+    composite_extender.EnableParallelGrowth(thread_num, make_extenders);
+    auto paths = resolver.ExtendSeeds(seeds, composite_extender);
+    committed = composite_extender.CommittedSeeds();
+    regrown = composite_extender.RegrownSeeds();
+    return paths;
+}
+
+void CheckParallelGrowth(const conj_graph_pack &gp, const ScaffoldingUniqueEdgeStorage &unique_storage) {
+    size_t committed = 0, regrown = 0;
+    auto sequential = GrowSeeds(gp, unique_storage, 1, committed, regrown);
+    BOOST_CHECK(sequential.size() > 0);
+    for (size_t thread_num : {2, 4}) {
+        auto parallel = GrowSeeds(gp, unique_storage, thread_num, committed, regrown);
+        BOOST_REQUIRE_EQUAL(parallel.size(), sequential.size());
+        for (size_t i = 0; i < parallel.size(); ++i) {
+            BOOST_CHECK(*parallel.Get(i) == *sequential.Get(i));
+            BOOST_CHECK(*parallel.GetConjugate(i) == *sequential.GetConjugate(i));
+        }
+        //both the speculative and the sequential ways are taken
+        BOOST_CHECK(committed > 0);
+        BOOST_CHECK(regrown > 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ParallelGrowthAgreesWithSequential ) {
+    conj_graph_pack gp(55, "tmp", 0);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", gp.g);
+
+    ScaffoldingUniqueEdgeStorage no_unique_edges;
+    CheckParallelGrowth(gp, no_unique_edges);
+
+    //Seeds grown in parallel run into the same long edges, so speculative checks of used unique edges fail
+    ScaffoldingUniqueEdgeStorage unique_storage;
+    ScaffoldingUniqueEdgeAnalyzer(gp, /*length_cutoff*/500, /*max_relative_coverage*/0.5).FillUniqueEdgeStorage(unique_storage);
+    BOOST_REQUIRE(unique_storage.size() > 0);
+    CheckParallelGrowth(gp, unique_storage);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -312,7 +312,7 @@ void TestRelativeCoverageRemover(std::string path, size_t graph_size) {
     gp_t gp(55, "tmp", 0);
     graphio::ScanGraphPack(path, gp);
     INFO("Relative coverage component removal:");
-    if (!fs::FileExists(path + ".flcvr") && !fs::FileExists(path + ".kmidx")) {
+    if (!fs::FileExists(path + ".flcvr") && !fs::FileExists(path + ".kmidx") && !fs::FileExists(path + ".kmmph")) {
         FillKmerCoverageWithAvg(gp.g, gp.index.inner_index());
         gp.flanking_cov.Fill(gp.index.inner_index());
     }
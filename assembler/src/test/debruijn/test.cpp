@@ -15,11 +15,13 @@
 #include "debruijn_graph_test.hpp"
 #include "simplification_test.hpp"
 #include "order_and_law_test.hpp"
+#include "graphio_test.hpp"
 #include "path_extend_test.hpp"
 #include "overlap_removal_test.hpp"
 #include "overlap_analysis_test.hpp"
 //#include "detail_coverage_test.hpp"
 #include "paired_info_test.hpp"
+#include "binary_reads_test.hpp"
 //fixme why is it disabled
 //#include "pair_info_test.hpp"
 
@@ -169,9 +169,10 @@ typedef vector<PairInfo> PairInfos;
 
 template<class PairedIndex>
 void AssertPairInfo(const Graph& g, /*todo const */PairedIndex& paired_index, const EdgePairInfo& etalon_pair_info) {
-    for (auto i = omnigraph::de::pair_begin(paired_index); i != omnigraph::de::pair_end(paired_index); ++i) {
-      for (auto j : *i) {
-        PairInfo pair_info(i.first(), i.second(), j);
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+      for (auto i : paired_index.Get(*it))
+      for (auto j : i.second) {
+        PairInfo pair_info(*it, i.first, j);
         if (pair_info.first == pair_info.second && rounded_d(pair_info) == 0)
           continue;
 